@@ -0,0 +1,326 @@
+/**
+* Проверка кадров окна игры "пятнашки" на выделения памяти.
+*
+* Протягивает мышью COUNT элементов, рисуя кадры как окно: FramePool +
+* Renderer + FrameScheduler, окно время от времени меняет размер. Считает
+* выделения памяти (operator new) и требует, чтобы после разогрева их не
+* было.
+* # Отдельная утилита: замена глобальных operator new / delete действует
+*   на всю программу, а счётчик на каждом выделении не нужен остальным
+*   режимам puzzlen-sim.
+*
+* Запускается из консоли командой
+*   "puzzlen-allocations [N [M]] [--drags COUNT] [--seed S]"
+* Где N, M     - количество ячеек по ширине и высоте, [3; 10].
+*     --drags  - сколько элементов протянуть мышью.
+*     --seed   - зерно для поля и перетаскиваний; без него поле собрано.
+* Пример: puzzlen-allocations 10 --drags 10000 --seed 1
+*
+* @see configure.h для установки параметров.
+*/
+
+
+#include "include/stdafx.h"
+#include "include/FramePool.h"
+#include "include/FrameScheduler.h"
+#include "include/PuzzleN.h"
+#include "include/Renderer.h"
+#include <atomic>
+#include <new>
+
+
+namespace {
+
+
+// Счётчик выделений памяти. Порядок с другими потоками не нужен: в
+// проверке один поток.
+std::atomic< size_t >  allocationCount( 0 );
+
+
+} // namespace
+
+
+
+
+// # Заменяем глобальные operator new / delete: так видны все выделения,
+//   в т.ч. внутри std::vector.
+void* operator new( size_t size ) {
+
+    allocationCount.fetch_add( 1, std::memory_order_relaxed );
+    void* p = std::malloc( size ? size : 1 );
+    if ( !p ) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+
+
+
+void operator delete( void* p ) noexcept {
+
+    std::free( p );
+}
+
+
+
+
+namespace {
+
+
+struct options_t {
+    size_t  n;
+    size_t  m;
+    size_t  drags;
+    bool      seeded;
+    uint64_t  seed;
+};
+
+
+// Смещения для направлений PuzzleN::direction_t.
+static const int DIRECTION_DX[] = { 0,  0, -1,  1 };
+static const int DIRECTION_DY[] = { -1, 1,  0,  0 };
+
+
+// Разбирает параметры командной строки.
+options_t parse( int argc, char** argv );
+
+
+// Проверяет, что кадры после разогрева не выделяют памяти.
+// @return Код возврата для main().
+int allocations( const options_t& );
+
+
+} // namespace
+
+
+
+
+int main( int argc, char** argv ) {
+
+    using namespace puzzlen;
+
+    options_t  options;
+    try {
+        options = parse( argc, argv );
+
+    } catch ( const Exception& ex ) {
+        std::cerr << ex.what() << std::endl;
+        return -1;
+    }
+
+    return allocations( options );
+}
+
+
+
+
+namespace {
+
+
+options_t
+parse( int argc, char** argv ) {
+
+    using namespace puzzlen;
+
+    options_t  options;
+    options.n = DEFAULT_N;
+    options.m = DEFAULT_M;
+    options.drags = 10000;
+    options.seeded = false;
+    options.seed = 0;
+
+    size_t count = 0;
+    for (int k = 1; k < argc; ++k) {
+        const std::string  word = argv[ k ];
+        if ( (word.size() > 2) && (word.compare( 0, 2, "--" ) == 0) ) {
+            if (k + 1 >= argc) {
+                throw Exception( "Option " + word + " needs a value." );
+            }
+            std::istringstream  wss( argv[ ++k ] );
+            if (word == "--drags") {
+                wss >> options.drags;
+            } else if (word == "--seed") {
+                wss >> options.seed;
+                options.seeded = true;
+            } else {
+                throw Exception( "Unknown option " + word + "." );
+            }
+            if ( wss.fail() ) {
+                throw Exception( "Value of option " + word + " is not recognized." );
+            }
+            continue;
+        }
+
+        std::istringstream  wss( word );
+        switch ( count ) {
+            // ширина
+            case 0:
+                wss >> options.n;
+                if ( wss.fail() ) {
+                    throw Exception( "Width of puzzle is not recognized." );
+                }
+                if ( (options.n > 10) || (options.n < 3) ) {
+                    throw Exception( "Width of puzzle must have diapason [3; 10]." );
+                }
+                break;
+
+            // высота
+            case 1:
+                wss >> options.m;
+                if ( wss.fail() ) {
+                    throw Exception( "Height of puzzle is not recognized." );
+                }
+                if ( (options.m > 10) || (options.m < 3) ) {
+                    throw Exception( "Height must have diapason [3; 10]." );
+                }
+                break;
+
+            default:
+                throw Exception( "Too many parameters in command line." );
+        };
+        ++count;
+    }
+
+
+    if (count == 1) {
+        // # Допустимо не указывать высоту.
+        options.m = options.n;
+    }
+
+
+    return options;
+}
+
+
+
+
+int
+allocations( const options_t& options ) {
+
+    using namespace puzzlen;
+
+    // шагов мыши на одно перетаскивание
+    static const int STEPS = 8;
+    // перетаскиваний до замера: пул получает буферы всех размеров
+    static const size_t WARMUP = 16;
+    // каждое такое перетаскивание окно меняет размер
+    static const size_t RESIZE_EVERY = 100;
+
+    PuzzleN  puzzle( options.n, options.m, CELL_SIZE );
+    puzzle.reserveHistory( HISTORY_RESERVE );
+    if ( options.seeded ) {
+        puzzle.shuffle( options.seed );
+    }
+    const Renderer  renderer( puzzle );
+    FramePool  pool;
+    FrameScheduler  scheduler( puzzle );
+
+    // окно размером с поле и растянутое на ячейку вправо
+    const size_t width  = options.n * CELL_SIZE;
+    const size_t height = options.m * CELL_SIZE;
+    const size_t WIDTH[ 2 ]  = { width,  width + CELL_SIZE };
+    std::unique_ptr< Framebuffer >  full[ 2 ] = {
+        std::unique_ptr< Framebuffer >( new Framebuffer( WIDTH[ 0 ], height ) ),
+        std::unique_ptr< Framebuffer >( new Framebuffer( WIDTH[ 1 ], height ) )
+    };
+
+    size_t window = 0;
+    FrameScheduler::time_t now = 0;
+    size_t count = 0;
+    size_t staleCount = 0;
+    Framebuffer* last = nullptr;
+    size_t lastWindow = 0;
+    // Кадр, как его рисует Painter::draw().
+    const auto frame = [ & ] () {
+        now += FRAME_INTERVAL;
+        if (scheduler.event( now ) == FrameScheduler::NONE) {
+            return;
+        }
+        bool stale = false;
+        Framebuffer& back = pool.acquire( WIDTH[ window ], height, stale );
+        if ( stale ) {
+            renderer.drawAll( back );
+            ++staleCount;
+        } else {
+            renderer.draw( back, puzzle.damage() );
+        }
+        puzzle.clearDamage();
+        scheduler.presented( now, now );
+        last = &back;
+        lastWindow = window;
+        ++count;
+    };
+
+    Random  random( options.seed );
+    const int cs = static_cast< int >( CELL_SIZE );
+    const auto drag = [ & ] () {
+        // тянем соседа пустой ячейки на случайную долю ячейки
+        const int direction = static_cast< int >( random.below( 4 ) );
+        const int dx = DIRECTION_DX[ direction ];
+        const int dy = DIRECTION_DY[ direction ];
+        const PuzzleN::logicCoord_t elc = puzzle.ci( puzzle.emptyElement() );
+        const PuzzleN::logicCoord_t lc = { elc.x - dx,  elc.y - dy };
+        if ( !puzzle.inside( lc ) ) {
+            return;
+        }
+        const int distance = static_cast< int >( random.below( cs + 1 ) );
+        const int x = lc.x * cs + cs / 2;
+        const int y = lc.y * cs + cs / 2;
+        puzzle.pressMouseButton( true );
+        puzzle.firstClick( x, y );
+        for (int step = 1; step <= STEPS; ++step) {
+            puzzle.move(
+                x + dx * distance * step / STEPS,
+                y + dy * distance * step / STEPS
+            );
+            frame();
+        }
+        puzzle.pressMouseButton( false );
+        puzzle.stickMove();
+        puzzle.resetFirstClick();
+        frame();
+    };
+
+    for (size_t k = 0; k < WARMUP; ++k) {
+        window = k % 2;
+        drag();
+    }
+    const size_t warmup = allocationCount.load( std::memory_order_relaxed );
+    const size_t warmupFrames = count;
+
+    const size_t before = allocationCount.load( std::memory_order_relaxed );
+    for (size_t k = 0; k < options.drags; ++k) {
+        if (k % RESIZE_EVERY == 0) {
+            window = (k / RESIZE_EVERY) % 2;
+        }
+        drag();
+    }
+    const size_t steady = allocationCount.load( std::memory_order_relaxed ) - before;
+    const size_t frames = count - warmupFrames;
+
+    renderer.drawAll( *full[ lastWindow ] );
+    const bool equal = last && (*last == *full[ lastWindow ]);
+
+    std::cout <<
+        "board         " << options.n << " x " << options.m <<
+            " (" << width << " x " << height << " px)\n" <<
+        "frames        " << frames << " (redrawn whole " << staleCount << ")\n" <<
+        "back buffers  " << pool.created() << " (window sizes)\n" <<
+        "warm-up       " << warmup << " allocations in " << warmupFrames << " frames\n" <<
+        "steady state  " << steady << " allocations" << std::endl;
+
+    if ( !equal ) {
+        std::cerr << "Last frame differs from full redraw." << std::endl;
+        return -1;
+    }
+    if (steady > 0) {
+        std::cerr << "Frames allocate memory." << std::endl;
+        return -1;
+    }
+
+    return 0;
+}
+
+
+} // namespace
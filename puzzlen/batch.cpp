@@ -0,0 +1,409 @@
+/**
+* Пакетный решатель для игры "пятнашки".
+*
+* Читает поля по одному в строке и решает их оптимально (IDA*) на пуле
+* потоков: каждое поле ищется в одном потоке, потоки решают разные поля.
+* Результаты выводятся по мере готовности в формате JSON Lines, в порядке
+* входа:
+*   {"line":1,"length":22,"moves":"NWSE...","nodes":12345,"seconds":0.01}
+*   {"line":2,"error":"Puzzle is not solvable."}
+*
+* Запускается из консоли командой
+*   "puzzlen-batch [N [M]] [--input FILE] [--threads T] [--window W]
+*                  [--patterns FILE] [--bidirectional MB] [--heuristic NAME]"
+* Где N, M       - количество ячеек по ширине и высоте.
+*     --input    - файл с полями ('-' или без параметра - стандартный ввод).
+*                  Поле - элементы в порядке PuzzleN::field_t через пробел
+*                  или запятую, 0 - пустая ячейка. Пустые строки и строки,
+*                  начинающиеся с '#', пропускаются.
+*     --threads  - потоков, 0 - по количеству ядер.
+*     --window   - сколько полей может быть прочитано, но ещё не выведено;
+*                  0 - BATCH_WINDOW_PER_THREAD на поток. Чтение ждёт, пока
+*                  окно не освободится: память не растёт с размером входа.
+*     --patterns - базы шаблонов, построенные puzzlen-patterns.
+*     --heuristic - эвристика без баз шаблонов: conflict или walking.
+*     --bidirectional - двунаправленный поиск: периметр вокруг собранного
+*                  поля не больше MB мегабайт (см. Perimeter), общий для
+*                  всех потоков.
+* Итоги (полей, ошибок, полей/с, узлов/с) печатаются в stderr.
+* Пример: puzzlen-batch 4 --input boards.txt --threads 0 > solutions.jsonl
+*         echo "1 2 3 4 5 6 0 7 8" | puzzlen-batch 3
+*
+* @see configure.h для установки параметров.
+*/
+
+
+#include "include/stdafx.h"
+#include "include/Instrument.h"
+#include "include/PuzzleN.h"
+#include "include/Solver.h"
+#include "include/ThreadPool.h"
+#include <cstring>
+#include <fstream>
+#include <map>
+
+
+namespace {
+
+
+struct options_t {
+    size_t  n;
+    size_t  m;
+    std::string  input;
+    size_t  threads;
+    size_t  window;
+    std::string  patterns;
+    size_t  bidirectional;
+    puzzlen::Solver::heuristic_t  heuristic;
+};
+
+
+// Поля в работе: прочитаны, но ещё не выведены.
+// # Готовые результаты ждут в 'ready', пока не будут выведены все
+//   предыдущие: вывод идёт в порядке входа.
+struct stream_t {
+    std::mutex  mutex;
+    std::condition_variable  space;
+
+    size_t  inFlight;
+    // номер поля, которое выводится следующим
+    size_t  next;
+    std::map< size_t, std::string >  ready;
+
+    size_t  solved;
+    size_t  errors;
+    uint64_t  nodes;
+};
+
+
+// Разбирает параметры командной строки.
+options_t parse( int argc, char** argv );
+
+
+// Решает поле из строки 'text'.
+// @return Строка JSON с результатом или с ошибкой.
+std::string solveLine(
+    const options_t&,  const puzzlen::Solver&,
+    size_t line,  const std::string& text,
+    stream_t&
+);
+
+
+// Отдаёт результат поля 'index' и выводит готовые по порядку.
+void emit( stream_t&,  size_t index,  const std::string& json );
+
+
+// Проверяет решение, повторяя его ходы на поле.
+bool verify(
+    const options_t&,
+    const puzzlen::PuzzleN::field_t&,
+    const std::string& moves
+);
+
+
+// @return Строка в кавычках для JSON.
+std::string quote( const std::string& );
+
+
+} // namespace
+
+
+
+
+int main( int argc, char** argv ) {
+
+    using namespace puzzlen;
+
+    options_t  options;
+    std::ifstream  file;
+    try {
+        options = parse( argc, argv );
+        if ( !options.input.empty() && (options.input != "-") ) {
+            file.open( options.input.c_str() );
+            if ( !file ) {
+                throw Exception( "File " + options.input + " is not found." );
+            }
+        }
+    } catch ( const Exception& ex ) {
+        std::cerr << ex.what() << std::endl;
+        return -1;
+    }
+
+#ifdef PUZZLEN_INSTRUMENT
+    Instrument::reportAtExit( "" );
+#endif
+
+    std::istream& in = file.is_open() ? static_cast< std::istream& >( file ) : std::cin;
+    std::ios_base::sync_with_stdio( false );
+
+    try {
+        Solver  solver( options.n, options.m );
+        if ( !options.patterns.empty() ) {
+            solver.patterns( std::make_shared< const Patterns >( options.patterns ) );
+        }
+        solver.heuristic( options.heuristic );
+        solver.bidirectional( options.bidirectional << 20 );
+
+        // # Поля решаются целиком в одном потоке: для потока решений это
+        //   быстрее, чем делить дерево одного поля между потоками.
+        ThreadPool  pool( options.threads );
+        const size_t window = (options.window > 0) ?
+            options.window : (pool.size() * BATCH_WINDOW_PER_THREAD);
+
+        stream_t  stream;
+        stream.inFlight = 0;
+        stream.next   = 0;
+        stream.solved = 0;
+        stream.errors = 0;
+        stream.nodes  = 0;
+
+        const auto start = std::chrono::steady_clock::now();
+        size_t line = 0;
+        size_t index = 0;
+        std::string  text;
+        while ( std::getline( in, text ) ) {
+            ++line;
+            const size_t first = text.find_first_not_of( " \t\r" );
+            if ( (first == std::string::npos) || (text[ first ] == '#') ) {
+                continue;
+            }
+
+            // ждём, пока окно не освободится
+            {
+                std::unique_lock< std::mutex >  lock( stream.mutex );
+                stream.space.wait( lock, [ & ] () {
+                    return stream.inFlight < window;
+                } );
+                ++stream.inFlight;
+            }
+
+            const size_t k = index++;
+            pool.submit( [ &options, &solver, &stream, k, line, text ] ( size_t ) {
+                emit( stream,  k,  solveLine( options, solver, line, text, stream ) );
+            } );
+        }
+        pool.wait();
+        std::cout.flush();
+        const double seconds = std::chrono::duration< double >(
+            std::chrono::steady_clock::now() - start
+        ).count();
+
+        std::cerr <<
+            "board     " << options.n << " x " << options.m << "\n" <<
+            "threads   " << pool.size() << "\n" <<
+            "window    " << window << "\n" <<
+            "perimeter " << (solver.perimeter() ? solver.perimeter()->depth() : 0) << "\n" <<
+            "boards    " << index << "\n" <<
+            "solved    " << stream.solved << "\n" <<
+            "errors    " << stream.errors << "\n" <<
+            "time      " << seconds << " s\n" <<
+            "boards/s  " << ((seconds > 0.0) ? (index / seconds) : 0.0) << "\n" <<
+            "nodes/s   " << ((seconds > 0.0) ? (stream.nodes / seconds) : 0.0) << std::endl;
+
+        return (stream.errors == 0) ? 0 : -1;
+
+    } catch ( const Exception& ex ) {
+        std::cerr << ex.what() << std::endl;
+        return -1;
+    }
+}
+
+
+
+
+namespace {
+
+
+options_t
+parse( int argc, char** argv ) {
+
+    using namespace puzzlen;
+
+    options_t  options;
+    options.n = DEFAULT_N;
+    options.m = DEFAULT_M;
+    options.threads = 0;
+    options.window  = 0;
+    options.bidirectional = 0;
+    options.heuristic = Solver::CONFLICT;
+
+    size_t count = 0;
+    for (int k = 1; k < argc; ++k) {
+        const std::string  word = argv[ k ];
+        if ( (word.size() > 2) && (word.compare( 0, 2, "--" ) == 0) ) {
+            if (k + 1 >= argc) {
+                throw Exception( "Option " + word + " needs a value." );
+            }
+            std::istringstream  wss( argv[ ++k ] );
+            if (word == "--input") {
+                wss >> options.input;
+            } else if (word == "--threads") {
+                wss >> options.threads;
+            } else if (word == "--window") {
+                wss >> options.window;
+            } else if (word == "--patterns") {
+                wss >> options.patterns;
+            } else if (word == "--bidirectional") {
+                wss >> options.bidirectional;
+            } else if (word == "--heuristic") {
+                options.heuristic = Solver::heuristicByName( wss.str() );
+            } else {
+                throw Exception( "Unknown option " + word + "." );
+            }
+            if ( wss.fail() ) {
+                throw Exception( "Value of option " + word + " is not recognized." );
+            }
+            continue;
+        }
+
+        std::istringstream  wss( word );
+        switch ( count ) {
+            // ширина
+            case 0:
+                wss >> options.n;
+                if ( wss.fail() ) {
+                    throw Exception( "Width of puzzle is not recognized." );
+                }
+                if ( (options.n > 10) || (options.n < 3) ) {
+                    throw Exception( "Width of puzzle must have diapason [3; 10]." );
+                }
+                break;
+
+            // высота
+            case 1:
+                wss >> options.m;
+                if ( wss.fail() ) {
+                    throw Exception( "Height of puzzle is not recognized." );
+                }
+                if ( (options.m > 10) || (options.m < 3) ) {
+                    throw Exception( "Height must have diapason [3; 10]." );
+                }
+                break;
+
+            default:
+                throw Exception( "Too many parameters in command line." );
+        };
+        ++count;
+    }
+
+
+    if (count == 1) {
+        // # Допустимо не указывать высоту.
+        options.m = options.n;
+    }
+
+
+    return options;
+}
+
+
+
+
+std::string
+solveLine(
+    const options_t& options,  const puzzlen::Solver& solver,
+    size_t line,  const std::string& text,
+    stream_t& stream
+) {
+    using namespace puzzlen;
+
+    std::ostringstream  ss;
+    ss << "{\"line\":" << line << ",";
+    try {
+        const PuzzleN::field_t  board = PuzzleN::parseField( text );
+        if (board.size() != options.n * options.m) {
+            throw Exception( "Board does not match the size of puzzle." );
+        }
+        const auto r = solver.solve( board );
+        if ( !verify( options, board, r.moves ) ) {
+            throw Exception( "Solution is wrong." );
+        }
+        ss <<
+            "\"length\":" << r.moves.size() << "," <<
+            "\"moves\":" << quote( r.moves ) << "," <<
+            "\"nodes\":" << r.nodes << "," <<
+            "\"seconds\":" << r.seconds << "}";
+
+        std::lock_guard< std::mutex >  lock( stream.mutex );
+        ++stream.solved;
+        stream.nodes += r.nodes;
+
+    } catch ( const Exception& ex ) {
+        ss << "\"error\":" << quote( ex.what() ) << "}";
+
+        std::lock_guard< std::mutex >  lock( stream.mutex );
+        ++stream.errors;
+    }
+
+    return ss.str();
+}
+
+
+
+
+void
+emit( stream_t& stream,  size_t index,  const std::string& json ) {
+
+    std::lock_guard< std::mutex >  lock( stream.mutex );
+    stream.ready[ index ] = json;
+    size_t written = 0;
+    for (auto itr = stream.ready.begin();
+         (itr != stream.ready.end()) && (itr->first == stream.next);
+         itr = stream.ready.erase( itr )
+    ) {
+        std::cout << itr->second << '\n';
+        ++stream.next;
+        ++written;
+    }
+    if (written > 0) {
+        stream.inFlight -= written;
+        stream.space.notify_one();
+    }
+}
+
+
+
+
+bool
+verify(
+    const options_t& options,
+    const puzzlen::PuzzleN::field_t& board,
+    const std::string& moves
+) {
+    using namespace puzzlen;
+
+    PuzzleN  puzzle( options.n, options.m, CELL_SIZE );
+    puzzle.field( board );
+    for (auto itr = moves.cbegin(); itr != moves.cend(); ++itr) {
+        const char* d = std::strchr( PuzzleN::DIRECTION_NAME, *itr );
+        const auto direction = static_cast< PuzzleN::direction_t >(
+            d - PuzzleN::DIRECTION_NAME
+        );
+        if ( !puzzle.shift( direction ) ) {
+            return false;
+        }
+    }
+
+    return puzzle.solved();
+}
+
+
+
+
+std::string
+quote( const std::string& s ) {
+
+    std::string  r = "\"";
+    for (auto itr = s.cbegin(); itr != s.cend(); ++itr) {
+        if ( (*itr == '"') || (*itr == '\\') ) {
+            r += '\\';
+        }
+        r += *itr;
+    }
+    r += '"';
+
+    return r;
+}
+
+
+} // namespace
@@ -0,0 +1,629 @@
+/**
+* Микробенчмарки для игры "пятнашки".
+*
+* Замеряет горячие операции ядра на полях от K x K до L x L: запросы к
+* полю, перетаскивание мышью, ходы, тасование, сжатие состояния,
+* номера перестановок, эвристику и решатель. Результаты - JSON Lines, по строке на замер:
+*   {"bench":"shift","n":4,"m":4,"ops":33554432,"seconds":0.08,"ns_per_op":2.4}
+* Каждый замер повторяется BENCH_REPEATS раз, в строку идёт лучший.
+* # Ходы PuzzleN (shift, firstClick+move+stickMove) включают запись хода
+*   в историю (History) и областей перерисовки; Board::shift - без них.
+*   Результаты, снятые до истории ходов, с ними не сравнимы.
+*
+* Запускается из консоли командой
+*   "puzzlen-bench [--from K] [--to L] [--filter NAME] [--time MS]
+*                  [--baseline FILE] [--tolerance PCT]"
+* Где --from, --to - размеры полей, [3; 10].
+*     --filter     - только замеры, в имени которых есть NAME.
+*     --time       - время на один замер, мс.
+*     --baseline   - прошлые результаты (вывод puzzlen-bench). Замеры,
+*                    ставшие медленнее больше чем на PCT %, печатаются в
+*                    stderr, код возврата - ошибка.
+*     --tolerance  - допустимое замедление, %.
+* Пример: puzzlen-bench > bench.jsonl
+*         puzzlen-bench --from 4 --to 4 --filter shift
+*         puzzlen-bench --baseline bench.jsonl --tolerance 15
+*
+* @see configure.h для установки параметров.
+*/
+
+
+#include "include/stdafx.h"
+#include "include/Board.h"
+#include "include/CompactState.h"
+#include "include/Heuristic.h"
+#include "include/PuzzleN.h"
+#include "include/Ranking.h"
+#include "include/Solver.h"
+#include <fstream>
+#include <functional>
+#include <map>
+
+
+namespace {
+
+
+struct options_t {
+    size_t  from;
+    size_t  to;
+    std::string  filter;
+    double  seconds;
+    std::string  baseline;
+    double  tolerance;
+};
+
+
+// Замер: делает 'count' повторов операции.
+// @return Сколько операций сделано (для решателя - узлов).
+typedef std::function< uint64_t( size_t count ) >  kernel_t;
+
+
+typedef struct {
+    uint64_t  ops;
+    double  seconds;
+} sample_t;
+
+
+// Результаты замеров: "имя N x M" > нс на операцию.
+typedef std::map< std::string, double >  baseline_t;
+
+
+// Сюда замеры пишут контрольные суммы: компилятор не выбросит работу.
+volatile uint64_t  sink = 0;
+
+
+// Смещения для направлений PuzzleN::direction_t.
+static const int DIRECTION_DX[] = { 0,  0, -1,  1 };
+static const int DIRECTION_DY[] = { -1, 1,  0,  0 };
+
+
+// Разбирает параметры командной строки.
+options_t parse( int argc, char** argv );
+
+
+// @return Лучший из BENCH_REPEATS прогонов, каждый - около 'seconds' / BENCH_REPEATS.
+sample_t measure( const kernel_t&,  double seconds );
+
+
+// Замеры на поле N x M.
+// @return Сколько замеров стали медленнее базовых.
+size_t benchmark( const options_t&,  const baseline_t&,  size_t n,  size_t m );
+
+
+// @return Поле, перемешанное 'count' случайными ходами без возвратов.
+puzzlen::PuzzleN::field_t scramble( size_t n,  size_t m,  size_t count,  uint64_t seed );
+
+
+// Считывает прошлые результаты.
+baseline_t loadBaseline( const std::string& file );
+
+
+// @return Ключ замера для baseline_t.
+std::string key( const std::string& bench,  size_t n,  size_t m );
+
+
+} // namespace
+
+
+
+
+int main( int argc, char** argv ) {
+
+    using namespace puzzlen;
+
+    options_t  options;
+    baseline_t  baseline;
+    try {
+        options = parse( argc, argv );
+        if ( !options.baseline.empty() ) {
+            baseline = loadBaseline( options.baseline );
+        }
+    } catch ( const Exception& ex ) {
+        std::cerr << ex.what() << std::endl;
+        return -1;
+    }
+
+    size_t regressions = 0;
+    for (size_t k = options.from; k <= options.to; ++k) {
+        regressions += benchmark( options, baseline, k, k );
+    }
+
+    if (regressions > 0) {
+        std::cerr << regressions << " benchmarks are slower than baseline." << std::endl;
+        return -1;
+    }
+
+    return 0;
+}
+
+
+
+
+namespace {
+
+
+options_t
+parse( int argc, char** argv ) {
+
+    using namespace puzzlen;
+
+    options_t  options;
+    options.from = 3;
+    options.to   = 10;
+    options.seconds   = BENCH_TIME / 1000.0;
+    options.tolerance = 10.0;
+
+    for (int k = 1; k < argc; ++k) {
+        const std::string  word = argv[ k ];
+        if ( (word.size() <= 2) || (word.compare( 0, 2, "--" ) != 0) ) {
+            throw Exception( "Too many parameters in command line." );
+        }
+        if (k + 1 >= argc) {
+            throw Exception( "Option " + word + " needs a value." );
+        }
+        std::istringstream  wss( argv[ ++k ] );
+        if (word == "--from") {
+            wss >> options.from;
+        } else if (word == "--to") {
+            wss >> options.to;
+        } else if (word == "--filter") {
+            wss >> options.filter;
+        } else if (word == "--time") {
+            double ms = 0.0;
+            wss >> ms;
+            options.seconds = ms / 1000.0;
+        } else if (word == "--baseline") {
+            wss >> options.baseline;
+        } else if (word == "--tolerance") {
+            wss >> options.tolerance;
+        } else {
+            throw Exception( "Unknown option " + word + "." );
+        }
+        if ( wss.fail() ) {
+            throw Exception( "Value of option " + word + " is not recognized." );
+        }
+    }
+
+    if ( (options.from < 3) || (options.to > 10) || (options.from > options.to) ) {
+        throw Exception( "Sizes of puzzle must have diapason [3; 10]." );
+    }
+
+
+    return options;
+}
+
+
+
+
+sample_t
+measure( const kernel_t& kernel,  double seconds ) {
+
+    using namespace puzzlen;
+
+    const double target = seconds / BENCH_REPEATS;
+    const auto run = [ & ] ( size_t count ) -> sample_t {
+        const auto start = std::chrono::steady_clock::now();
+        const uint64_t ops = kernel( count );
+        const sample_t  s = {
+            ops,
+            std::chrono::duration< double >( std::chrono::steady_clock::now() - start ).count()
+        };
+        return s;
+    };
+
+    // подбираем количество повторов, чтобы прогон шёл около 'target'
+    size_t count = 1;
+    sample_t  best = run( count );
+    while ( (best.seconds < target) && (count < (size_t( 1 ) << 40)) ) {
+        const double grow = (best.seconds > 0.0) ? (1.2 * target / best.seconds) : 100.0;
+        count = static_cast< size_t >( count * std::min( std::max( grow, 2.0 ), 100.0 ) );
+        best = run( count );
+    }
+
+    for (size_t r = 1; r < BENCH_REPEATS; ++r) {
+        const sample_t  s = run( count );
+        if (s.seconds * best.ops < best.seconds * s.ops) {
+            best = s;
+        }
+    }
+
+    return best;
+}
+
+
+
+
+size_t
+benchmark(
+    const options_t& options,  const baseline_t& baseline,  size_t n,  size_t m
+) {
+    using namespace puzzlen;
+
+    const size_t cells = n * m;
+    const int cs = static_cast< int >( CELL_SIZE );
+    size_t regressions = 0;
+
+    const auto report = [ & ] ( const std::string& bench,  const kernel_t& kernel ) {
+        if ( !options.filter.empty() && (bench.find( options.filter ) == std::string::npos) ) {
+            return;
+        }
+        const sample_t  s = measure( kernel, options.seconds );
+        const double ns = (s.ops > 0) ? (s.seconds * 1e9 / s.ops) : 0.0;
+        std::cout <<
+            "{\"bench\":\"" << bench << "\"," <<
+            "\"n\":" << n << ",\"m\":" << m << "," <<
+            "\"ops\":" << s.ops << "," <<
+            "\"seconds\":" << s.seconds << "," <<
+            "\"ns_per_op\":" << ns << "}" << std::endl;
+
+        const auto itr = baseline.find( key( bench, n, m ) );
+        if ( (itr != baseline.cend()) && (ns > itr->second * (1.0 + options.tolerance / 100.0)) ) {
+            std::cerr <<
+                "slower  " << bench << " " << n << " x " << m << "  " <<
+                ns << " ns/op (baseline " << itr->second << ", +" <<
+                (100.0 * ns / itr->second - 100.0) << " %)" << std::endl;
+            ++regressions;
+        }
+    };
+
+    PuzzleN  puzzle( n, m, CELL_SIZE );
+    puzzle.shuffle( 1 );
+
+    report( "emptyElement", [ & ] ( size_t count ) -> uint64_t {
+        for (size_t k = 0; k < count; ++k) {
+            sink = puzzle.emptyElement();
+        }
+        return count;
+    } );
+
+    report( "permitShift", [ & ] ( size_t count ) -> uint64_t {
+        uint64_t sum = 0;
+        for (size_t k = 0; k < count; ++k) {
+            const auto ps = puzzle.permitShift( static_cast< int >( k % cells ) );
+            sum += ps.north + ps.south + ps.west + ps.east;
+        }
+        sink = sink + sum;
+        return count;
+    } );
+
+    // перетаскивание соседа пустой ячейки мышью: firstClick() > move() > stickMove()
+    // # С записью хода в историю и областей перерисовки.
+    report( "firstClick+move+stickMove", [ & ] ( size_t count ) -> uint64_t {
+        Random  random( 2 );
+        for (size_t k = 0; k < count; ) {
+            const int direction = static_cast< int >( random.below( 4 ) );
+            const int dx = DIRECTION_DX[ direction ];
+            const int dy = DIRECTION_DY[ direction ];
+            const PuzzleN::logicCoord_t elc = puzzle.ci( puzzle.emptyElement() );
+            const PuzzleN::logicCoord_t lc = { elc.x - dx,  elc.y - dy };
+            if ( !puzzle.inside( lc ) ) {
+                continue;
+            }
+            const int x = lc.x * cs + cs / 2;
+            const int y = lc.y * cs + cs / 2;
+            puzzle.pressMouseButton( true );
+            puzzle.firstClick( x, y );
+            puzzle.move( x + dx * cs / 2,  y + dy * cs / 2 );
+            puzzle.move( x + dx * cs,  y + dy * cs );
+            puzzle.pressMouseButton( false );
+            puzzle.stickMove();
+            puzzle.resetFirstClick();
+            puzzle.clearDamage();
+            ++k;
+        }
+        sink = sink + puzzle.emptyElement();
+        return count;
+    } );
+
+    // # С записью хода в историю: сравнивая с Board::shift, учитывайте.
+    report( "shift", [ & ] ( size_t count ) -> uint64_t {
+        Random  random( 3 );
+        for (size_t k = 0; k < count; ++k) {
+            puzzle.shift( static_cast< PuzzleN::direction_t >( random.below( 4 ) ) );
+        }
+        puzzle.clearDamage();
+        sink = sink + puzzle.emptyElement();
+        return count;
+    } );
+
+    withBoard( n, m, [ & ] ( auto board ) {
+        report( "Board::shift", [ & ] ( size_t count ) -> uint64_t {
+            Random  random( 3 );
+            for (size_t k = 0; k < count; ++k) {
+                board.shift( static_cast< PuzzleN::direction_t >( random.below( 4 ) ) );
+            }
+            sink = sink + board.emptyElement();
+            return count;
+        } );
+    } );
+
+    report( "shuffle", [ & ] ( size_t count ) -> uint64_t {
+        for (size_t k = 0; k < count; ++k) {
+            puzzle.shuffle( k );
+        }
+        puzzle.clearDamage();
+        sink = sink + puzzle.emptyElement();
+        return count;
+    } );
+
+    report( "createField", [ & ] ( size_t count ) -> uint64_t {
+        for (size_t k = 0; k < count; ++k) {
+            puzzle.createField();
+        }
+        puzzle.clearDamage();
+        sink = sink + puzzle.emptyElement();
+        return count;
+    } );
+
+    const Packing  packing( n, m );
+    PuzzleN::field_t  shuffled;
+    PuzzleN::shuffleBatch( shuffled, n, m, 4, 1 );
+    report( "CompactState::encode+decode", [ & ] ( size_t count ) -> uint64_t {
+        PuzzleN::field_t  field = shuffled;
+        CompactState100  state;
+        for (size_t k = 0; k < count; ++k) {
+            state.encode( field, packing );
+            state.decode( field, packing );
+        }
+        sink = sink + state.hash();
+        return count;
+    } );
+
+    // # Номера размещений - внутренний цикл построения таблиц: места
+    //   элементов шаблона и перестановки всего поля.
+    const size_t pattern = std::min( BENCH_RANKING_PATTERN, cells - 1 );
+    std::vector< int >  arrangements( BENCH_RANKING_INPUTS * cells );
+    std::vector< uint64_t >  ranks( BENCH_RANKING_INPUTS );
+    std::vector< uint64_t >  fieldRanks( BENCH_RANKING_INPUTS );
+    {
+        PuzzleN::field_t  fields;
+        PuzzleN::shuffleBatch( fields, n, m, 7, BENCH_RANKING_INPUTS );
+        for (size_t k = 0; k < BENCH_RANKING_INPUTS; ++k) {
+            for (size_t i = 0; i < cells; ++i) {
+                arrangements[ k * cells + fields[ k * cells + i ] ] = static_cast< int >( i );
+            }
+            ranks[ k ] = Ranking::rank( &arrangements[ k * cells ], pattern, cells );
+            if (cells <= Ranking::MAX_FIELD) {
+                fieldRanks[ k ] = Ranking::rank( &arrangements[ k * cells ], cells - 1, cells );
+            }
+        }
+    }
+    report( "Ranking::rank/pattern", [ & ] ( size_t count ) -> uint64_t {
+        uint64_t sum = 0;
+        for (size_t k = 0; k < count; ++k) {
+            const int* p = &arrangements[ (k % BENCH_RANKING_INPUTS) * cells ];
+            sum += Ranking::rank( p, pattern, cells );
+        }
+        sink = sink + sum;
+        return count;
+    } );
+    report( "Ranking::unrank/pattern", [ & ] ( size_t count ) -> uint64_t {
+        int positions[ Geometry::MAX_CELLS ];
+        uint64_t sum = 0;
+        for (size_t k = 0; k < count; ++k) {
+            Ranking::unrank( ranks[ k % BENCH_RANKING_INPUTS ], positions, pattern, cells );
+            sum += positions[ pattern - 1 ];
+        }
+        sink = sink + sum;
+        return count;
+    } );
+    if (cells <= Ranking::MAX_FIELD) {
+        report( "Ranking::rank/field", [ & ] ( size_t count ) -> uint64_t {
+            uint64_t sum = 0;
+            for (size_t k = 0; k < count; ++k) {
+                const int* p = &arrangements[ (k % BENCH_RANKING_INPUTS) * cells ];
+                sum += Ranking::rank( p, cells - 1, cells );
+            }
+            sink = sink + sum;
+            return count;
+        } );
+        report( "Ranking::unrank/field", [ & ] ( size_t count ) -> uint64_t {
+            int positions[ Geometry::MAX_CELLS ];
+            uint64_t sum = 0;
+            for (size_t k = 0; k < count; ++k) {
+                const uint64_t r = fieldRanks[ k % BENCH_RANKING_INPUTS ];
+                Ranking::unrank( r, positions, cells - 1, cells );
+                sum += positions[ cells - 2 ];
+            }
+            sink = sink + sum;
+            return count;
+        } );
+    }
+
+    const Geometry  geometry( n, m );
+    std::vector< uint8_t >  tiles( shuffled.cbegin(), shuffled.cend() );
+    report( "ConflictHeuristic::reset", [ & ] ( size_t count ) -> uint64_t {
+        ConflictHeuristic  h( geometry );
+        uint64_t sum = 0;
+        for (size_t k = 0; k < count; ++k) {
+            h.reset( tiles.data() );
+            sum += h.value();
+        }
+        sink = sink + sum;
+        return count;
+    } );
+
+    // ходы пустой ячейкой, как в узлах поиска
+    report( "ConflictHeuristic::shift", [ & ] ( size_t count ) -> uint64_t {
+        ConflictHeuristic  h( geometry );
+        h.reset( tiles.data() );
+        int blank = static_cast< int >(
+            std::find( tiles.cbegin(), tiles.cend(), 0 ) - tiles.cbegin()
+        );
+        Random  random( 5 );
+        uint64_t sum = 0;
+        for (size_t k = 0; k < count; ++k) {
+            const int from = geometry.source( blank, static_cast< int >( random.below( 4 ) ) );
+            if (from < 0) {
+                continue;
+            }
+            const int tile = tiles[ from ];
+            std::swap( tiles[ from ],  tiles[ blank ] );
+            h.shift( tiles.data(), tile, from, blank );
+            blank = from;
+            sum += h.value();
+        }
+        sink = sink + sum;
+        return count;
+    } );
+
+    // # Таблицы walking distance строятся не для всех размеров.
+    std::unique_ptr< Walking >  walking;
+    try {
+        walking = std::unique_ptr< Walking >( new Walking( geometry ) );
+    } catch ( const Exception& ) {
+    }
+    if ( walking ) {
+        report( "WalkingHeuristic::shift", [ & ] ( size_t count ) -> uint64_t {
+            WalkingHeuristic  h( *walking );
+            h.reset( tiles.data() );
+            int blank = static_cast< int >(
+                std::find( tiles.cbegin(), tiles.cend(), 0 ) - tiles.cbegin()
+            );
+            Random  random( 5 );
+            uint64_t sum = 0;
+            for (size_t k = 0; k < count; ++k) {
+                const int from = geometry.source( blank, static_cast< int >( random.below( 4 ) ) );
+                if (from < 0) {
+                    continue;
+                }
+                const int tile = tiles[ from ];
+                std::swap( tiles[ from ],  tiles[ blank ] );
+                h.shift( tiles.data(), tile, from, blank );
+                blank = from;
+                sum += h.value();
+            }
+            sink = sink + sum;
+            return count;
+        } );
+    }
+
+    // # Большие поля перемешаны немного, иначе их не решить.
+    std::vector< PuzzleN::field_t >  boards;
+    for (size_t k = 0; k < BENCH_SOLVE_BOARDS; ++k) {
+        if (cells <= 9) {
+            PuzzleN::field_t  f;
+            PuzzleN::shuffleBatch( f, n, m, 10 + k, 1 );
+            boards.push_back( f );
+        } else {
+            boards.push_back( scramble( n, m, BENCH_SOLVE_SCRAMBLE, 10 + k ) );
+        }
+    }
+    Solver  solver( n, m );
+    report( "Solver::solve/node", [ & ] ( size_t count ) -> uint64_t {
+        uint64_t nodes = 0;
+        for (size_t k = 0; k < count; ++k) {
+            const auto r = solver.solve( boards[ k % boards.size() ] );
+            nodes += r.nodes;
+            sink = sink + r.moves.size();
+        }
+        return nodes;
+    } );
+
+    // # Одни и те же поля одно- и двунаправленным поиском: ns_per_op -
+    //   время на поле.
+    const auto solveBoards = [ & ] ( size_t count ) -> uint64_t {
+        for (size_t k = 0; k < count; ++k) {
+            sink = sink + solver.solve( boards[ k % boards.size() ] ).moves.size();
+        }
+        return count;
+    };
+    report( "Solver::solve/board", solveBoards );
+    solver.bidirectional( BENCH_BIDIRECTIONAL_BUDGET );
+    report( "Solver::solve/bidirectional", solveBoards );
+    solver.bidirectional( 0 );
+    if ( walking ) {
+        solver.heuristic( Solver::WALKING );
+        report( "Solver::solve/walking", solveBoards );
+    }
+
+    return regressions;
+}
+
+
+
+
+puzzlen::PuzzleN::field_t
+scramble( size_t n,  size_t m,  size_t count,  uint64_t seed ) {
+
+    using namespace puzzlen;
+
+    PuzzleN  puzzle( n, m, CELL_SIZE );
+    Random  random( seed );
+    int last = -1;
+    for (size_t k = 0; k < count; ) {
+        const auto d = static_cast< PuzzleN::direction_t >( random.below( 4 ) );
+        if ( (last >= 0) && (d == PuzzleN::opposite( static_cast< PuzzleN::direction_t >( last ) )) ) {
+            continue;
+        }
+        if ( puzzle.shift( d ) ) {
+            last = d;
+            ++k;
+        }
+    }
+
+    return puzzle.field();
+}
+
+
+
+
+baseline_t
+loadBaseline( const std::string& file ) {
+
+    using namespace puzzlen;
+
+    std::ifstream  in( file.c_str() );
+    if ( !in ) {
+        throw Exception( "File " + file + " is not found." );
+    }
+
+    // # Разбираем только свой вывод: ключи всегда в одном порядке.
+    const auto value = [] ( const std::string& line,  const std::string& name ) -> std::string {
+        const std::string  mark = "\"" + name + "\":";
+        const size_t at = line.find( mark );
+        if (at == std::string::npos) {
+            throw Exception( "Baseline has no " + name + "." );
+        }
+        size_t begin = at + mark.size();
+        size_t end = 0;
+        if (line[ begin ] == '"') {
+            ++begin;
+            end = line.find( '"', begin );
+        } else {
+            end = line.find_first_of( ",}", begin );
+        }
+        return line.substr( begin, end - begin );
+    };
+
+    baseline_t  baseline;
+    std::string  line;
+    while ( std::getline( in, line ) ) {
+        if ( line.empty() ) {
+            continue;
+        }
+        size_t n = 0;
+        size_t m = 0;
+        double ns = 0.0;
+        std::istringstream( value( line, "n" ) ) >> n;
+        std::istringstream( value( line, "m" ) ) >> m;
+        std::istringstream( value( line, "ns_per_op" ) ) >> ns;
+        baseline[ key( value( line, "bench" ), n, m ) ] = ns;
+    }
+
+    return baseline;
+}
+
+
+
+
+std::string
+key( const std::string& bench,  size_t n,  size_t m ) {
+
+    std::ostringstream  ss;
+    ss << bench << " " << n << " x " << m;
+    return ss.str();
+}
+
+
+} // namespace
@@ -0,0 +1,264 @@
+/**
+* Перебирает все расстановки игры "пятнашки" поиском в ширину и считает,
+* сколько из них собирается ровно за d ходов.
+*
+* Запускается из консоли командой
+*   "puzzlen-enumerate [N [M]] [--threads T] [--counts FILE] [--table FILE]"
+* Где N, M      - количество ячеек по ширине и высоте: от 2, всего не
+*                 больше 12 ячеек (2 x 2 .. 2 x 6, 3 x 3, 3 x 4, 4 x 3).
+*     --threads - потоков перебора, по умолчанию по количеству ядер.
+*     --counts  - куда записать расстановки по глубине (строки "d count"),
+*                 по умолчанию "puzzlen-NxM.counts".
+*     --table   - сохранить расстояние каждой расстановки (см.
+*                 Enumerator.h): байт на расстановку, файл отображается
+*                 в память. Сохранённая таблица сразу загружается и
+*                 проверяется на случайных расстановках.
+* Пример: puzzlen-enumerate 3
+*         puzzlen-enumerate 4 3 --table puzzlen-4x3.dst
+*/
+
+
+#include "include/stdafx.h"
+#include "include/Enumerator.h"
+#include "include/Random.h"
+#include <fstream>
+#include <iomanip>
+
+
+namespace {
+
+
+struct options_t {
+    size_t  n;
+    size_t  m;
+    size_t  threads;
+    std::string  counts;
+    std::string  table;
+};
+
+
+// Сколько случайных расстановок проверять в загруженной таблице.
+static const size_t CHECK_STATES = 100000;
+
+
+// Разбирает параметры командной строки.
+options_t parse( int argc, char** argv );
+
+
+// Проверяет таблицу: номер - обратимый, у соседей расстановки расстояния
+// отличаются на 1 и хотя бы один сосед ближе к сборке.
+// @return Проверено расстановок.
+// @throw Exception При первой ошибке.
+size_t check( const puzzlen::Enumerator& );
+
+
+} // namespace
+
+
+
+
+int main( int argc, char** argv ) {
+
+    using namespace puzzlen;
+
+    try {
+        const options_t  options = parse( argc, argv );
+
+        const auto start = std::chrono::steady_clock::now();
+        const Enumerator  enumerator(
+            options.n, options.m, options.threads, !options.table.empty()
+        );
+        const double seconds = std::chrono::duration< double >(
+            std::chrono::steady_clock::now() - start
+        ).count();
+
+        std::ofstream  fs( options.counts.c_str(), std::ios::trunc );
+        if ( !fs.is_open() ) {
+            throw Exception( "File " + options.counts + " can not be created." );
+        }
+        const auto& counts = enumerator.counts();
+        for (size_t d = 0; d < counts.size(); ++d) {
+            fs << d << " " << counts[ d ] << "\n";
+        }
+        if ( !fs.good() ) {
+            throw Exception( "File " + options.counts + " can not be written." );
+        }
+
+        std::cout <<
+            "board     " << options.n << " x " << options.m << "\n" <<
+            "states    " << enumerator.states() << "\n" <<
+            "depth     " << enumerator.depth() << "\n" <<
+            "time      " << seconds << " s\n" <<
+            "states/s  " << enumerator.states() / seconds << "\n";
+        for (size_t d = 0; d < counts.size(); ++d) {
+            std::cout << std::setw( 5 ) << d << " " << counts[ d ] << "\n";
+        }
+        std::cout << "counts    " << options.counts << "\n";
+
+        if ( !options.table.empty() ) {
+            enumerator.save( options.table );
+            const auto loading = std::chrono::steady_clock::now();
+            const Enumerator  loaded( options.table );
+            const auto loaded_ = std::chrono::steady_clock::now();
+            if (loaded.counts() != counts) {
+                throw Exception( "Saved distance table does not match the enumeration." );
+            }
+            const size_t checked = check( loaded );
+            std::cout <<
+                "table     " << options.table << "\n" <<
+                "load      " << std::chrono::duration< double, std::milli >( loaded_ - loading ).count() << " ms\n" <<
+                "checked   " << checked << " states\n";
+        }
+        std::cout.flush();
+
+    } catch ( const Exception& ex ) {
+        std::cerr << ex.what() << std::endl;
+        return -1;
+    } catch ( const std::bad_alloc& ) {
+        std::cerr << "Not enough memory to enumerate the puzzle." << std::endl;
+        return -1;
+    }
+
+    return 0;
+}
+
+
+
+
+namespace {
+
+
+options_t
+parse( int argc, char** argv ) {
+
+    using namespace puzzlen;
+
+    options_t  options;
+    options.n = DEFAULT_N;
+    options.m = DEFAULT_M;
+    options.threads = 0;
+
+    size_t count = 0;
+    for (int k = 1; k < argc; ++k) {
+        const std::string  word = argv[ k ];
+        if ( (word.size() > 2) && (word.compare( 0, 2, "--" ) == 0) ) {
+            if (k + 1 >= argc) {
+                throw Exception( "Option " + word + " needs a value." );
+            }
+            std::istringstream  wss( argv[ ++k ] );
+            if (word == "--threads") {
+                wss >> options.threads;
+            } else if (word == "--counts") {
+                wss >> options.counts;
+            } else if (word == "--table") {
+                wss >> options.table;
+            } else {
+                throw Exception( "Unknown option " + word + "." );
+            }
+            if ( wss.fail() ) {
+                throw Exception( "Value of option " + word + " is not recognized." );
+            }
+            continue;
+        }
+
+        std::istringstream  wss( word );
+        switch ( count ) {
+            // ширина
+            case 0:
+                wss >> options.n;
+                if ( wss.fail() ) {
+                    throw Exception( "Width of puzzle is not recognized." );
+                }
+                if ( (options.n > 6) || (options.n < 2) ) {
+                    throw Exception( "Width of puzzle must have diapason [2; 6]." );
+                }
+                break;
+
+            // высота
+            case 1:
+                wss >> options.m;
+                if ( wss.fail() ) {
+                    throw Exception( "Height of puzzle is not recognized." );
+                }
+                if ( (options.m > 6) || (options.m < 2) ) {
+                    throw Exception( "Height must have diapason [2; 6]." );
+                }
+                break;
+
+            default:
+                throw Exception( "Too many parameters in command line." );
+        };
+        ++count;
+    }
+
+
+    if (count == 1) {
+        // # Допустимо не указывать высоту.
+        options.m = options.n;
+    }
+    if (count == 0) {
+        // # Поле по умолчанию 4 x 4 не перебрать: берём 3 x 3.
+        options.n = options.m = 3;
+    }
+
+    if ( options.counts.empty() ) {
+        std::ostringstream  ss;
+        ss << "puzzlen-" << options.n << "x" << options.m << ".counts";
+        options.counts = ss.str();
+    }
+
+
+    return options;
+}
+
+
+
+
+size_t
+check( const puzzlen::Enumerator& table ) {
+
+    using namespace puzzlen;
+
+    const Geometry  geometry( table.N, table.M );
+    std::vector< uint8_t >  tiles( geometry.cells );
+    Random  random( 1 );
+    const size_t count = static_cast< size_t >(
+        std::min( table.states(), static_cast< uint64_t >( CHECK_STATES ) )
+    );
+    for (size_t k = 0; k < count; ++k) {
+        // # Маленькую таблицу проверяем целиком.
+        const uint64_t r = (count == table.states()) ?
+            k : random.below( static_cast< uint32_t >( table.states() ) );
+        table.unrank( r, tiles.data() );
+        if (table.rank( tiles.data() ) != r) {
+            throw Exception( "Distance table: rank is not reversible." );
+        }
+
+        const int d = table.distance( r );
+        const int blank = static_cast< int >(
+            std::find( tiles.cbegin(), tiles.cend(), PuzzleN::EMPTY_ELEMENT ) - tiles.cbegin()
+        );
+        bool closer = (d == 0);
+        for (int dir = 0; dir < 4; ++dir) {
+            const int from = geometry.source( blank, dir );
+            if (from < 0) {
+                continue;
+            }
+            std::swap( tiles[ from ], tiles[ blank ] );
+            const int neighbour = table.distance( table.rank( tiles.data() ) );
+            std::swap( tiles[ from ], tiles[ blank ] );
+            if (std::abs( neighbour - d ) != 1) {
+                throw Exception( "Distance table: neighbours differ not by one move." );
+            }
+            closer = closer || (neighbour < d);
+        }
+        if ( !closer ) {
+            throw Exception( "Distance table: state has no neighbour closer to the goal." );
+        }
+    }
+
+    return count;
+}
+
+
+} // namespace
@@ -0,0 +1,420 @@
+/**
+* Генератор полей игры "пятнашки" заданной сложности: заполняет
+* гистограмму - сколько полей с каким кратчайшим решением - на всех ядрах.
+*
+* Запускается из консоли командой
+*   "puzzlen-generate [N [M]] --histogram SPEC [--seed S] [--threads T]
+*                     [--table FILE] [--distance MODE] [--patterns FILE]
+*                     [--heuristic NAME] [--out FILE]"
+* Где N, M        - количество ячеек по ширине и высоте, [2; 10].
+*     --histogram - корзины через запятую: "D:COUNT" - COUNT полей ровно
+*                   за D ходов, "LO-HI:COUNT" - от LO до HI ходов.
+*     --seed      - зерно: поле k зависит только от (seed, k).
+*     --threads   - потоков, по умолчанию по количеству ядер.
+*     --table     - таблица расстояний (puzzlen-enumerate --table): поля
+*                   на точном расстоянии. Для полей до 9 ячеек таблица
+*                   строится сама.
+*     --distance  - без таблицы: bound (по умолчанию) - расстояние в
+*                   границах корзины по обратному блужданию и эвристике,
+*                   exact - ещё и решить каждое поле (долго на 4 x 4).
+*     --patterns, --heuristic - эвристика для блужданий, как в
+*                   puzzlen-solve.
+*     --out       - куда записать поля, по одному в строке (формат
+*                   puzzlen-batch), по умолчанию "puzzlen-NxM.boards".
+* Поля в корзине не повторяются. Если разных полей в корзине меньше
+* COUNT (по таблице или после GENERATE_MAX_ATTEMPTS блужданий подряд
+* без нового поля), корзина исчерпана - ошибка.
+* На полях до 9 ячеек каждое поле сверяется с решателем.
+* Пример: puzzlen-generate 3 --histogram 10:100,20:100,31:2
+*         puzzlen-generate 4 --histogram 30-34:1000,40-44:1000
+*         puzzlen-generate 4 3 --histogram 53:10 --table puzzlen-4x3.dst
+*
+* @see configure.h для установки параметров.
+*/
+
+
+#include "include/stdafx.h"
+#include "include/Generator.h"
+#include "include/ThreadPool.h"
+#include <fstream>
+#include <iomanip>
+#include <set>
+
+
+namespace {
+
+
+// Корзина гистограммы.
+typedef struct {
+    int  lower;
+    int  upper;
+    size_t  count;
+} bin_t;
+
+
+struct options_t {
+    size_t  n;
+    size_t  m;
+    std::vector< bin_t >  histogram;
+    uint64_t  seed;
+    size_t  threads;
+    std::string  table;
+    bool  exact;
+    std::string  patterns;
+    puzzlen::Solver::heuristic_t  heuristic;
+    std::string  out;
+};
+
+
+// Разбирает параметры командной строки.
+options_t parse( int argc, char** argv );
+
+
+// @return Корзины из записи "D:COUNT,LO-HI:COUNT,...".
+// @throw Exception Если запись не распознана.
+std::vector< bin_t > parseHistogram( const std::string& );
+
+
+// @return Запись корзины: "D" или "LO-HI".
+std::string binName( const bin_t& );
+
+
+} // namespace
+
+
+
+
+int main( int argc, char** argv ) {
+
+    using namespace puzzlen;
+
+    try {
+        const options_t  options = parse( argc, argv );
+        const size_t cells = options.n * options.m;
+
+        Solver  solver( options.n, options.m );
+        if ( !options.patterns.empty() ) {
+            solver.patterns( std::make_shared< const Patterns >( options.patterns ) );
+        }
+        solver.heuristic( options.heuristic );
+
+        const auto start = std::chrono::steady_clock::now();
+        Generator  generator( solver );
+        generator.exact( options.exact );
+        std::string  source = options.exact ? "walk + solver" : "walk";
+        if ( !options.table.empty() ) {
+            generator.table( std::make_shared< const Enumerator >( options.table ) );
+            source = "table " + options.table;
+        } else if (cells <= GENERATE_TABLE_CELLS) {
+            generator.table( std::make_shared< const Enumerator >(
+                options.n, options.m, options.threads, true
+            ) );
+            source = "table";
+        }
+
+        // # В таблице известно, сколько в корзине разных полей.
+        if ( generator.table() ) {
+            const auto& counts = generator.table()->counts();
+            const int far = static_cast< int >( counts.size() ) - 1;
+            for (const auto& bin : options.histogram) {
+                uint64_t distinct = 0;
+                for (int d = bin.lower; d <= std::min( bin.upper, far ); ++d) {
+                    distinct += counts[ d ];
+                }
+                if (bin.count > distinct) {
+                    std::ostringstream  ss;
+                    ss << "Histogram bin " << binName( bin ) <<
+                        " is exhausted: " << distinct <<
+                        " distinct boards, " << bin.count << " requested.";
+                    throw Exception( ss.str() );
+                }
+            }
+        }
+
+        // # Поле k - своё зерно (seed, k): результат не зависит от потоков.
+        std::vector< size_t >  binOf;
+        for (size_t b = 0; b < options.histogram.size(); ++b) {
+            binOf.insert( binOf.end(), options.histogram[ b ].count, b );
+        }
+        std::vector< Generator::board_t >  boards( binOf.size() );
+        std::vector< std::string >  errors( binOf.size() );
+        ThreadPool  pool( options.threads );
+        for (size_t k = 0; k < boards.size(); ++k) {
+            pool.submit( [ &, k ] ( size_t ) {
+                const bin_t& bin = options.histogram[ binOf[ k ] ];
+                Random  random( options.seed, k );
+                try {
+                    boards[ k ] = generator.generate( bin.lower, bin.upper, random );
+                } catch ( const Exception& ex ) {
+                    errors[ k ] = ex.what();
+                }
+            } );
+        }
+        pool.wait();
+        for (const auto& e : errors) {
+            if ( !e.empty() ) {
+                throw Exception( e );
+            }
+        }
+
+        // # Поля в корзине не повторяются: повтор заменяется новым полем
+        //   по порядку полей - зёрна (seed, boards.size() + r), r - номер
+        //   замены, от потоков не зависят. Не больше GENERATE_MAX_ATTEMPTS
+        //   попыток на замену, иначе корзина исчерпана.
+        size_t repeats = 0;
+        uint64_t r = 0;
+        std::set< PuzzleN::field_t >  seen;
+        for (size_t k = 0; k < boards.size(); ++k) {
+            const bin_t& bin = options.histogram[ binOf[ k ] ];
+            if ( (k > 0) && (binOf[ k ] != binOf[ k - 1 ]) ) {
+                seen.clear();
+            }
+            uint64_t attempts = 0;
+            while ( !seen.insert( boards[ k ].field ).second ) {
+                if (++attempts > GENERATE_MAX_ATTEMPTS) {
+                    std::ostringstream  ss;
+                    ss << "Histogram bin " << binName( bin ) <<
+                        " is exhausted: " << seen.size() <<
+                        " distinct boards found, " << bin.count << " requested.";
+                    throw Exception( ss.str() );
+                }
+                Random  random( options.seed, boards.size() + r++ );
+                const uint64_t spent = boards[ k ].attempts;
+                boards[ k ] = generator.generate( bin.lower, bin.upper, random );
+                boards[ k ].attempts += spent;
+                ++repeats;
+            }
+        }
+        const double seconds = std::chrono::duration< double >(
+            std::chrono::steady_clock::now() - start
+        ).count();
+
+        // # Малые поля решаются быстро: сверяем каждое.
+        size_t checked = 0;
+        if (cells <= GENERATE_TABLE_CELLS) {
+            for (size_t k = 0; k < boards.size(); ++k) {
+                const int d = static_cast< int >( solver.solve( boards[ k ].field ).moves.size() );
+                if ( (d < boards[ k ].lower) || (d > boards[ k ].upper) ) {
+                    throw Exception( "Generated board is out of its distance bounds." );
+                }
+                ++checked;
+            }
+        }
+
+        std::ofstream  fs( options.out.c_str(), std::ios::trunc );
+        if ( !fs.is_open() ) {
+            throw Exception( "File " + options.out + " can not be created." );
+        }
+        for (const auto& board : boards) {
+            for (size_t i = 0; i < board.field.size(); ++i) {
+                fs << (i ? " " : "") << board.field[ i ];
+            }
+            fs << "\n";
+        }
+        if ( !fs.good() ) {
+            throw Exception( "File " + options.out + " can not be written." );
+        }
+
+        std::cout <<
+            "board     " << options.n << " x " << options.m << "\n" <<
+            "source    " << source << "\n" <<
+            "threads   " << pool.size() << "\n" <<
+            "boards    " << boards.size() << "\n" <<
+            "repeats   " << repeats << " (replaced)\n" <<
+            "time      " << seconds << " s\n" <<
+            "boards/s  " << ((seconds > 0.0) ? (boards.size() / seconds) : 0.0) << "\n" <<
+            "checked   " << checked << "\n";
+        std::cout <<
+            std::left << std::setw( 10 ) << "bin" << std::right <<
+            std::setw( 10 ) << "count" <<
+            std::setw( 12 ) << "attempts" <<
+            std::setw( 10 ) << "lower" <<
+            std::setw( 10 ) << "upper" <<
+            std::setw( 10 ) << "exact" << "\n";
+        std::cout << std::fixed << std::setprecision( 2 );
+        size_t k = 0;
+        for (const auto& bin : options.histogram) {
+            double attempts = 0.0;
+            double lower = 0.0;
+            double upper = 0.0;
+            size_t exact = 0;
+            for (size_t j = 0; j < bin.count; ++j, ++k) {
+                attempts += boards[ k ].attempts;
+                lower += boards[ k ].lower;
+                upper += boards[ k ].upper;
+                exact += (boards[ k ].lower == boards[ k ].upper) ? 1 : 0;
+            }
+            const double c = static_cast< double >( std::max( bin.count, size_t( 1 ) ) );
+            std::cout <<
+                std::left << std::setw( 10 ) << binName( bin ) << std::right <<
+                std::setw( 10 ) << bin.count <<
+                std::setw( 12 ) << (attempts / c) <<
+                std::setw( 10 ) << (lower / c) <<
+                std::setw( 10 ) << (upper / c) <<
+                std::setw( 10 ) << exact << "\n";
+        }
+        std::cout << std::defaultfloat;
+        std::cout << "out       " << options.out << std::endl;
+
+    } catch ( const Exception& ex ) {
+        std::cerr << ex.what() << std::endl;
+        return -1;
+    } catch ( const std::bad_alloc& ) {
+        std::cerr << "Not enough memory to generate the boards." << std::endl;
+        return -1;
+    }
+
+    return 0;
+}
+
+
+
+
+namespace {
+
+
+options_t
+parse( int argc, char** argv ) {
+
+    using namespace puzzlen;
+
+    options_t  options;
+    options.n = DEFAULT_N;
+    options.m = DEFAULT_M;
+    options.seed = 0;
+    options.threads = 0;
+    options.exact = false;
+    options.heuristic = Solver::CONFLICT;
+
+    size_t count = 0;
+    for (int k = 1; k < argc; ++k) {
+        const std::string  word = argv[ k ];
+        if ( (word.size() > 2) && (word.compare( 0, 2, "--" ) == 0) ) {
+            if (k + 1 >= argc) {
+                throw Exception( "Option " + word + " needs a value." );
+            }
+            std::istringstream  wss( argv[ ++k ] );
+            if (word == "--histogram") {
+                options.histogram = parseHistogram( wss.str() );
+            } else if (word == "--seed") {
+                wss >> options.seed;
+            } else if (word == "--threads") {
+                wss >> options.threads;
+            } else if (word == "--table") {
+                wss >> options.table;
+            } else if (word == "--distance") {
+                if ( (wss.str() != "bound") && (wss.str() != "exact") ) {
+                    throw Exception( "Distance must be bound or exact." );
+                }
+                options.exact = (wss.str() == "exact");
+            } else if (word == "--patterns") {
+                wss >> options.patterns;
+            } else if (word == "--heuristic") {
+                options.heuristic = Solver::heuristicByName( wss.str() );
+            } else if (word == "--out") {
+                wss >> options.out;
+            } else {
+                throw Exception( "Unknown option " + word + "." );
+            }
+            if ( wss.fail() ) {
+                throw Exception( "Value of option " + word + " is not recognized." );
+            }
+            continue;
+        }
+
+        std::istringstream  wss( word );
+        switch ( count ) {
+            // ширина
+            case 0:
+                wss >> options.n;
+                if ( wss.fail() ) {
+                    throw Exception( "Width of puzzle is not recognized." );
+                }
+                if ( (options.n > 10) || (options.n < 2) ) {
+                    throw Exception( "Width of puzzle must have diapason [2; 10]." );
+                }
+                break;
+
+            // высота
+            case 1:
+                wss >> options.m;
+                if ( wss.fail() ) {
+                    throw Exception( "Height of puzzle is not recognized." );
+                }
+                if ( (options.m > 10) || (options.m < 2) ) {
+                    throw Exception( "Height must have diapason [2; 10]." );
+                }
+                break;
+
+            default:
+                throw Exception( "Too many parameters in command line." );
+        };
+        ++count;
+    }
+
+
+    if (count == 1) {
+        // # Допустимо не указывать высоту.
+        options.m = options.n;
+    }
+
+    if ( options.histogram.empty() ) {
+        throw Exception( "Histogram of distances is not given (--histogram)." );
+    }
+
+    if ( options.out.empty() ) {
+        std::ostringstream  ss;
+        ss << "puzzlen-" << options.n << "x" << options.m << ".boards";
+        options.out = ss.str();
+    }
+
+
+    return options;
+}
+
+
+
+
+std::vector< bin_t >
+parseHistogram( const std::string& spec ) {
+
+    using namespace puzzlen;
+
+    std::vector< bin_t >  histogram;
+    std::istringstream  ss( spec );
+    std::string  item;
+    while ( std::getline( ss, item, ',' ) ) {
+        std::istringstream  is( item );
+        bin_t  bin;
+        char c = 0;
+        is >> bin.lower >> c;
+        bin.upper = bin.lower;
+        if (c == '-') {
+            is >> bin.upper >> c;
+        }
+        is >> bin.count;
+        if ( is.fail() || (c != ':') || (bin.lower < 0) || (bin.upper < bin.lower) ) {
+            throw Exception( "Histogram bin " + item + " is not recognized." );
+        }
+        histogram.push_back( bin );
+    }
+
+    return histogram;
+}
+
+
+
+
+std::string
+binName( const bin_t& bin ) {
+
+    std::ostringstream  name;
+    name << bin.lower;
+    if (bin.upper != bin.lower) {
+        name << "-" << bin.upper;
+    }
+    return name.str();
+}
+
+
+} // namespace
@@ -0,0 +1,123 @@
+/**
+* Сервер партий игры "пятнашки": тысячи полей, ходы по командам через
+* локальный UNIX-сокет (протокол - см. Host.h).
+*
+* Запускается из консоли командой
+*   "puzzlen-host [--socket FILE] [--shards S]"
+* Где --socket - путь UNIX-сокета, по умолчанию "puzzlen-host.sock".
+*     --shards - шардов партий (у каждого своя блокировка), по умолчанию
+*                SESSION_SHARDS.
+* Работает до SIGINT / SIGTERM, затем печатает время команд: сколько
+* выполнено, среднее, p50, p99, наибольшее.
+* Пример: puzzlen-host --socket /tmp/puzzlen.sock
+*         puzzlen-load --socket /tmp/puzzlen.sock --connections 8
+*/
+
+
+#include "include/stdafx.h"
+#include "include/Host.h"
+#include <csignal>
+
+
+namespace {
+
+
+struct options_t {
+    std::string  socket;
+    size_t  shards;
+};
+
+
+// Сервер для обработчика сигналов.
+puzzlen::Host*  hostPtr = nullptr;
+
+
+// Разбирает параметры командной строки.
+options_t parse( int argc, char** argv );
+
+
+extern "C" void onSignal( int ) {
+    if ( hostPtr ) {
+        hostPtr->stop();
+    }
+}
+
+
+} // namespace
+
+
+
+
+int main( int argc, char** argv ) {
+
+    using namespace puzzlen;
+
+    try {
+        const options_t  options = parse( argc, argv );
+
+        Sessions  sessions( options.shards );
+        Host  host( sessions, options.socket );
+        hostPtr = &host;
+        std::signal( SIGINT, onSignal );
+        std::signal( SIGTERM, onSignal );
+
+        std::cout <<
+            "socket    " << options.socket << "\n" <<
+            "shards    " << sessions.shards() << "\n";
+        std::cout.flush();
+
+        host.run();
+        hostPtr = nullptr;
+
+        std::cout << "sessions  " << sessions.size() << "\n";
+        host.report( std::cout );
+
+    } catch ( const Exception& ex ) {
+        std::cerr << ex.what() << std::endl;
+        return -1;
+    }
+
+    return 0;
+}
+
+
+
+
+namespace {
+
+
+options_t
+parse( int argc, char** argv ) {
+
+    using namespace puzzlen;
+
+    options_t  options;
+    options.socket = HOST_SOCKET;
+    options.shards = 0;
+
+    for (int k = 1; k < argc; ++k) {
+        const std::string  word = argv[ k ];
+        if ( (word.size() <= 2) || (word.compare( 0, 2, "--" ) != 0) ) {
+            throw Exception( "Too many parameters in command line." );
+        }
+        if (k + 1 >= argc) {
+            throw Exception( "Option " + word + " needs a value." );
+        }
+        std::istringstream  wss( argv[ ++k ] );
+        if (word == "--socket") {
+            wss >> options.socket;
+        } else if (word == "--shards") {
+            wss >> options.shards;
+        } else {
+            throw Exception( "Unknown option " + word + "." );
+        }
+        if ( wss.fail() ) {
+            throw Exception( "Value of option " + word + " is not recognized." );
+        }
+    }
+
+    return options;
+}
+
+
+} // namespace
@@ -0,0 +1,318 @@
+#pragma once
+
+#include "configure.h"
+#include "PuzzleN.h"
+#include <array>
+#include <utility>
+
+
+namespace puzzlen {
+
+
+// Функции для построения таблиц Board< N, M > при компиляции.
+// # Вынесены из Board: constexpr-функции класса нельзя вызывать в
+//   инициализаторах его же статических членов.
+template< size_t N, size_t M >
+struct BoardTables {
+    static constexpr bool inside( int x, int y ) {
+        return (x >= 0) && (x < static_cast< int >( N ))
+            && (y >= 0) && (y < static_cast< int >( M ));
+    }
+
+    static constexpr int ic( int x, int y ) {
+        return x + y * static_cast< int >( N );
+    }
+
+    static constexpr int column( size_t i ) {
+        return static_cast< int >( i % N );
+    }
+
+    static constexpr int row( size_t i ) {
+        return static_cast< int >( i / N );
+    }
+
+    // Смещения для направлений PuzzleN::direction_t.
+    static constexpr int dx( size_t d ) {
+        return (d == PuzzleN::WEST) ? -1 : ((d == PuzzleN::EAST) ? 1 : 0);
+    }
+
+    static constexpr int dy( size_t d ) {
+        return (d == PuzzleN::NORTH) ? -1 : ((d == PuzzleN::SOUTH) ? 1 : 0);
+    }
+
+    static constexpr int16_t cellAt( int x, int y ) {
+        return static_cast< int16_t >( inside( x, y ) ? ic( x, y ) : -1 );
+    }
+
+    // Соседняя ячейка в направлении 'd'.
+    static constexpr int16_t neighbour( size_t k ) {
+        return cellAt(
+            column( k / 4 ) + dx( k % 4 ),  row( k / 4 ) + dy( k % 4 )
+        );
+    }
+
+    // Ячейка, элемент из которой сдвигается в направлении 'd' в пустую.
+    static constexpr int16_t source( size_t k ) {
+        return cellAt(
+            column( k / 4 ) - dx( k % 4 ),  row( k / 4 ) - dy( k % 4 )
+        );
+    }
+
+    static constexpr uint8_t goal( size_t i ) {
+        return static_cast< uint8_t >(
+            (i + 1 == N * M) ? PuzzleN::EMPTY_ELEMENT : (i + 1)
+        );
+    }
+
+    template< size_t... K >
+    static constexpr std::array< int16_t, sizeof...( K ) >
+    neighbours( std::index_sequence< K... > ) {
+        return {{ neighbour( K )... }};
+    }
+
+    template< size_t... K >
+    static constexpr std::array< int16_t, sizeof...( K ) >
+    sources( std::index_sequence< K... > ) {
+        return {{ source( K )... }};
+    }
+
+    template< size_t... K >
+    static constexpr std::array< uint8_t, sizeof...( K ) >
+    goals( std::index_sequence< K... > ) {
+        return {{ goal( K )... }};
+    }
+};
+
+
+
+
+// Поле пятнашек с размерами, известными при компиляции.
+// # Ядро PuzzleN без мыши и визуализации: элементы, позиции элементов,
+//   ходы. Соседи и ходы берутся из constexpr-таблиц, координаты
+//   пересчитываются делением на константу - без проверок границ на
+//   каждом шаге. Элементы - байты в std::array, поле не выделяет памяти.
+// # Распространённые размеры (квадратные 3 x 3 .. 10 x 10 и небольшие
+//   3 x 4, 4 x 3, 3 x 5, 5 x 3, 2 x 6, 6 x 2) инстанцированы
+//   в Board.cpp; для прочих полей - PuzzleN (см. withBoard()).
+// # Таблицы ходов - того же вида, что у Geometry (source(), row(),
+//   column()): код ходов пишется шаблоном и работает с обоими.
+template< size_t N_, size_t M_ >
+class Board {
+public:
+    static constexpr size_t N = N_;
+    static constexpr size_t M = M_;
+    static constexpr size_t CELLS = N_ * M_;
+
+    static_assert( (N_ >= 2) && (M_ >= 2), "Board must be at least 2 x 2." );
+    static_assert( CELLS <= 256, "Elements of Board are stored in bytes." );
+
+    typedef uint8_t  element_t;
+    typedef std::array< element_t, CELLS >  field_t;
+
+    // Ячейки по направлениям: индекс - i * 4 + direction_t, -1 - за краем.
+    typedef std::array< int16_t, CELLS * 4 >  moves_t;
+
+    typedef BoardTables< N_, M_ >  tables_t;
+
+
+    // Сосед ячейки i в направлении d.
+    static constexpr moves_t  NEIGHBOUR =
+        tables_t::neighbours( std::make_index_sequence< CELLS * 4 >() );
+
+    // Ячейка, из которой элемент сдвигается в направлении d
+    // в пустую ячейку i.
+    static constexpr moves_t  SOURCE =
+        tables_t::sources( std::make_index_sequence< CELLS * 4 >() );
+
+    // Собранное поле.
+    static constexpr field_t  GOAL =
+        tables_t::goals( std::make_index_sequence< CELLS >() );
+
+
+public:
+    // Собранное поле.
+    Board() {
+        mField = GOAL;
+        indexPositions();
+    }
+
+
+    // @throw Exception Если 'field' - не перестановка элементов поля N x M.
+    explicit Board( const PuzzleN::field_t& field ) {
+        this->field( field );
+    }
+
+
+    // Расставляет элементы на поле.
+    // @throw Exception Если 'field' - не перестановка элементов поля N x M.
+    void field( const PuzzleN::field_t& field ) {
+        if (field.size() != CELLS) {
+            throw Exception( "Size of field does not match the puzzle." );
+        }
+        std::array< bool, CELLS >  seen;
+        seen.fill( false );
+        for (size_t i = 0; i < CELLS; ++i) {
+            if ((field[ i ] >= CELLS) || seen[ field[ i ] ]) {
+                throw Exception(
+                    "Field must be a permutation of the puzzle elements."
+                );
+            }
+            seen[ field[ i ] ] = true;
+            mField[ i ] = static_cast< element_t >( field[ i ] );
+        }
+        indexPositions();
+    }
+
+
+    // @return Элементы в виде PuzzleN::field_t.
+    PuzzleN::field_t field() const {
+        return PuzzleN::field_t( mField.cbegin(), mField.cend() );
+    }
+
+
+    inline field_t const& elements() const { return mField; }
+
+
+    inline element_t element( int i ) const { return mField[ i ]; }
+
+
+    // @return 1D-координата элемента.
+    inline int position( element_t element ) const {
+        return mPosition[ element ];
+    }
+
+
+    // @return 1D-координата пустого элемента.
+    inline int emptyElement() const {
+        return mPosition[ PuzzleN::EMPTY_ELEMENT ];
+    }
+
+
+    // Сдвигает в пустую ячейку соседний элемент в направлении 'direction'.
+    // @return Был ли ход возможен.
+    // @see PuzzleN::shift()
+    inline bool shift( PuzzleN::direction_t direction ) {
+        const int e = emptyElement();
+        const int from = SOURCE[ e * 4 + direction ];
+        if (from < 0) {
+            return false;
+        }
+        swapElement( from, e );
+        return true;
+    }
+
+
+    // @return Может ли элемент в ячейке 'i' сдвинуться в направлении 'd'.
+    inline bool movable( int i, PuzzleN::direction_t d ) const {
+        return NEIGHBOUR[ i * 4 + d ] == emptyElement();
+    }
+
+
+    // @return Поле собрано.
+    inline bool solved() const { return mField == GOAL; }
+
+
+    // @return Ячейка, из которой элемент сдвигается в пустую ячейку 'i'
+    //         в направлении 'd', или -1.
+    // @see Geometry::source()
+    static inline int source( int i, int d ) { return SOURCE[ i * 4 + d ]; }
+
+
+    static constexpr bool inside( int x, int y ) {
+        return tables_t::inside( x, y );
+    }
+
+    static constexpr int ic( int x, int y ) { return tables_t::ic( x, y ); }
+    static constexpr int column( int i )    { return tables_t::column( i ); }
+    static constexpr int row( int i )       { return tables_t::row( i ); }
+
+
+private:
+    inline void swapElement( int a, int b ) {
+        std::swap( mField[ a ], mField[ b ] );
+        mPosition[ mField[ a ] ] = static_cast< element_t >( a );
+        mPosition[ mField[ b ] ] = static_cast< element_t >( b );
+    }
+
+
+    inline void indexPositions() {
+        for (size_t i = 0; i < CELLS; ++i) {
+            mPosition[ mField[ i ] ] = static_cast< element_t >( i );
+        }
+    }
+
+
+private:
+    field_t  mField;
+    // позиции элементов, см. PuzzleN::positions_t
+    field_t  mPosition;
+};
+
+
+
+
+template< size_t N_, size_t M_ >
+constexpr typename Board< N_, M_ >::moves_t  Board< N_, M_ >::NEIGHBOUR;
+
+template< size_t N_, size_t M_ >
+constexpr typename Board< N_, M_ >::moves_t  Board< N_, M_ >::SOURCE;
+
+template< size_t N_, size_t M_ >
+constexpr typename Board< N_, M_ >::field_t  Board< N_, M_ >::GOAL;
+
+
+
+
+extern template class Board< 3, 3 >;
+extern template class Board< 4, 4 >;
+extern template class Board< 5, 5 >;
+extern template class Board< 6, 6 >;
+extern template class Board< 7, 7 >;
+extern template class Board< 8, 8 >;
+extern template class Board< 9, 9 >;
+extern template class Board< 10, 10 >;
+extern template class Board< 3, 4 >;
+extern template class Board< 4, 3 >;
+extern template class Board< 3, 5 >;
+extern template class Board< 5, 3 >;
+extern template class Board< 2, 6 >;
+extern template class Board< 6, 2 >;
+
+
+
+
+// Вызывает 'f' с собранным Board< n, m >, если этот размер инстанцирован.
+// # Так код, написанный один раз как шаблон (или обобщённая лямбда),
+//   получает для поля из командной строки версию с константами.
+// @return false, если размера нет: работайте с PuzzleN.
+template< class F >
+bool
+withBoard( size_t n,  size_t m,  F&& f ) {
+
+    if (n == m) {
+        switch ( n ) {
+            case 3:  f( Board< 3, 3 >() );    return true;
+            case 4:  f( Board< 4, 4 >() );    return true;
+            case 5:  f( Board< 5, 5 >() );    return true;
+            case 6:  f( Board< 6, 6 >() );    return true;
+            case 7:  f( Board< 7, 7 >() );    return true;
+            case 8:  f( Board< 8, 8 >() );    return true;
+            case 9:  f( Board< 9, 9 >() );    return true;
+            case 10: f( Board< 10, 10 >() );  return true;
+        }
+        return false;
+    }
+
+    // # Неквадратные - небольшие поля решателя и полного перебора.
+    if ( (n == 3) && (m == 4) ) { f( Board< 3, 4 >() );  return true; }
+    if ( (n == 4) && (m == 3) ) { f( Board< 4, 3 >() );  return true; }
+    if ( (n == 3) && (m == 5) ) { f( Board< 3, 5 >() );  return true; }
+    if ( (n == 5) && (m == 3) ) { f( Board< 5, 3 >() );  return true; }
+    if ( (n == 2) && (m == 6) ) { f( Board< 2, 6 >() );  return true; }
+    if ( (n == 6) && (m == 2) ) { f( Board< 6, 2 >() );  return true; }
+
+    return false;
+}
+
+
+} // puzzlen
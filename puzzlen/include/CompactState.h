@@ -0,0 +1,244 @@
+#pragma once
+
+#include "configure.h"
+#include "PuzzleN.h"
+#include <array>
+#include <functional>
+
+
+namespace puzzlen {
+
+
+// Упаковка поля N x M в биты: элемент занимает 'bits' бит, элементы идут
+// подряд по 1D-позициям и могут переходить через границу 64-битных слов.
+// # До 16 ячеек - 4 бита на элемент, всё поле в одном uint64_t (4 x 4 -
+//   ровно 64 бита). Для больших полей - наименьшее количество бит, в
+//   которое помещается номер элемента: 5 x 5 - 5 бит, 2 слова;
+//   10 x 10 - 7 бит, 11 слов.
+class Packing {
+public:
+    // @return Бит на элемент для поля из 'cells' ячеек.
+    static constexpr size_t bitsFor( size_t cells ) {
+        return (cells <= 16) ? 4 : width( cells - 1 );
+    }
+
+    // @return Слов на поле из 'cells' ячеек.
+    static constexpr size_t wordsFor( size_t cells ) {
+        return (cells * bitsFor( cells ) + 63) / 64;
+    }
+
+
+    // @return Хеш упакованного поля из 'words' слов.
+    // # Перемешивание fmix64 из MurmurHash3: близкие поля (один ход)
+    //   расходятся по всем битам хеша.
+    static inline uint64_t hash( const uint64_t* word,  size_t words ) {
+        uint64_t h = 0x9E3779B97F4A7C15ULL;
+        for (size_t k = 0; k < words; ++k) {
+            h = mix( h ^ word[ k ] );
+        }
+        return h;
+    }
+
+
+public:
+    Packing( size_t n, size_t m );
+
+
+    // @return Элемент ячейки 'i' из упакованных слов 'word'.
+    // # SPILL = false - поле в одном слове, элемент не переходит границу:
+    //   ветка исчезает при компиляции.
+    template< bool SPILL = true >
+    inline uint64_t get( const uint64_t* word,  size_t i ) const {
+        const size_t bit = i * bits;
+        const size_t w = bit >> 6;
+        const size_t o = bit & 63;
+        uint64_t v = word[ w ] >> o;
+        if ( SPILL && (o + bits > 64) ) {
+            v |= word[ w + 1 ] << (64 - o);
+        }
+        return v & mask;
+    }
+
+
+    // Ставит элемент 'e' в ячейку 'i' упакованных слов 'word'.
+    template< bool SPILL = true >
+    inline void set( uint64_t* word,  size_t i,  uint64_t e ) const {
+        DASSERT( e <= mask );
+        const size_t bit = i * bits;
+        const size_t w = bit >> 6;
+        const size_t o = bit & 63;
+        word[ w ] = (word[ w ] & ~(mask << o)) | (e << o);
+        if ( SPILL && (o + bits > 64) ) {
+            const size_t high = 64 - o;
+            word[ w + 1 ] = (word[ w + 1 ] & ~(mask >> high)) | (e >> high);
+        }
+    }
+
+
+    // Упаковывает 'cells' элементов в 'words' слов; неиспользуемые биты -
+    // нулевые.
+    template< bool SPILL = true,  class E >
+    inline void pack( const E* tiles,  uint64_t* word ) const {
+        std::fill( word,  word + words,  0 );
+        for (size_t i = 0; i < cells; ++i) {
+            set< SPILL >( word,  i,  static_cast< uint64_t >( tiles[ i ] ) );
+        }
+    }
+
+
+    // Обратное к pack().
+    template< bool SPILL = true,  class E >
+    inline void unpack( const uint64_t* word,  E* tiles ) const {
+        for (size_t i = 0; i < cells; ++i) {
+            tiles[ i ] = static_cast< E >( get< SPILL >( word, i ) );
+        }
+    }
+
+
+public:
+    const size_t  N;
+    const size_t  M;
+    const size_t  cells;
+    const size_t  bits;
+    const size_t  words;
+    const uint64_t  mask;
+
+
+private:
+    // @return Количество значащих бит в 'v'.
+    static constexpr size_t width( size_t v ) {
+        return (v == 0) ? 0 : (1 + width( v >> 1 ));
+    }
+
+    static inline uint64_t mix( uint64_t h ) {
+        h ^= h >> 33;
+        h *= 0xFF51AFD7ED558CCDULL;
+        h ^= h >> 33;
+        h *= 0xC4CEB9FE1A85EC53ULL;
+        h ^= h >> 33;
+        return h;
+    }
+};
+
+
+
+
+// Упакованное поле: WORDS слов по 64 бита, без выделения памяти.
+// # Слов должно хватать на поле: WORDS >= Packing::wordsFor( cells ).
+//   Поле до 16 ячеек - CompactState< 1 > (8 байт вместо 16 x 8 байт и
+//   вектора в куче для PuzzleN::field_t).
+// # Неиспользуемые биты нулевые, поэтому сравнение и хеш - по словам.
+template< size_t WORDS >
+class CompactState {
+public:
+    static const size_t  SIZE = WORDS;
+
+
+public:
+    inline CompactState() {
+        mWord.fill( 0 );
+    }
+
+
+    // @throw Exception Если поле не помещается в WORDS слов.
+    inline CompactState( const PuzzleN::field_t& field,  const Packing& packing ) {
+        encode( field, packing );
+    }
+
+
+    // Упаковывает поле.
+    // @throw Exception Если поле не помещается в WORDS слов.
+    inline void encode( const PuzzleN::field_t& field,  const Packing& packing ) {
+        if (packing.words > WORDS) {
+            throw Exception( "Puzzle is too large for the compact state." );
+        }
+        DASSERT( field.size() == packing.cells );
+        mWord.fill( 0 );
+        packing.pack< (WORDS > 1) >( field.data(), mWord.data() );
+    }
+
+
+    // Распаковывает поле.
+    inline void decode( PuzzleN::field_t& field,  const Packing& packing ) const {
+        field.resize( packing.cells );
+        packing.unpack< (WORDS > 1) >( mWord.data(), field.data() );
+    }
+
+    inline PuzzleN::field_t field( const Packing& packing ) const {
+        PuzzleN::field_t  f;
+        decode( f, packing );
+        return f;
+    }
+
+
+    // @return Элемент в ячейке 'i'.
+    // # В одном слове (до 16 ячеек по 4 бита) элементы не переходят
+    //   границу слов (см. Packing::get()).
+    inline PuzzleN::element_t get( size_t i,  const Packing& packing ) const {
+        return static_cast< PuzzleN::element_t >(
+            packing.get< (WORDS > 1) >( mWord.data(), i )
+        );
+    }
+
+
+    // Ставит элемент в ячейку 'i'.
+    inline void set( size_t i,  PuzzleN::element_t element,  const Packing& packing ) {
+        packing.set< (WORDS > 1) >( mWord.data(),  i,  static_cast< uint64_t >( element ) );
+    }
+
+
+    // Меняет местами элементы ячеек 'a' и 'b': ход пустой ячейкой.
+    inline void swap( size_t a,  size_t b,  const Packing& packing ) {
+        const PuzzleN::element_t ea = get( a, packing );
+        set( a, get( b, packing ), packing );
+        set( b, ea, packing );
+    }
+
+
+    inline bool operator==( const CompactState& b ) const { return mWord == b.mWord; }
+    inline bool operator!=( const CompactState& b ) const { return mWord != b.mWord; }
+    inline bool operator<( const CompactState& b ) const  { return mWord < b.mWord; }
+
+
+    // @return Хеш состояния.
+    // @see Packing::hash()
+    inline uint64_t hash() const {
+        return Packing::hash( mWord.data(), WORDS );
+    }
+
+
+    inline const uint64_t* data() const { return mWord.data(); }
+    inline uint64_t* data() { return mWord.data(); }
+
+
+private:
+    std::array< uint64_t, WORDS >  mWord;
+};
+
+
+
+
+// Поле до 16 ячеек: 4 бита на элемент.
+typedef CompactState< 1 >  CompactState16;
+
+// Поле до 10 x 10.
+typedef CompactState< Packing::wordsFor( 100 ) >  CompactState100;
+
+
+} // puzzlen
+
+
+
+
+namespace std {
+
+
+template< size_t WORDS >
+struct hash< puzzlen::CompactState< WORDS > > {
+    inline size_t operator()( const puzzlen::CompactState< WORDS >& s ) const {
+        return static_cast< size_t >( s.hash() );
+    }
+};
+
+
+} // std
@@ -0,0 +1,160 @@
+#pragma once
+
+#include "configure.h"
+#include "Geometry.h"
+#include "MappedFile.h"
+#include <atomic>
+
+
+namespace puzzlen {
+
+
+// Полный перебор расстановок поля N x M поиском в ширину от собранного
+// поля: сколько расстановок собирается ровно за d ходов и, по желанию,
+// точное расстояние до сборки для каждой.
+// # Расстановка нумеруется плотно: ранг (см. Ranking::rank()) мест
+//   пустой ячейки и элементов 1 .. C - 3, где C - количество ячеек.
+//   Места двух последних элементов - две оставшиеся ячейки, а их порядок
+//   однозначно задаёт чётность: номеров C! / 2 - ровно столько, сколько
+//   решаемых расстановок.
+// # Состояние расстановки - 2 бита: не встречалась, фронт (текущий слой),
+//   следующий слой, пройдена. Слой раскрывается потоками пула по кускам
+//   номеров, новые расстановки отмечаются атомарно (см. expand()).
+// # Формат таблицы расстояний (little-endian), версия FORMAT_VERSION:
+//     header_t
+//     uint64_t[ header_t::depths ] - расстановок по глубине
+//     uint8_t[ header_t::states ] - расстояние по номеру, с границы
+//                                   TABLE_ALIGNMENT
+//   Файл отображается в память как есть (см. MappedFile).
+class Enumerator {
+public:
+    static const uint32_t  FORMAT_VERSION = 1;
+    static const size_t    TABLE_ALIGNMENT = 4096;
+
+    // Номеров в куске, который раскрывает одна задача пула.
+    static const uint64_t  CHUNK = 1 << 16;
+
+
+    // Заголовок файла.
+    typedef struct {
+        char      magic[ 8 ];
+        // для проверки порядка байтов: 0x01020304
+        uint32_t  byteOrder;
+        uint32_t  version;
+        uint32_t  n;
+        uint32_t  m;
+        uint32_t  depths;
+        uint32_t  reserved;
+        uint64_t  states;
+        // смещение таблицы от начала файла
+        uint64_t  offset;
+        uint64_t  fileSize;
+    } header_t;
+
+
+public:
+    // Перебирает расстановки поля n x m.
+    // @param threads  Потоков; 0 - по количеству ядер.
+    // @param table    Запомнить расстояние каждой расстановки.
+    // @throw Exception Если у поля больше ENUMERATE_MAX_CELLS ячеек.
+    Enumerator( size_t n, size_t m, size_t threads, bool table );
+
+
+    // Загружает таблицу расстояний, отображая файл в память.
+    // @throw Exception  Если файл не найден или повреждён.
+    explicit Enumerator( const std::string& file );
+
+
+    virtual ~Enumerator();
+
+
+    // Сохраняет таблицу расстояний в файл.
+    // @throw Exception Если таблицы нет или файл не записать.
+    void save( const std::string& file ) const;
+
+
+    // @return Расстановок, собирающихся ровно за d ходов, по d.
+    inline std::vector< uint64_t > const& counts() const { return mCounts; }
+
+
+    // @return Наибольшее расстояние до сборки.
+    inline size_t depth() const { return mCounts.size() - 1; }
+
+
+    // @return Количество решаемых расстановок: C! / 2.
+    inline uint64_t states() const { return mStates; }
+
+
+    inline bool hasTable() const { return (mDistance != nullptr); }
+
+
+    // @return Ходов до сборки расстановки с номером 'rank'.
+    inline int distance( uint64_t rank ) const {
+        DASSERT( hasTable() && (rank < mStates) );
+        return mDistance[ rank ];
+    }
+
+
+    // @return Номер решаемой расстановки.
+    // @param tiles  Элементы по ячейкам, как в Search.
+    uint64_t rank( const uint8_t* tiles ) const;
+
+
+    // Обратное к rank().
+    void unrank( uint64_t rank,  uint8_t* tiles ) const;
+
+
+public:
+    const size_t  N;
+    const size_t  M;
+
+
+private:
+    explicit Enumerator( std::unique_ptr< MappedFile > );
+
+
+    // Состояния расстановки, 2 бита.
+    // # Соседи расстановки слоя d - из слоёв d - 1 и d + 1 (поле -
+    //   двудольный граф), поэтому отметка "следующий слой" ставится
+    //   атомарным OR без сравнения: пройденная остаётся пройденной.
+    static const uint64_t  UNSEEN = 0;
+    static const uint64_t  FRONTIER = 1;
+    static const uint64_t  NEXT = 2;
+    static const uint64_t  CLOSED = 3;
+
+
+    // Раскрывает расстановки фронта с номерами [from; to): отмечает
+    // не встречавшихся соседей следующим слоем.
+    void expand(
+        const Geometry&,
+        std::atomic< uint64_t >* bits,
+        uint64_t from,  uint64_t to,
+        uint8_t depth
+    );
+
+
+    // Переводит фронт в пройденные, следующий слой - во фронт.
+    // @return Расстановок в новом фронте среди слов [from; to).
+    static uint64_t advance(
+        std::atomic< uint64_t >* bits,  size_t from,  size_t to
+    );
+
+
+    // Места пустой ячейки и элементов по номеру (см. unrank()).
+    void positions( uint64_t rank,  int* position ) const;
+
+
+private:
+    const size_t  mCells;
+    uint64_t  mStates;
+
+    std::vector< uint64_t >  mCounts;
+
+    // таблица расстояний: построенная или отображённая из файла
+    std::vector< uint8_t >  mTable;
+    std::unique_ptr< MappedFile >  mFile;
+    const uint8_t*  mDistance;
+};
+
+
+} // puzzlen
@@ -1,17 +1,18 @@
 #pragma once
 
 #include "configure.h"
+#include <stdexcept>
 
 
 namespace puzzlen {
 
 
 class Exception :
-    public std::exception
+    public std::runtime_error
 {
 public:
     inline Exception( const std::string& s ) :
-        std::exception( s.c_str() )
+        std::runtime_error( s )
     {
         ASSERT( !s.empty() );
     }
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "configure.h"
+#include "Framebuffer.h"
+
+
+namespace puzzlen {
+
+
+// Задние буферы кадра: по одному на размер окна.
+// # Буфер создаётся, только когда окно впервые получает новый размер;
+//   дальше кадры рисуются в него без выделения памяти.
+// # Хранит не больше 'capacity' буферов: давно не нужный уходит.
+class FramePool {
+public:
+    explicit FramePool( size_t capacity = FRAME_POOL_CAPACITY );
+
+
+    virtual ~FramePool();
+
+
+    // @return Задний буфер размера 'width' x 'height'.
+    // @param stale В буфере не прошлый кадр (буфер создан или прошлый кадр
+    //        рисовался в буфер другого размера): рисовать его целиком.
+    Framebuffer& acquire( size_t width,  size_t height,  bool& stale );
+
+
+    inline size_t size() const { return mBuffers.size(); }
+
+
+    // @return Сколько буферов создано.
+    inline size_t created() const { return mCreated; }
+
+
+public:
+    const size_t  capacity;
+
+
+private:
+    // # Первый - тот, куда рисовали прошлый кадр.
+    std::vector< std::unique_ptr< Framebuffer > >  mBuffers;
+
+    size_t  mCreated;
+};
+
+
+} // puzzlen
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "configure.h"
+#include "PuzzleN.h"
+
+
+namespace puzzlen {
+
+
+// Планирует кадры по событиям вместо перерисовки по таймеру.
+// # Кадр нужен, только если поле изменилось (PuzzleN::damage() не пусто).
+// # Пачка событий мыши сливается в один кадр: кадры идут не чаще,
+//   чем раз в 'interval' (как по вертикальной развёртке).
+// # Время передаёт вызывающий, мкс от любого начала: в окне - часы,
+//   в headless-проверках - модельное время.
+class FrameScheduler {
+public:
+    typedef uint64_t  time_t;
+
+    // Кадр не нужен.
+    static const time_t  NONE = ~time_t( 0 );
+
+
+    typedef struct {
+        // событий ввода
+        uint64_t  events;
+        // из них не изменили поле: кадр не нужен
+        uint64_t  idleEvents;
+        // из них слиты с уже запланированным кадром
+        uint64_t  coalesced;
+        // нарисовано кадров
+        uint64_t  frames;
+        // времени на кадры, мкс
+        time_t  activeTime;
+    } counters_t;
+
+
+public:
+    FrameScheduler( const PuzzleN&,  time_t interval = FRAME_INTERVAL );
+
+
+    virtual ~FrameScheduler();
+
+
+    // Событие ввода обработано ядром.
+    // @return Через сколько мкс рисовать кадр: 0 - сейчас; NONE - кадр не
+    //         нужен или уже запланирован.
+    time_t event( time_t now );
+
+
+    // @return Кадр запланирован и ещё не нарисован.
+    inline bool pending() const { return mPending; }
+
+
+    // @return Когда рисовать запланированный кадр.
+    inline time_t due() const { return mDue; }
+
+
+    // Кадр нарисован: начат в 'begin', закончен в 'end'.
+    void presented( time_t begin,  time_t end );
+
+
+    inline counters_t const& counters() const { return mCounters; }
+
+
+public:
+    const time_t  interval;
+
+
+private:
+    const PuzzleN&  mPuzzle;
+
+    bool  mPending;
+    time_t  mDue;
+    // когда начат прошлый кадр
+    time_t  mLastFrame;
+    bool  mPresented;
+
+    counters_t  mCounters;
+};
+
+
+} // puzzlen
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "configure.h"
+#include "PuzzleN.h"
+
+
+namespace puzzlen {
+
+
+// Программный кадр: пиксели ARGB32 построчно, без окна и GDI+.
+// # Для headless-визуализации и сравнения кадров (см. Renderer).
+class Framebuffer {
+public:
+    // 0xAARRGGBB
+    typedef uint32_t  pixel_t;
+
+    typedef PuzzleN::visualRect_t  rect_t;
+
+
+public:
+    Framebuffer( size_t width,  size_t height,  pixel_t color = 0 );
+
+
+    virtual ~Framebuffer();
+
+
+    inline size_t width() const  { return mWidth; }
+    inline size_t height() const { return mHeight; }
+
+
+    inline pixel_t* row( int y ) { return mPixels.data() + y * mWidth; }
+    inline const pixel_t* row( int y ) const { return mPixels.data() + y * mWidth; }
+
+    inline pixel_t pixel( int x, int y ) const { return row( y )[ x ]; }
+
+
+    // @return Весь кадр.
+    inline rect_t bounds() const {
+        const rect_t  r = {
+            0,  0,  static_cast< int >( mWidth ),  static_cast< int >( mHeight )
+        };
+        return r;
+    }
+
+
+    // Закрашивает область, обрезанную по кадру.
+    // @return Сколько пикселей записано.
+    size_t fill( const rect_t&,  pixel_t );
+
+
+    // Копирует из 'source' прямоугольник с левым верхним углом (sx; sy)
+    // в область 'dest' этого кадра, обрезая по 'clip' и по кадру.
+    // @return Сколько пикселей записано.
+    size_t copy(
+        const Framebuffer& source,  int sx,  int sy,
+        const rect_t& dest,  const rect_t& clip
+    );
+
+
+    inline bool operator==( const Framebuffer& b ) const {
+        return (mWidth == b.mWidth) && (mHeight == b.mHeight)
+            && (mPixels == b.mPixels);
+    }
+
+    inline bool operator!=( const Framebuffer& b ) const { return !(*this == b); }
+
+
+    // @return Пересечение прямоугольников; пустое - с right <= left.
+    static rect_t intersect( const rect_t& a,  const rect_t& b );
+
+    static inline bool empty( const rect_t& r ) {
+        return (r.right <= r.left) || (r.bottom <= r.top);
+    }
+
+    static inline size_t area( const rect_t& r ) {
+        return empty( r ) ? 0 :
+            static_cast< size_t >( r.right - r.left ) * (r.bottom - r.top);
+    }
+
+
+private:
+    size_t  mWidth;
+    size_t  mHeight;
+    std::vector< pixel_t >  mPixels;
+};
+
+
+} // puzzlen
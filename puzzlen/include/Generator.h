@@ -0,0 +1,91 @@
+#pragma once
+
+#include "configure.h"
+#include "Enumerator.h"
+#include "Random.h"
+#include "Solver.h"
+
+
+namespace puzzlen {
+
+
+// Поля заданной сложности: кратчайшее решение - от 'lower' до 'upper'
+// ходов (shuffle() даёт поля случайной, неизвестной сложности).
+// # С таблицей расстояний (Enumerator, поля до ENUMERATE_MAX_CELLS
+//   ячеек) - расстояние точное, расстановка равновероятна среди
+//   подходящих: случайные номера, пока не подойдёт, а если подходящих
+//   мало (ожидаемых попыток больше GENERATE_REJECT) - k-я подходящая по
+//   порядку номеров, k случайно.
+// # Без таблицы - обратное блуждание от собранного поля не длиннее
+//   'upper' ходов: число ходов - оценка сверху. Оценка снизу -
+//   эвристика решателя, поднятая до чётности числа ходов (чётность
+//   расстояния известна). Блуждание без возвратов; из ходов - с
+//   наибольшей эвристикой, если она не меньше текущей, иначе любые.
+//   Поле берётся на первом ходе, где оценка снизу достигла 'lower':
+//   расстояние гарантированно в [lower; upper].
+// # С exact( true ) поле блуждания решается решателем - расстояние
+//   точное, но на 4 x 4 и больше это долго.
+// # generate() - const: один генератор на все потоки, у каждого свой
+//   Random. Пул решателя не нужен и не используется.
+// # Поля независимы и могут повторяться; повторы в корзине заменяет
+//   puzzlen-generate.
+class Generator {
+public:
+    typedef struct {
+        PuzzleN::field_t  field;
+        // границы кратчайшего решения, ходов; равны - расстояние точное
+        int  lower;
+        int  upper;
+        // блужданий или выборок из таблицы
+        uint64_t  attempts;
+    } board_t;
+
+
+public:
+    // @param solver  Эвристика для блужданий и решения для exact().
+    explicit Generator( const Solver& );
+
+
+    virtual ~Generator();
+
+
+    // Подключает таблицу расстояний; nullptr - отключает.
+    // @throw Exception Если в Enumerator нет таблицы или она для поля
+    //        другого размера.
+    void table( const std::shared_ptr< const Enumerator >& );
+
+    inline std::shared_ptr< const Enumerator > const& table() const {
+        return mTable;
+    }
+
+
+    // Решать поля блужданий: точное расстояние вместо границ.
+    inline void exact( bool e ) { mExact = e; }
+
+    inline bool exact() const { return mExact; }
+
+
+    // @return Поле с кратчайшим решением от 'lower' до 'upper' ходов.
+    // @throw Exception Если upper < lower, в таблице таких полей нет или
+    //        за GENERATE_MAX_ATTEMPTS блужданий поле не найдено.
+    board_t generate( int lower,  int upper,  Random& ) const;
+
+
+private:
+    // Поле из таблицы расстояний.
+    board_t sample( int lower,  int upper,  Random& ) const;
+
+
+    // Поле обратным блужданием с эвристикой H.
+    template< class H >
+    board_t walk( const H&,  int lower,  int upper,  Random& ) const;
+
+
+private:
+    const Solver&  mSolver;
+    std::shared_ptr< const Enumerator >  mTable;
+    bool  mExact;
+};
+
+
+} // puzzlen
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "configure.h"
+#include "PuzzleN.h"
+
+
+namespace puzzlen {
+
+
+// Таблицы поля N x M для решателей: соседи, строки и столбцы ячеек,
+// манхэттенские расстояния.
+// # Строятся один раз на размер поля и только читаются - общие для
+//   всех поисков и потоков.
+class Geometry {
+public:
+    // # Элементы в поиске храним байтами: поле до 16 x 16.
+    static const size_t MAX_CELLS = 256;
+
+
+public:
+    Geometry( size_t n, size_t m );
+
+
+    // @return Ячейка, из которой элемент сдвигается в пустую ячейку 'i'
+    //         в направлении 'd', или -1.
+    inline int source( int i, int d ) const { return mSource[ i * 4 + d ]; }
+
+    inline int row( int i ) const    { return mRow[ i ]; }
+    inline int column( int i ) const { return mColumn[ i ]; }
+
+    // @return Место элемента в собранном поле.
+    inline int goal( int element ) const {
+        return (element == PuzzleN::EMPTY_ELEMENT) ?
+            static_cast< int >( cells - 1 ) : (element - 1);
+    }
+
+    // @return Манхэттенское расстояние от ячейки 'i' до места элемента.
+    //         Для пустой ячейки - 0.
+    inline int distance( int element, int i ) const {
+        return mDistance[ element * cells + i ];
+    }
+
+
+public:
+    const size_t  N;
+    const size_t  M;
+    const size_t  cells;
+
+
+private:
+    std::vector< int >  mSource;
+    std::vector< int >  mRow;
+    std::vector< int >  mColumn;
+    std::vector< int >  mDistance;
+};
+
+
+} // puzzlen
@@ -0,0 +1,193 @@
+#pragma once
+
+#include "configure.h"
+#include "Geometry.h"
+#include "Patterns.h"
+#include "Ranking.h"
+#include "Walking.h"
+
+
+namespace puzzlen {
+
+
+// Эвристики для поиска: оценка снизу количества ходов до решения.
+// # Каждая держит своё состояние для одного поиска и обновляется при
+//   сдвиге элемента, не пересчитывая всё поле:
+//     reset( tiles )                     - с нуля;
+//     shift( tiles, tile, from, to )     - после хода, 'tiles' уже
+//                                          сдвинуты; отмена хода - это
+//                                          обратный сдвиг;
+//     value()                            - текущая оценка.
+// # Оценка нулевая только на собранном поле.
+
+
+
+
+// Манхэттенское расстояние + линейные конфликты.
+class ConflictHeuristic {
+public:
+    explicit ConflictHeuristic( const Geometry& );
+
+
+    void reset( const uint8_t* tiles );
+
+
+    inline void shift( const uint8_t* tiles, int tile, int from, int to ) {
+
+        const auto& g = mGeometry;
+        mManhattan += g.distance( tile, to ) - g.distance( tile, from );
+
+        // # Порядок элементов в линии хода не меняется: пересчитываем только
+        //   две поперечные линии и только если элемент в одной из них на месте.
+        const int goal = g.goal( tile );
+        if (g.row( from ) != g.row( to )) {
+            const int a = g.row( from );
+            const int b = g.row( to );
+            if ((g.row( goal ) == a) || (g.row( goal ) == b)) {
+                const int ca = rowConflict( tiles, a );
+                const int cb = rowConflict( tiles, b );
+                mConflict += ca - mRowConflict[ a ] + cb - mRowConflict[ b ];
+                mRowConflict[ a ] = ca;
+                mRowConflict[ b ] = cb;
+            }
+        } else {
+            const int a = g.column( from );
+            const int b = g.column( to );
+            if ((g.column( goal ) == a) || (g.column( goal ) == b)) {
+                const int ca = columnConflict( tiles, a );
+                const int cb = columnConflict( tiles, b );
+                mConflict += ca - mColumnConflict[ a ] + cb - mColumnConflict[ b ];
+                mColumnConflict[ a ] = ca;
+                mColumnConflict[ b ] = cb;
+            }
+        }
+    }
+
+
+    inline int value() const { return mManhattan + mConflict; }
+
+
+private:
+    // @return Вклад линейных конфликтов строки / столбца.
+    // # Элементы, которые стоят в своей линии, должны идти в порядке мест.
+    //   Лишние (длина минус наибольшая возрастающая подпоследовательность)
+    //   должны выйти из линии и вернуться: +2 хода за каждый.
+    int rowConflict( const uint8_t* tiles, int y ) const;
+    int columnConflict( const uint8_t* tiles, int x ) const;
+
+
+    // @return Длина наибольшей возрастающей подпоследовательности.
+    static int increasing( const int* sequence, int length );
+
+
+private:
+    const Geometry&  mGeometry;
+
+    int  mManhattan;
+    std::vector< int >  mRowConflict;
+    std::vector< int >  mColumnConflict;
+    int  mConflict;
+};
+
+
+
+
+// Walking distance: сумма расстояний по строкам и столбцам.
+// @see Walking
+// # Ход меняет индекс матрицы только одной оси - по таблице переходов.
+// # Walking distance и линейные конфликты оценивают разное: берём
+//   большую из двух оценок - она тоже не превышает расстояния.
+class WalkingHeuristic {
+public:
+    explicit WalkingHeuristic( const Walking& );
+
+
+    void reset( const uint8_t* tiles );
+
+
+    inline void shift( const uint8_t* tiles, int tile, int from, int to ) {
+
+        mConflict.shift( tiles, tile, from, to );
+
+        const auto& g = mWalking.geometry();
+        const int goal = g.goal( tile );
+        if (g.row( from ) != g.row( to )) {
+            const auto& t = mWalking.rows();
+            const size_t source = (g.row( from ) < g.row( to )) ? 0 : 1;
+            mRow = t.next( (mRow * 2 + source) * t.lines + g.row( goal ) );
+        } else {
+            const auto& t = mWalking.columns();
+            const size_t source = (g.column( from ) < g.column( to )) ? 0 : 1;
+            mColumn = t.next( (mColumn * 2 + source) * t.lines + g.column( goal ) );
+        }
+    }
+
+
+    inline int value() const {
+        return std::max(
+            mWalking.rows().distance[ mRow ] + mWalking.columns().distance[ mColumn ],
+            mConflict.value()
+        );
+    }
+
+
+private:
+    const Walking&  mWalking;
+
+    ConflictHeuristic  mConflict;
+
+    Walking::id_t  mRow;
+    Walking::id_t  mColumn;
+};
+
+
+
+
+// Сумма оценок аддитивных баз шаблонов.
+// @see Patterns
+class PatternHeuristic {
+public:
+    PatternHeuristic( const Geometry&, const Patterns& );
+
+
+    void reset( const uint8_t* tiles );
+
+
+    inline void shift( const uint8_t*, int tile, int, int to ) {
+        mPosition[ tile ] = to;
+        const size_t k = mPatterns.patternOf( tile );
+        const int v = cost( k );
+        mValue += v - mCost[ k ];
+        mCost[ k ] = v;
+    }
+
+
+    inline int value() const { return mValue; }
+
+
+private:
+    // @return Стоимость шаблона 'k' при текущих местах элементов.
+    inline int cost( size_t k ) const {
+        const auto& pattern = mPatterns.partition()[ k ];
+        int positions[ Patterns::MAX_PATTERN ];
+        for (size_t j = 0; j < pattern.size(); ++j) {
+            positions[ j ] = mPosition[ pattern[ j ] ];
+        }
+        const uint64_t r =
+            Ranking::rank( positions, pattern.size(), mGeometry.cells );
+        return mPatterns.table( k )[ r ];
+    }
+
+
+private:
+    const Geometry&  mGeometry;
+    const Patterns&  mPatterns;
+
+    // место каждого элемента
+    std::vector< int >  mPosition;
+    std::vector< int >  mCost;
+    int  mValue;
+};
+
+
+} // puzzlen
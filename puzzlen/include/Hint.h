@@ -0,0 +1,123 @@
+#pragma once
+
+#include "configure.h"
+#include "Solver.h"
+
+
+namespace puzzlen {
+
+
+// Подсказка "лучший следующий ход" после каждого хода игрока.
+// # Держит план - решение от запомненного поля (курсора) и сколько его
+//   ходов уже сделано. Игрок пошёл по подсказке - следующая подсказка
+//   берётся из плана сравнением полей, без поиска.
+// # Игрок сделал другой ход - от нового поля есть путь длиной D + 1:
+//   вернуть ход и идти по плану (D - ходов плана до сборки). Поле
+//   отличается от курсора на ход, поэтому расстояние до сборки
+//   меняется на 1, а его чётность известна: короче может быть только
+//   путь в D - 1 ход. Его ищем одним проходом IDA* с порогом D - 1 и не
+//   больше 'limit' узлов. Проход не нашёл пути - возврат хода
+//   оптимален; не хватило узлов - подсказка ведёт по возврату, но
+//   кратчайший путь не гарантирован.
+// # Поле не связано с планом (перетасовано, отменено несколько ходов) -
+//   поиск с нуля, тоже не больше 'limit' узлов. Не хватило - ход к
+//   соседу с наименьшей оценкой, без плана и не назад.
+// # Решатель (эвристика, базы шаблонов) - внешний; его пул потоков не
+//   используется: подсказка ищет в вызывающем потоке.
+class Hint {
+public:
+    // Откуда подсказка.
+    enum source_t {
+        // поле собрано, подсказки нет
+        SOLVED = 0,
+        // следующий ход плана
+        PLAN,
+        // игрок отошёл от плана на ход: план пересчитан
+        DEVIATION,
+        // поиск с нуля
+        SEARCH,
+        // поиск не уложился в узлы: ход по оценке
+        GREEDY,
+        SOURCE_COUNT
+    };
+
+    // Имена для отчётов, по индексу source_t.
+    static const char* const  SOURCE_NAME[];
+
+
+    typedef struct {
+        // PuzzleN::direction_t; -1 - поле собрано
+        int  direction;
+        // ходов до сборки по плану; для GREEDY - оценка снизу
+        size_t  remaining;
+        // подсказка ведёт кратчайшим путём
+        bool  optimal;
+        source_t  source;
+        // узлов поиска для этой подсказки
+        uint64_t  nodes;
+    } hint_t;
+
+
+public:
+    // @param limit  Узлов на поиск в next(); 0 - HINT_NODES.
+    Hint( const Solver&,  uint64_t limit );
+
+
+    virtual ~Hint();
+
+
+    // Строит план от поля 'field' полным поиском, без ограничения узлов.
+    // # Например, после перетасовки - пока игрок смотрит на поле.
+    // @throw Exception Если расстановка не решаема.
+    void solve( const PuzzleN::field_t& field );
+
+
+    // @return Подсказка для поля 'field'.
+    // @throw Exception Если поле другого размера или не решаемо.
+    hint_t next( const PuzzleN::field_t& field );
+
+
+    // Забывает план.
+    void reset();
+
+
+    // @return Ходов в плане (буквами PuzzleN::DIRECTION_NAME) и сколько
+    //         из них сделано.
+    inline std::string const& plan() const { return mPlan; }
+
+    inline size_t step() const { return mStep; }
+
+
+private:
+    // Запоминает план 'moves' от поля 'field'.
+    void adopt( const PuzzleN::field_t& field,  const std::string& moves,  bool optimal );
+
+
+    // @return Подсказка - текущий ход плана.
+    hint_t follow( source_t,  uint64_t nodes ) const;
+
+
+    // Сдвигает в курсоре пустую ячейку в направлении 'd' (см.
+    // Geometry::source()).
+    // @return false, если ход невозможен.
+    bool shift( int d );
+
+
+private:
+    const Solver&  mSolver;
+    const uint64_t  mLimit;
+
+    // поле, от которого сделано mStep ходов плана; пусто - плана нет
+    PuzzleN::field_t  mCursor;
+    int  mBlank;
+    std::string  mPlan;
+    size_t  mStep;
+    bool  mOptimal;
+
+    // поле после прошлой подсказки GREEDY и ход, который её отменяет
+    PuzzleN::field_t  mGreedy;
+    int  mGreedyBack;
+};
+
+
+} // puzzlen
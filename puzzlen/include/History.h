@@ -0,0 +1,98 @@
+#pragma once
+
+#include "configure.h"
+
+
+namespace puzzlen {
+
+
+// История ходов для отмены и повтора.
+// # Ход - направление PuzzleN::direction_t, 2 бита: 32 хода в слове.
+//   Миллион ходов - 250 Кб вместо снимков поля.
+// # Отмена и повтор - O(1): меняется только позиция в истории.
+//   Новый ход после отмены забывает отменённые ходы.
+class History {
+public:
+    typedef uint64_t  word_t;
+
+    static const size_t MOVES_PER_WORD = sizeof( word_t ) * 8 / 2;
+
+
+public:
+    History();
+
+
+    virtual ~History();
+
+
+    // Записывает ход 'direction' после текущей позиции.
+    inline void push( int direction ) {
+        DASSERT( (direction >= 0) && (direction < 4) );
+        const size_t w = mPosition / MOVES_PER_WORD;
+        if (w >= mWords.size()) {
+            mWords.push_back( 0 );
+        }
+        const size_t shift = (mPosition % MOVES_PER_WORD) * 2;
+        mWords[ w ] = (mWords[ w ] & ~(word_t( 3 ) << shift))
+                    | (static_cast< word_t >( direction ) << shift);
+        mSize = ++mPosition;
+    }
+
+
+    inline bool canUndo() const { return mPosition > 0; }
+    inline bool canRedo() const { return mPosition < mSize; }
+
+
+    // Отступает на ход назад.
+    // @return Направление отменяемого хода.
+    inline int undo() {
+        DASSERT( canUndo() );
+        return at( --mPosition );
+    }
+
+
+    // Проходит на ход вперёд.
+    // @return Направление повторяемого хода.
+    inline int redo() {
+        DASSERT( canRedo() );
+        return at( mPosition++ );
+    }
+
+
+    // @return Направление хода 'k' (с нуля).
+    inline int at( size_t k ) const {
+        DASSERT( k < mSize );
+        return static_cast< int >(
+            (mWords[ k / MOVES_PER_WORD ] >> ((k % MOVES_PER_WORD) * 2)) & 3
+        );
+    }
+
+
+    // @return Сколько ходов записано, вместе с отменёнными.
+    inline size_t size() const { return mSize; }
+
+
+    // @return Сколько ходов сделано от начала истории.
+    inline size_t position() const { return mPosition; }
+
+
+    // Забывает все ходы. Память остаётся за историей.
+    void clear();
+
+
+    // Заводит память под 'moves' ходов: до них push() не выделяет памяти.
+    void reserve( size_t moves );
+
+
+    // @return Память под ходы, байтов.
+    inline size_t bytes() const { return mWords.capacity() * sizeof( word_t ); }
+
+
+private:
+    std::vector< word_t >  mWords;
+    size_t  mSize;
+    size_t  mPosition;
+};
+
+
+} // puzzlen
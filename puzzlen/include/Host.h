@@ -0,0 +1,132 @@
+#pragma once
+
+#include "configure.h"
+#include "Latency.h"
+#include "Sessions.h"
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+
+namespace puzzlen {
+
+
+// Сервер партий (Sessions) на локальном UNIX-сокете.
+// # Протокол - текстовые строки, на каждую команду - строка ответа:
+//     open N M SEED  > ok ID                 партия N x M, см. Sessions::open()
+//     move ID D      > ok MOVED SOLVED       ход D (N, S, W, E), 0 / 1
+//     field ID       > ok E0 E1 ...          элементы поля, 0 - пустая ячейка
+//     close ID       > ok
+//     stats          > ok SESSIONS NAME COUNT P50 P99 ...
+//   Ошибка - "error MESSAGE". В stats - открытые партии и по каждой
+//   команде: сколько выполнено, p50 и p99 выполнения, нс.
+// # Соединение обслуживает свой поток: команды соединения выполняются по
+//   порядку, соединения - параллельно. Блокировка - только шарда партии
+//   (см. Sessions::with()).
+// # Время команды - от разбора строки до готового ответа, без чтения и
+//   записи сокета (см. Latency). Время с сокетом меряет клиент.
+// # Только POSIX: в сборку под Windows не входит.
+class Host {
+public:
+    enum command_t {
+        OPEN = 0,
+        MOVE,
+        FIELD,
+        CLOSE,
+        STATS,
+        COMMAND_COUNT
+    };
+
+    // Имена команд протокола, по индексу command_t.
+    static const char* const  COMMAND_NAME[];
+
+    // Наибольшая длина строки команды: длиннее - соединение закрывается.
+    static const size_t  MAX_LINE = 4096;
+
+
+public:
+    // Открывает сокет 'socket' (оставшийся от прошлого запуска файл
+    // удаляется).
+    // @throw Exception Если сокет не открыть.
+    Host( Sessions&,  const std::string& socket );
+
+
+    virtual ~Host();
+
+
+    // Принимает соединения, пока не вызван stop(). Затем закрывает
+    // соединения и ждёт их потоки.
+    void run();
+
+
+    // Останавливает run(). Можно из другого потока и из обработчика
+    // сигнала.
+    inline void stop() { mStop.store( true ); }
+
+
+    // Выполняет команду протокола и учитывает её время.
+    // @return Строка ответа без перевода строки.
+    std::string execute( const std::string& line );
+
+
+    inline Latency::summary_t summary( command_t command ) const {
+        return mLatency[ command ].summary();
+    }
+
+
+    // Печатает время команд, которые хоть раз выполнялись.
+    void report( std::ostream& ) const;
+
+
+private:
+    // Выполняет команды соединения 'fd', пока оно открыто.
+    void serve( int fd );
+
+
+    // Ждёт потоки закрытых соединений: клиенты переподключаются, а
+    // потоки не копятся до stop().
+    void reap();
+
+
+private:
+    Sessions&  mSessions;
+    const std::string  mSocket;
+    int  mListen;
+    std::atomic< bool >  mStop;
+
+    // открытые соединения и их потоки; потоки, закончившие serve()
+    std::mutex  mMutex;
+    std::vector< int >  mClients;
+    std::vector< std::thread >  mThreads;
+    std::vector< std::thread::id >  mFinished;
+
+    Latency  mLatency[ COMMAND_COUNT ];
+};
+
+
+
+
+// Клиент сервера партий: команда - ответ.
+class HostClient {
+public:
+    // @throw Exception Если к сокету не подключиться.
+    explicit HostClient( const std::string& socket );
+
+
+    virtual ~HostClient();
+
+
+    // Отправляет строку команды и ждёт строку ответа.
+    // @return Ответ без перевода строки.
+    // @throw Exception Если соединение закрыто.
+    std::string request( const std::string& line );
+
+
+private:
+    int  mFd;
+    // принятое, но ещё не разобранное
+    std::string  mBuffer;
+};
+
+
+} // puzzlen
@@ -0,0 +1,211 @@
+#pragma once
+
+#include "configure.h"
+#include "PuzzleN.h"
+#include <limits>
+
+
+namespace puzzlen {
+
+
+// Поле пятнашек любого размера для нагрузочных прогонов без окна: 1000 x
+// 1000 и больше.
+// # Элементы хранятся типом E - uint16_t или uint32_t по размеру поля
+//   (см. withHugeBoard()): миллион ячеек - 4 Мб. Позиций всех элементов,
+//   как PuzzleN, не держим: ходу нужна только пустая ячейка, её место и
+//   координаты хранятся отдельно.
+// # Ход, permitShift(), место пустой ячейки и solved() - O(1): соседи
+//   пустой ячейки - сложением, собранность - по счётчику ячеек не на
+//   своих местах, который ход меняет не больше чем на 2.
+template< class E >
+class HugeBoard {
+public:
+    typedef E  element_t;
+
+    // Элементы 0 .. cells - 1 должны помещаться в E.
+    static const size_t MAX_CELLS = std::numeric_limits< E >::max();
+
+
+public:
+    // Собранное поле.
+    // @throw Exception Если поле меньше 2 x 2 или больше MAX_CELLS ячеек.
+    HugeBoard( size_t n, size_t m ) :
+        N( n ), M( m ),
+        cells( n * m )
+    {
+        if ( (n < 2) || (m < 2) ) {
+            throw Exception( "Width and height of puzzle must have value above 1." );
+        }
+        if ( (cells / n != m) || (cells > MAX_CELLS) ) {
+            throw Exception( "Puzzle is too large for elements of this size." );
+        }
+        mField.resize( cells );
+        createField();
+    }
+
+
+    // Расставляет элементы по порядку.
+    void createField() {
+        for (size_t i = 0; i + 1 < cells; ++i) {
+            mField[ i ] = static_cast< E >( i + 1 );
+        }
+        mField[ cells - 1 ] = static_cast< E >( PuzzleN::EMPTY_ELEMENT );
+        index();
+    }
+
+
+    // Перетасовывает поле, см. PuzzleN::shuffleField().
+    void shuffle( uint64_t seed ) {
+        Random  random( seed );
+        PuzzleN::shuffleField( mField.data(), N, M, random );
+        index();
+    }
+
+
+    // Сдвигает в пустую ячейку соседний элемент в направлении 'direction'.
+    // @return Был ли ход возможен.
+    // @see PuzzleN::shift()
+    inline bool shift( PuzzleN::direction_t direction ) {
+        size_t from;
+        switch ( direction ) {
+            case PuzzleN::NORTH:
+                if (mEmptyY + 1 >= M) { return false; }
+                from = mEmpty + N;
+                ++mEmptyY;
+                break;
+            case PuzzleN::SOUTH:
+                if (mEmptyY == 0) { return false; }
+                from = mEmpty - N;
+                --mEmptyY;
+                break;
+            case PuzzleN::WEST:
+                if (mEmptyX + 1 >= N) { return false; }
+                from = mEmpty + 1;
+                ++mEmptyX;
+                break;
+            default:
+                if (mEmptyX == 0) { return false; }
+                from = mEmpty - 1;
+                --mEmptyX;
+                break;
+        }
+
+        // # Меняются только две ячейки: пересчитываем их вклад в счётчик.
+        const size_t tile = mField[ from ];
+        mMisplaced += placed( from, tile ) + placed( mEmpty, PuzzleN::EMPTY_ELEMENT );
+        mMisplaced -= placed( mEmpty, tile ) + placed( from, PuzzleN::EMPTY_ELEMENT );
+        mField[ mEmpty ] = static_cast< E >( tile );
+        mField[ from ] = static_cast< E >( PuzzleN::EMPTY_ELEMENT );
+        mEmpty = from;
+
+        return true;
+    }
+
+
+    // @return В каких направлениях может смещаться элемент из ячейки 'i'.
+    // # Для пустой ячейки - 'true' по всем направлениям, см.
+    //   PuzzleN::permitShift().
+    inline PuzzleN::permitShift_t permitShift( size_t i ) const {
+        if (i == mEmpty) {
+            const PuzzleN::permitShift_t  ps = { true, true, true, true };
+            return ps;
+        }
+        const PuzzleN::permitShift_t  ps = {
+            (mEmptyY + 1 < M) && (mEmpty + N == i),
+            (mEmptyY > 0)     && (mEmpty == i + N),
+            (mEmptyX + 1 < N) && (mEmpty + 1 == i),
+            (mEmptyX > 0)     && (mEmpty == i + 1)
+        };
+        return ps;
+    }
+
+
+    // @return 1D-координата пустого элемента.
+    inline size_t emptyElement() const { return mEmpty; }
+
+
+    inline element_t element( size_t i ) const { return mField[ i ]; }
+
+
+    inline std::vector< E > const& elements() const { return mField; }
+
+
+    // @return Поле собрано.
+    inline bool solved() const { return (mMisplaced == 0); }
+
+
+    // @return Память поля, байт.
+    inline size_t bytes() const { return mField.capacity() * sizeof( E ); }
+
+
+public:
+    const size_t  N;
+    const size_t  M;
+    const size_t  cells;
+
+
+private:
+    // @return 1, если 'element' в ячейке 'i' стоит на своём месте.
+    inline size_t placed( size_t i, size_t element ) const {
+        return (element == PuzzleN::EMPTY_ELEMENT) ?
+            static_cast< size_t >( i + 1 == cells ) :
+            static_cast< size_t >( element == i + 1 );
+    }
+
+
+    // Находит пустую ячейку и считает ячейки не на своих местах.
+    void index() {
+        mMisplaced = 0;
+        for (size_t i = 0; i < cells; ++i) {
+            if (mField[ i ] == PuzzleN::EMPTY_ELEMENT) {
+                mEmpty = i;
+            }
+            mMisplaced += 1 - placed( i, mField[ i ] );
+        }
+        mEmptyX = mEmpty % N;
+        mEmptyY = mEmpty / N;
+    }
+
+
+private:
+    std::vector< E >  mField;
+
+    size_t  mEmpty;
+    size_t  mEmptyX;
+    size_t  mEmptyY;
+
+    size_t  mMisplaced;
+};
+
+
+
+
+template< class E >
+const size_t  HugeBoard< E >::MAX_CELLS;
+
+
+extern template class HugeBoard< uint16_t >;
+extern template class HugeBoard< uint32_t >;
+
+
+
+
+// Вызывает 'f' с собранным полем n x m на самых коротких элементах, в
+// которые оно помещается: f( HugeBoard< uint16_t >& ) или
+// f( HugeBoard< uint32_t >& ).
+// @throw Exception Если поле не помещается и в 32 бита.
+template< class F >
+void
+withHugeBoard( size_t n,  size_t m,  F&& f ) {
+
+    if (n * m <= HugeBoard< uint16_t >::MAX_CELLS) {
+        HugeBoard< uint16_t >  board( n, m );
+        f( board );
+        return;
+    }
+    HugeBoard< uint32_t >  board( n, m );
+    f( board );
+}
+
+
+} // puzzlen
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "configure.h"
+#include "Latency.h"
+
+
+namespace puzzlen {
+
+
+// Замеры горячих мест: сколько раз вызваны, сколько длились и как
+// распределены задержки (гистограмма).
+// # Включается при сборке: определить PUZZLEN_INSTRUMENT (cmake
+//   -DPUZZLEN_INSTRUMENT=ON). Без него PUZZLEN_PROBE() пуст - в коде
+//   не остаётся ни часов, ни счётчиков.
+// # Замер - Latency: без блокировок, можно из любого потока, в т.ч. из
+//   решателя на ThreadPool.
+class Instrument {
+public:
+    // Что замеряем.
+    enum probe_t {
+        // кадр целиком: WM_PAINT
+        FRAME = 0,
+        // сборка кадра в заднем буфере: Renderer::draw(), drawAll()
+        RENDER,
+        // вывод буфера в окно: SetDIBitsToDevice()
+        PRESENT,
+        // спрайты элементов: Painter::prepareAtlas() (DrawImage, DrawString)
+        ATLAS,
+        // событие ввода: мышь, клавиши
+        INPUT,
+        // решение поля: Solver::solve()
+        SOLVE,
+        PROBE_COUNT
+    };
+
+    // Имена для report(), по индексу probe_t.
+    static const char* const  PROBE_NAME[];
+
+    typedef Latency::summary_t  summary_t;
+
+
+    // Замер области видимости: от конструктора до деструктора.
+    class Scope {
+    public:
+        explicit inline Scope( probe_t probe ) :
+            mProbe( probe ),
+            mBegin( std::chrono::steady_clock::now() )
+        {
+        }
+
+        inline ~Scope() {
+            record( mProbe,  Latency::since( mBegin ) );
+        }
+
+    private:
+        const probe_t  mProbe;
+        const std::chrono::steady_clock::time_point  mBegin;
+    };
+
+
+public:
+    // Учитывает замер 'ns' наносекунд.
+    static void record( probe_t,  uint64_t ns );
+
+
+    // @return Итоги замера. Замеры из других потоков могут идти
+    //         одновременно: итоги согласованы приблизительно.
+    static summary_t summary( probe_t );
+
+
+    // Печатает итоги всех замеров, которые хоть раз сработали.
+    static void report( std::ostream& );
+
+
+    // Печатает report() при выходе из программы: в файл 'file' или,
+    // если имя пусто, в std::cerr.
+    static void reportAtExit( const std::string& file );
+
+
+    static void reset();
+
+
+private:
+    // # Статические: нули до первого замера.
+    static Latency  mCounter[ PROBE_COUNT ];
+};
+
+
+} // puzzlen
+
+
+
+
+// Замеряет область видимости, см. Instrument::probe_t.
+// Пример: PUZZLEN_PROBE( RENDER )
+#ifdef PUZZLEN_INSTRUMENT
+#define PUZZLEN_PROBE(PROBE)  const puzzlen::Instrument::Scope  instrumentScope( puzzlen::Instrument::PROBE );
+#else
+#define PUZZLEN_PROBE(PROBE)
+#endif
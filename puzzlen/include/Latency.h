@@ -0,0 +1,63 @@
+#pragma once
+
+#include "configure.h"
+#include <atomic>
+
+
+namespace puzzlen {
+
+
+// Гистограмма задержек: сколько замеров, сумма, наибольший, p50 и p99.
+// # Гистограмма - по степеням двойки: корзина b держит задержки
+//   [2^b; 2^(b+1)) нс. Перцентили - с точностью до корзины.
+// # Счётчики атомарные, без блокировок (memory_order_relaxed): замерять
+//   можно из любого потока.
+// # Конструктора нет: статический объект - нули до первого замера,
+//   прочие обнуляются reset().
+class Latency {
+public:
+    // Корзин в гистограмме: последняя - всё от 2^39 нс (~9 мин).
+    static const size_t  BUCKETS = 40;
+
+
+    typedef struct {
+        uint64_t  count;
+        // нс
+        uint64_t  total;
+        uint64_t  max;
+        uint64_t  p50;
+        uint64_t  p99;
+    } summary_t;
+
+
+public:
+    // Учитывает замер 'ns' наносекунд.
+    void record( uint64_t ns );
+
+
+    // @return Итоги замера. Замеры из других потоков могут идти
+    //         одновременно: итоги согласованы приблизительно.
+    summary_t summary() const;
+
+
+    void reset();
+
+
+    // @return Наносекунды от 'begin' до сейчас.
+    static inline uint64_t since( const std::chrono::steady_clock::time_point& begin ) {
+        return static_cast< uint64_t >(
+            std::chrono::duration_cast< std::chrono::nanoseconds >(
+                std::chrono::steady_clock::now() - begin
+            ).count()
+        );
+    }
+
+
+private:
+    std::atomic< uint64_t >  mTotal;
+    std::atomic< uint64_t >  mMax;
+    std::atomic< uint64_t >  mBucket[ BUCKETS ];
+};
+
+
+} // puzzlen
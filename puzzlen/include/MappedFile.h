@@ -0,0 +1,43 @@
+#pragma once
+
+#include "configure.h"
+
+
+namespace puzzlen {
+
+
+// Файл, отображённый в память только для чтения.
+// # Страницы подгружаются по требованию и делятся между процессами через
+//   страничный кэш: открытие не зависит от размера файла.
+class MappedFile {
+public:
+    // @throw Exception Если файл не открыть или не отобразить.
+    explicit MappedFile( const std::string& file );
+
+
+    virtual ~MappedFile();
+
+
+    inline const uint8_t* data() const { return mData; }
+    inline size_t size() const         { return mSize; }
+
+
+private:
+    MappedFile( const MappedFile& );
+    MappedFile& operator=( const MappedFile& );
+
+
+private:
+    const uint8_t*  mData;
+    size_t  mSize;
+
+#ifdef _WIN32
+    HANDLE  mFile;
+    HANDLE  mMapping;
+#else
+    int  mFile;
+#endif
+};
+
+
+} // puzzlen
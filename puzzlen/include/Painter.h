@@ -0,0 +1,57 @@
+#pragma once
+
+#include "configure.h"
+#include "FramePool.h"
+#include "PuzzleN.h"
+#include "Renderer.h"
+
+
+namespace puzzlen {
+
+
+// Визуализация пятнашек средствами GDI+.
+// # Ядро (PuzzleN) ничего не знает о Windows: рисуем только здесь.
+// # Спрайты всех элементов рисуются один раз при создании - в атлас
+//   (cell.png + номер элемента). Кадр только копирует ячейки атласа.
+// # Кадр собирает ядро (Renderer) в программном заднем буфере из
+//   FramePool - по одному на размер окна. Перерисовываются только
+//   области PuzzleN::damage(), после draw() вызывающий сбрасывает их -
+//   PuzzleN::clearDamage(). В окно буфер копируется SetDIBitsToDevice():
+//   кадр не создаёт объектов GDI+ и не выделяет памяти.
+class Painter {
+public:
+    // # Размеры поля и ячейки у PuzzleN не меняются, поэтому атлас
+    //   строится здесь и больше не перестраивается.
+    explicit Painter( const PuzzleN& );
+
+
+    virtual ~Painter();
+
+
+    // Рисует в окне Windows область 'rc'.
+    void draw( HDC, const RECT& );
+
+
+private:
+    // Рисует спрайты всех элементов в атлас.
+    // # Элемент e лежит в ячейке атласа e - 1 (по строкам, как на собранном
+    //   поле): атлас размером с поле.
+    // # Спрайты наложены на белый фон: Renderer копирует их без смешения.
+    // @return Атлас в пикселях ARGB32 для Renderer.
+    Framebuffer prepareAtlas() const;
+
+
+    // @return Ячейка атласа со спрайтом элемента, пкс.
+    Gdiplus::Rect atlasCell( const PuzzleN::element_t& ) const;
+
+
+private:
+    const PuzzleN&  mPuzzle;
+
+    const Renderer  mRenderer;
+
+    FramePool  mPool;
+};
+
+
+} // puzzlen
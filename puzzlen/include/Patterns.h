@@ -0,0 +1,134 @@
+#pragma once
+
+#include "configure.h"
+#include "MappedFile.h"
+#include "PuzzleN.h"
+
+
+namespace puzzlen {
+
+
+// Аддитивные непересекающиеся базы шаблонов (pattern databases).
+// # Элементы поля делятся на группы (шаблоны). Для каждого шаблона
+//   таблица хранит, сколько ходов элементами шаблона нужно, чтобы
+//   поставить их на места. Ходы прочих элементов бесплатны, поэтому
+//   оценки разных шаблонов складываются.
+// # Индекс в таблице - плотный ранг размещения мест элементов шаблона
+//   (см. Ranking): для k элементов на поле из C ячеек таблица содержит
+//   C! / (C - k)! байтов.
+// # Формат файла (little-endian), версия FORMAT_VERSION:
+//     header_t
+//     patternHeader_t[ header_t::patterns ]
+//     таблицы, каждая с границы TABLE_ALIGNMENT
+//   Файл отображается в память как есть: процессы решателя стартуют за
+//   миллисекунды и делят одну копию в страничном кэше.
+class Patterns {
+public:
+    typedef std::vector< PuzzleN::element_t >  pattern_t;
+    typedef std::vector< pattern_t >  partition_t;
+
+
+    static const uint32_t  FORMAT_VERSION = 1;
+    static const size_t    TABLE_ALIGNMENT = 4096;
+    static const size_t    MAX_PATTERN = 16;
+
+
+    // Заголовок файла.
+    typedef struct {
+        char      magic[ 8 ];
+        // для проверки порядка байтов: 0x01020304
+        uint32_t  byteOrder;
+        uint32_t  version;
+        uint32_t  n;
+        uint32_t  m;
+        uint32_t  patterns;
+        uint32_t  reserved;
+        uint64_t  fileSize;
+    } header_t;
+
+
+    // Описание шаблона в файле.
+    typedef struct {
+        uint32_t  count;
+        uint32_t  reserved;
+        // смещение таблицы от начала файла и количество элементов в ней
+        uint64_t  offset;
+        uint64_t  entries;
+        uint8_t   elements[ MAX_PATTERN ];
+    } patternHeader_t;
+
+
+public:
+    // Строит базы для поля n x m.
+    // @param partition  Шаблоны: должны покрывать все элементы поля по
+    //                   одному разу.
+    // @throw Exception  Если разбиение неверно или таблицы слишком велики.
+    Patterns( size_t n, size_t m, const partition_t& partition );
+
+
+    // Загружает базы из файла, отображая его в память.
+    // @throw Exception  Если файл не найден или повреждён.
+    explicit Patterns( const std::string& file );
+
+
+    virtual ~Patterns();
+
+
+    // Сохраняет базы в файл.
+    void save( const std::string& file ) const;
+
+
+    // @return Разбиение по умолчанию: 6-6-3 для 4 x 4, для прочих полей -
+    //         rowPartition() по 5 элементов (5-5-5-5-4 для 5 x 5).
+    static partition_t defaultPartition( size_t n, size_t m );
+
+    // @return Элементы подряд по строкам группами не больше 'size'.
+    static partition_t rowPartition( size_t n, size_t m, size_t size );
+
+
+    inline partition_t const& partition() const { return mPartition; }
+
+
+    // @return Номер шаблона, в который входит элемент.
+    inline size_t patternOf( PuzzleN::element_t element ) const {
+        return mPatternOf[ element ];
+    }
+
+
+    // @return Таблица стоимостей шаблона 'k', индекс - Ranking::rank() мест
+    //         элементов шаблона.
+    inline const uint8_t* table( size_t k ) const { return mTables[ k ]; }
+
+
+public:
+    const size_t  N;
+    const size_t  M;
+
+
+private:
+    explicit Patterns( std::unique_ptr< MappedFile > );
+
+
+    // Строит таблицу шаблона обходом в ширину от собранного поля.
+    // # Состояние - места элементов шаблона и пустой ячейки. Ход прочим
+    //   элементом ничего не стоит, поэтому каждый уровень стоимости
+    //   сначала заливается бесплатными ходами.
+    void build( size_t k, std::vector< uint8_t >& table ) const;
+
+
+    void index();
+
+
+private:
+    partition_t  mPartition;
+    std::vector< size_t >  mPatternOf;
+    std::vector< const uint8_t* >  mTables;
+
+    // таблицы построенных баз
+    std::vector< std::vector< uint8_t > >  mBuilt;
+    // или файл загруженных
+    std::unique_ptr< MappedFile >  mFile;
+};
+
+
+} // puzzlen
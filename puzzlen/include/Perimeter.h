@@ -0,0 +1,98 @@
+#pragma once
+
+#include "configure.h"
+#include "CompactState.h"
+#include "Geometry.h"
+
+
+namespace puzzlen {
+
+
+// Периметр вокруг собранного поля: все расстановки, которые собираются
+// не больше чем за depth() ходов, с точным расстоянием до сборки.
+// # Строится поиском в ширину от собранного поля (обратная половина
+//   двунаправленного поиска). Решатель ищет от перетасованного поля
+//   навстречу (см. Search::perimeter()): дойдя до периметра, берёт
+//   остаток пути отсюда, а за периметром знает, что до сборки не меньше
+//   depth() + 1 ходов.
+// # Расстановки хранятся упакованными (см. Packing, CompactState) в
+//   открытой хеш-таблице.
+// # Глубина - наибольшая, при которой периметр и его построение
+//   гарантированно помещаются в 'budget' байт. Если бюджета не хватает
+//   даже на первый слой, в периметре только собранное поле: поиск
+//   остаётся однонаправленным.
+// # После построения только читается - общий для всех поисков и потоков.
+class Perimeter {
+public:
+    // Упакованное поле до 10 x 10 - не больше стольких слов.
+    static const size_t MAX_WORDS = Packing::wordsFor( 100 );
+
+    // Таблица не заполняется больше чем на 1 / LOAD_FACTOR.
+    static const size_t LOAD_FACTOR = 2;
+
+    static const size_t MIN_CAPACITY = 64;
+
+
+public:
+    // @throw Exception Если поле больше 10 x 10.
+    Perimeter( const Geometry&,  size_t budget );
+
+
+    virtual ~Perimeter();
+
+
+    // @return Ходов до сборки или -1, если расстановка за периметром.
+    // @param tiles  Элементы поля по ячейкам, как в Search.
+    int distance( const uint8_t* tiles ) const;
+
+
+    // @return Глубина периметра, ходов.
+    inline int depth() const { return mDepth; }
+
+
+    // @return Расстановок в периметре.
+    inline size_t size() const { return mSize; }
+
+
+    // @return Память таблицы, байт.
+    inline size_t bytes() const {
+        return mDistance.size() * (mPacking.words * sizeof( uint64_t ) + 1);
+    }
+
+
+public:
+    const size_t  budget;
+
+
+private:
+    // @return Слот с ключом 'word' или пустой слот, где ему место.
+    size_t find( const uint64_t* word ) const;
+
+
+    // Переносит таблицу в 'capacity' слотов.
+    void grow( size_t capacity );
+
+
+    // @return Байт на таблицу из 'capacity' слотов.
+    inline size_t tableBytes( size_t capacity ) const {
+        return capacity * (mPacking.words * sizeof( uint64_t ) + 1);
+    }
+
+
+private:
+    static const uint8_t  EMPTY = 0xFF;
+
+    const Packing  mPacking;
+
+    int  mDepth;
+    size_t  mSize;
+
+    // ключи по mPacking.words слов на слот
+    std::vector< uint64_t >  mKey;
+    // расстояния по слотам, EMPTY - слот свободен
+    std::vector< uint8_t >  mDistance;
+    size_t  mMask;
+};
+
+
+} // puzzlen
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "configure.h"
+#include "History.h"
+#include "Random.h"
 
 
 namespace puzzlen {
@@ -8,7 +10,7 @@ namespace puzzlen {
 
 class PuzzleN {
 public:
-    //      .
+    // Структуры для отработки перетаскивания элемента мышью.
     typedef struct {
         int x;
         int y;
@@ -19,18 +21,33 @@ public:
     typedef coord_t  visualCoord_t;
 
 
+    // Прямоугольник при визуализации, пкс: [left; right) x [top; bottom).
     typedef struct {
-        //   ,   'field_t'
+        int  left;
+        int  top;
+        int  right;
+        int  bottom;
+    } visualRect_t;
+
+
+    // Области, которые изменились с прошлого кадра.
+    // # Ячейки без повторов; перестановка поля целиком - одна область
+    //   на всё поле.
+    typedef std::vector< visualRect_t >  damage_t;
+
+
+    typedef struct {
+        // какой элемент перемещается, индекс в 'field_t'
         int  i;
-        //    , 
+        // координаты первого клика мышью, пкс
         visualCoord_t  firstClick;
-        //   , 
+        // на сколько перемещается, пкс
         visualCoord_t  shift;
         visualCoord_t  emptyClickShift;
     } move_t;
 
 
-    //      .
+    // В каких направления элемент может перемещаться.
     typedef struct {
         bool  north;
         bool  south;
@@ -39,63 +56,116 @@ public:
     } permitShift_t;
 
 
+    // Направление, в котором элемент сдвигается к пустой ячейке.
+    enum direction_t {
+        NORTH = 0,
+        SOUTH,
+        WEST,
+        EAST
+    };
+
+    // Буквы для записи ходов, по индексу direction_t: "NSWE".
+    static const char  DIRECTION_NAME[];
+
+
     typedef size_t  element_t;
-    // #    1D-.
-    // #       .
-    // #  1      - . move_t.
+    // # Элементы храним в 1D-матрице.
+    // # Индекс матрицы определяет позицию элемента на поле.
+    // # Смещение 1 элемента храним в отдельной структуре - см. move_t.
     typedef std::vector< element_t >  field_t;
 
+    // Обратная к field_t перестановка: индекс - элемент, значение - 1D-позиция
+    // элемента на поле.
+    // # Обновляется при каждом обмене элементов: "где пустая ячейка / где
+    //   элемент k" - за O(1).
+    typedef std::vector< size_t >  positions_t;
+
+    static const element_t  EMPTY_ELEMENT = 0;
+
 
 public:
     const size_t  N;
     const size_t  M;
     const size_t  cellSize;
 
-    // ,      ""  .
+    // Расстояние, при котором смещаемый элемент сам "прилипнет" к соседу.
     const size_t  glueDistance;
 
 
 public:
-    // @param cellSize     , .
+    // @param cellSize  Размер ячейки для визуализации, пкс.
     PuzzleN( size_t n, size_t m, size_t cellSize );
 
 
     virtual ~PuzzleN();
 
 
-    //   . : .
+    // Заполняет поле элементами. Порядок: последовательно.
     void createField();
 
 
-    //      .
-    void shuffle();
+    // Случайным образом разбрасывает элементы по полю.
+    // # Получаются только решаемые расстановки.
+    // @return Зерно, с которым перетасовано поле. Передав его в
+    //         shuffle( seed ), получим ту же расстановку.
+    uint64_t shuffle();
+
+    void shuffle( uint64_t seed );
+
+
+    // Заполняет 'first' (n * m элементов) случайной решаемой расстановкой.
+    // # Тасование Фишера-Йетса с подсчётом чётности перестановки. Если
+    //   чётность не сходится с чётностью положения пустой ячейки, меняем
+    //   местами два непустых элемента. O(n * m), без выделения памяти.
+    // # Элементы любого целого типа: так тасуются и компактные поля
+    //   (см. HugeBoard).
+    template< class E >
+    static void shuffleField(
+        E* first,  size_t n,  size_t m,  Random&
+    );
 
 
-    // @return      .
+    // Заполняет 'out' пачкой из 'count' полей, уложенных подряд.
+    // # Поле k зависит только от (seed, k): пачку можно делить между
+    //   потоками и воспроизводить по частям.
+    static void shuffleBatch(
+        field_t& out,  size_t n,  size_t m,  uint64_t seed,  size_t count
+    );
+
+
+    // @return Можно ли из расстановки собрать поле createField().
+    // # Сравнивает чётность перестановки (по циклам, O(n * m)) с чётностью
+    //   расстояния пустой ячейки до её места.
+    static bool solvable( const field_t&,  size_t n,  size_t m );
+
+
+    // @return Поле, записанное элементами через пробел или запятую
+    //         в порядке field_t, 0 - пустая ячейка.
+    // @throw Exception Если в записи не только числа.
+    static field_t parseField( const std::string& );
+
+
+    // @return Элемент на поле по заданной координате.
     inline element_t const&  element( const logicCoord_t& lc ) const {
         DASSERT( inside( lc ) );
         return mField.at( ic( lc ) );
     }
 
 
-    // @return 1D-  .
+    // @return 1D-координата пустого элемента.
     inline int emptyElement() const {
-        for (auto itr = mField.cbegin(); itr != mField.cend(); ++itr) {
-            const element_t element = *itr;
-            if (element == EMPTY_ELEMENT) {
-                return std::distance( mField.cbegin(), itr );
-            }
-        }
-        DASSERT( false );
-        return -1;
+        return position( EMPTY_ELEMENT );
     }
 
 
-    //    Windows.
-    void draw( HDC, const RECT& );
+    // @return 1D-координата элемента.
+    inline int position( element_t element ) const {
+        DASSERT( element < mPosition.size() );
+        return static_cast< int >( mPosition[ element ] );
+    }
 
 
-    //   .
+    // Отрабатывает перетаскивание мышкой.
     void firstClick( int x, int y );
     void move( int x, int y );
     void stickMove();
@@ -103,39 +173,160 @@ public:
     void resetFirstClick();
     void resetShift();
 
+
+    // @return Может ли смещаться элемент.
+    // @see permitShift()
+    inline bool hasPermitShift( int i ) const {
+        const auto ps = permitShift( i );
+        return (ps.north || ps.south || ps.west || ps.east);
+    }
+
+
+    // @return В каких направлениях может смещаться элемент.
+    // # Для пустой ячейки возвращает 'true' по всем направлениям.
+    permitShift_t permitShift( int i ) const;
+
+
+    // Сдвигает в пустую ячейку соседний элемент, который может
+    // переместиться в направлении 'direction'. Мышь не нужна: для
+    // решателей, воспроизведения и симуляторов.
+    // @return Был ли ход возможен.
+    bool shift( direction_t );
+
+
+    // Отменяет / повторяет ход из истории (см. history()).
+    // # Недотянутый мышью элемент возвращается на место, как в shift().
+    // @return Был ли ход в истории.
+    bool undo();
+    bool redo();
+
+
+    // Отменяет или повторяет ходы, пока в истории не будет сделано
+    // 'position' ходов.
+    // @return Сколько ходов отменено или повторено.
+    size_t seek( size_t position );
+
+
+    // @return Ходы с начала партии: shift() и перетаскивания мышью.
+    // # Начинается заново после createField() / shuffle() / field().
+    inline History const& history() const { return mHistory; }
+
+
+    // Выделяет историю на 'moves' ходов: до них ходы не выделяют память.
+    // # По умолчанию история растёт по мере ходов - партии, где отмена не
+    //   нужна (сервер, проверки), не держат пустой запас.
+    inline void reserveHistory( size_t moves ) { mHistory.reserve( moves ); }
+
+
+    // @return Противоположное направление.
+    static inline direction_t opposite( direction_t d ) {
+        return static_cast< direction_t >( d ^ 1 );
+    }
+
     inline void pressMouseButton( bool state ) { mPressMouseButton = state; }
     inline bool pressMouseButton()             { return mPressMouseButton; }
 
 
-    //  .
+    // Для отладки.
     inline move_t const& aboutMove() const { return mMove; }
 
 
+    // @return Элементы поля. Для визуализации и симуляторов.
+    inline field_t const& field() const { return mField; }
+
+    // Расставляет элементы на поле.
+    // @throw Exception Если 'field' - не перестановка элементов поля N x M.
+    void field( const field_t& );
+
+
+    // @return Поле собрано (совпадает с createField()).
+    bool solved() const;
+
+
+    // @return Области, изменившиеся после clearDamage(): что перерисовать.
+    // # Отмечают move() / stickMove() / shift() / shuffle() / field() /
+    //   createField(). Смещаемый элемент двигается только к пустой ячейке,
+    //   поэтому его ячейка и пустая покрывают и старое, и новое изображение.
+    inline damage_t const& damage() const { return mDamage; }
+
+    // Кадр нарисован: изменений нет.
+    inline void clearDamage() {
+        mDamage.clear();
+        mDamageAll = false;
+    }
+
+
+    // @return Где рисовать элемент из ячейки 'i', с учётом смещения мышью.
+    inline visualRect_t visualRect( int i ) const {
+        const logicCoord_t lc = ci( i );
+        const int cs = static_cast< int >( cellSize );
+        const bool shifted = (i == mMove.i);
+        const int x = lc.x * cs + (shifted ? mMove.shift.x : 0);
+        const int y = lc.y * cs + (shifted ? mMove.shift.y : 0);
+        const visualRect_t  r = { x,  y,  x + cs,  y + cs };
+        return r;
+    }
+
+    // @return Позиции элементов поля.
+    // @see positions_t
+    inline positions_t const& positions() const { return mPosition; }
+
+
+    // @return 1D-координата лежит в пределах поля.
+    inline bool inside( const logicCoord_t& lc ) const {
+        return (lc.x >= 0) && (lc.x < static_cast< int >( N ))
+            && (lc.y >= 0) && (lc.y < static_cast< int >( M ));
+    }
+
+
+    // @return 2D-координата, переведёная в 1D.
+    inline int ic( const logicCoord_t& c ) const { return ic( c.x, c.y ); }
+    inline int ic( int x, int y ) const          { return x + y * N; }
+
+    // @return 1D-координата, переведёная в 2D.
+    inline logicCoord_t ci( int i ) const {
+        const int y = i / static_cast< int >( N );
+        const logicCoord_t c = { i - y * static_cast< int >( N ),  y };
+        return c;
+    }
+
+
 private:
     inline bool allFixed() const {
         return (mMove.shift.x == 0) && (mMove.shift.y == 0);
     }
 
 
-    // @return 1D- ,     -1,  
-    //          .
+    // @return 1D-индекс элемента, который не зафиксирован или -1, если такого
+    //         элемента нет.
     inline int whoUnfixed() const { return mMove.i; }
 
 
-    // @return    .
-    // @see permitShift()
-    inline bool hasPermitShift( int i ) const {
-        const auto ps = permitShift( i );
-        return (ps.north || ps.south || ps.west || ps.east);
+    // Меняет местами элементы в заданных 1D-позициях.
+    inline void swapElement( int a, int b ) {
+        std::swap( mField[ a ],  mField[ b ] );
+        mPosition[ mField[ a ] ] = a;
+        mPosition[ mField[ b ] ] = b;
     }
 
 
-    // @return      .
-    // #     'true'   .
-    permitShift_t permitShift( int i ) const;
+    // Строит позиции элементов по полю.
+    void indexPositions();
+
+
+    // Сдвигает элемент в пустую ячейку, не записывая ход в историю.
+    // @see shift()
+    bool shiftElement( direction_t );
+
 
+    // Отмечает изменение ячейки 'i' / смещаемого элемента / всего поля.
+    // @see damage()
+    void damageCell( int i );
+    void damageMove();
+    void damageAll();
 
-    // @return       .
+
+    // @return Наличие соседа у элемента в заданном направении.
     inline bool neighbourNorth( const logicCoord_t& lc ) const {
         const logicCoord_t nlc = { lc.x,  lc.y - 1 };
         return present( nlc );
@@ -157,46 +348,73 @@ private:
     }
 
 
-    // @return     .
-    // #      .   
-    //     'true'.
+    // @return Наличие элемента по заданным координатам.
+    // # Допустимо указывать координаты за пределами поля. В этом случае
+    //   ответом будет 'true'.
     inline bool present( const logicCoord_t& lc ) const {
         if ( !inside( lc ) ) { return true; }
         return (element( lc ) != EMPTY_ELEMENT);
     }
 
 
-    // @return 1D-    .
-    inline bool inside( const logicCoord_t& lc ) const {
-        return (lc.x >= 0) && (lc.x < static_cast< int >( N ))
-            && (lc.y >= 0) && (lc.y < static_cast< int >( M ));
-    }
 
+private:
+    field_t      mField;
+    positions_t  mPosition;
+    move_t   mMove;
 
-    // @return 2D-,   1D.
-    inline int ic( const logicCoord_t& c ) const { return ic( c.x, c.y ); }
-    inline int ic( int x, int y ) const          { return x + y * N; }
+    History  mHistory;
 
-    // @return 1D-,   2D.
-    inline logicCoord_t ci( int i ) const {
-        const int y = i / static_cast< int >( N );
-        const logicCoord_t c = { i - y * static_cast< int >( N ),  y };
-        return c;
-    }
+    damage_t  mDamage;
+    bool  mDamageAll;
 
+    bool  mPressMouseButton;
+};
 
-    std::unique_ptr< Gdiplus::Bitmap >  picture( const RECT& );
-    std::unique_ptr< Gdiplus::Bitmap >  sprite( const element_t& );
 
 
-private:
-    field_t  mField;
-    move_t   mMove;
 
-    bool  mPressMouseButton;
+template< class E >
+void
+PuzzleN::shuffleField(
+    E* first,  size_t n,  size_t m,  Random& random
+) {
+    const size_t cells = n * m;
+    DASSERT( cells > 2 );
 
-    static const element_t  EMPTY_ELEMENT = 0;
-};
+    // начинаем с собранного поля, чтобы знать чётность
+    for (size_t i = 0; i + 1 < cells; ++i) {
+        first[ i ] = static_cast< E >( i + 1 );
+    }
+    first[ cells - 1 ] = static_cast< E >( EMPTY_ELEMENT );
+
+    bool odd = false;
+    size_t emptyI = cells - 1;
+    for (size_t i = cells - 1; i > 0; --i) {
+        const size_t j = random.below( static_cast< uint32_t >( i + 1 ) );
+        if (j == i) {
+            continue;
+        }
+        std::swap( first[ i ],  first[ j ] );
+        odd = !odd;
+        if (emptyI == i) {
+            emptyI = j;
+        } else if (emptyI == j) {
+            emptyI = i;
+        }
+    }
+
+    // # Каждый ход меняет и чётность перестановки, и чётность расстояния
+    //   пустой ячейки до её места.
+    const size_t ex = emptyI % n;
+    const size_t ey = emptyI / n;
+    const bool emptyOdd = (((n - 1 - ex) + (m - 1 - ey)) & 1) != 0;
+    if (odd != emptyOdd) {
+        const size_t a = (emptyI == 0) ? 1 : 0;
+        const size_t b = (emptyI == a + 1) ? (a + 2) : (a + 1);
+        std::swap( first[ a ],  first[ b ] );
+    }
+}
 
 
 } // puzzlen
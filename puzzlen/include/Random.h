@@ -0,0 +1,92 @@
+#pragma once
+
+#include "configure.h"
+#include <cstdint>
+#include <limits>
+
+
+namespace puzzlen {
+
+
+// Генератор псевдослучайных чисел xoshiro256**.
+// # Состояние - 32 байта, быстрее std::mt19937 в разы: можно держать
+//   свой генератор на каждое поле или поток.
+// # Совместим с UniformRandomBitGenerator, т.е. годится для <random>.
+class Random {
+public:
+    typedef uint64_t  result_type;
+
+
+public:
+    // @param seed    Зерно.
+    // @param stream  Номер независимой последовательности для того же зерна.
+    //                Позволяет получать воспроизводимые поля пачками.
+    inline explicit Random( uint64_t seed, uint64_t stream = 0 ) {
+        uint64_t x = seed ^ (stream * 0xD1B54A32D192ED03ULL);
+        for (size_t k = 0; k < 4; ++k) {
+            mState[ k ] = splitmix( x );
+        }
+    }
+
+
+    static inline result_type min() { return 0; }
+    static inline result_type max() {
+        return std::numeric_limits< result_type >::max();
+    }
+
+
+    inline result_type operator()() {
+        const uint64_t result = rotl( mState[ 1 ] * 5, 7 ) * 9;
+        const uint64_t t = mState[ 1 ] << 17;
+        mState[ 2 ] ^= mState[ 0 ];
+        mState[ 3 ] ^= mState[ 1 ];
+        mState[ 1 ] ^= mState[ 2 ];
+        mState[ 0 ] ^= mState[ 3 ];
+        mState[ 2 ] ^= t;
+        mState[ 3 ] = rotl( mState[ 3 ], 45 );
+        return result;
+    }
+
+
+    // @return Равномерно распределённое число из [0; bound).
+    // # Без деления в общем случае (метод Лемира), без смещения.
+    inline uint32_t below( uint32_t bound ) {
+        DASSERT( bound > 0 );
+        uint64_t m = static_cast< uint64_t >( next32() ) * bound;
+        uint32_t l = static_cast< uint32_t >( m );
+        if (l < bound) {
+            const uint32_t t = (0u - bound) % bound;
+            while (l < t) {
+                m = static_cast< uint64_t >( next32() ) * bound;
+                l = static_cast< uint32_t >( m );
+            }
+        }
+        return static_cast< uint32_t >( m >> 32 );
+    }
+
+
+private:
+    inline uint32_t next32() {
+        return static_cast< uint32_t >( (*this)() >> 32 );
+    }
+
+
+    static inline uint64_t rotl( uint64_t x, int k ) {
+        return (x << k) | (x >> (64 - k));
+    }
+
+
+    static inline uint64_t splitmix( uint64_t& x ) {
+        uint64_t z = (x += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+
+private:
+    uint64_t  mState[ 4 ];
+};
+
+
+} // puzzlen
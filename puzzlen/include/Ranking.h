@@ -0,0 +1,185 @@
+#pragma once
+
+#include "configure.h"
+#include "Geometry.h"
+#include "PuzzleN.h"
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+
+namespace puzzlen {
+
+
+// Плотные номера размещений и перестановок (коды Лемера): базы шаблонов,
+// полный перебор, сжатое хранение полей.
+// # Размещение - различные места 'count' элементов среди 'cells' ячеек.
+//   Цифра j - номер ячейки positions[ j ] среди ещё не занятых, номер -
+//   число в смешанной системе счисления с основаниями cells, cells - 1, ...
+//   Номеров cells! / (cells - count)!.
+// # Занятые ячейки - битовая маска: цифра - место минус количество
+//   занятых ячеек левее (bitCount()), обратно - выбор свободной ячейки
+//   по номеру (select()). Номер и обратное - O(count), а не O(count^2)
+//   сравнениями со всеми поставленными элементами.
+// # Порядок номеров - прежний (лексикографический): сохранённые базы
+//   шаблонов и таблицы расстояний остаются верными.
+class Ranking {
+public:
+    // Слов маски занятых ячеек.
+    static const size_t WORDS = (Geometry::MAX_CELLS + 63) / 64;
+
+    // Перестановки всего поля нумеруются 64-битным числом до 20 ячеек:
+    // 20! < 2^64.
+    static const size_t MAX_FIELD = 20;
+
+
+public:
+    // @return Плотный номер размещения.
+    static inline uint64_t rank( const int* positions, size_t count, size_t cells ) {
+
+        uint64_t used[ WORDS ] = {};
+        uint64_t r = 0;
+        for (size_t j = 0; j < count; ++j) {
+            const size_t p = static_cast< size_t >( positions[ j ] );
+            const size_t w = p >> 6;
+            const uint64_t bit = uint64_t( 1 ) << (p & 63);
+            size_t below = bitCount( used[ w ] & (bit - 1) );
+            for (size_t i = 0; i < w; ++i) {
+                below += bitCount( used[ i ] );
+            }
+            used[ w ] |= bit;
+            r = r * (cells - j) + (p - below);
+        }
+        return r;
+    }
+
+
+    // Обратное к rank().
+    // @return Сумма цифр номера: её чётность - чётность количества
+    //         инверсий (пар элементов, где больший стоит левее).
+    static inline size_t unrank(
+        uint64_t rank,  int* positions,  size_t count,  size_t cells
+    ) {
+        // # 64-битное деление в разы медленнее 32-битного: номера баз
+        //   шаблонов в 32 бита укладываются.
+        size_t digits[ Geometry::MAX_CELLS ];
+        size_t sum = 0;
+        size_t j = count;
+        for ( ; (j > 0) && (rank > 0xFFFFFFFFULL); --j) {
+            const uint64_t base = cells - j + 1;
+            const uint64_t q = rank / base;
+            digits[ j - 1 ] = static_cast< size_t >( rank - q * base );
+            rank = q;
+        }
+        for (uint32_t r = static_cast< uint32_t >( rank ); j > 0; --j) {
+            const uint32_t base = static_cast< uint32_t >( cells - j + 1 );
+            const uint32_t q = r / base;
+            digits[ j - 1 ] = r - q * base;
+            r = q;
+        }
+
+        uint64_t used[ WORDS ] = {};
+        for ( ; j < count; ++j) {
+            size_t d = digits[ j ];
+            size_t w = 0;
+            for ( ; ; ++w) {
+                const size_t free = bitCount( ~used[ w ] );
+                if (d < free) {
+                    break;
+                }
+                d -= free;
+            }
+            sum += digits[ j ];
+            const size_t b = select( ~used[ w ], d );
+            used[ w ] |= uint64_t( 1 ) << b;
+            positions[ j ] = static_cast< int >( w * 64 + b );
+        }
+        return sum;
+    }
+
+
+    // @return Количество размещений: cells! / (cells - count)!
+    static inline uint64_t arrangements( size_t count, size_t cells ) {
+        uint64_t a = 1;
+        for (size_t j = 0; j < count; ++j) {
+            a *= (cells - j);
+        }
+        return a;
+    }
+
+
+    // @return Номер перестановки поля среди cells! - по местам элементов
+    //         0, 1, ...
+    // @throw Exception Если поле пустое, в нём больше MAX_FIELD ячеек или
+    //        элементы - не перестановка 0 .. cells - 1.
+    static uint64_t rank( const PuzzleN::field_t& );
+
+
+    // Обратное к rank( field_t ): поле размера 'field'.
+    // @throw Exception Если в поле больше MAX_FIELD ячеек или 'rank'
+    //        не меньше количества перестановок (ячеек!).
+    static void unrank( uint64_t rank,  PuzzleN::field_t& field );
+
+
+    // @return Количество единичных битов.
+    // # Без инструкции popcnt __builtin_popcountll - вызов библиотеки:
+    //   считаем параллельно по полям битов.
+    static inline size_t bitCount( uint64_t word ) {
+#if defined( _MSC_VER )
+        return static_cast< size_t >( __popcnt64( word ) );
+#elif defined( __POPCNT__ )
+        return static_cast< size_t >( __builtin_popcountll( word ) );
+#else
+        word = word - ((word >> 1) & 0x5555555555555555ULL);
+        word = (word & 0x3333333333333333ULL) + ((word >> 2) & 0x3333333333333333ULL);
+        word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+        return static_cast< size_t >( (word * 0x0101010101010101ULL) >> 56 );
+#endif
+    }
+
+
+    // @return Номер младшего единичного бита; 'word' не 0.
+    static inline size_t lowestBit( uint64_t word ) {
+        DASSERT( word != 0 );
+#ifdef _MSC_VER
+        unsigned long b;
+        _BitScanForward64( &b, word );
+        return static_cast< size_t >( b );
+#else
+        return static_cast< size_t >( __builtin_ctzll( word ) );
+#endif
+    }
+
+
+    // @return Номер единичного бита, перед которым 'k' единичных.
+    // # Пропускаем байты целиком, в байте - по таблице.
+    static inline size_t select( uint64_t word, size_t k ) {
+        size_t base = 0;
+        for (size_t c = BYTE_BITS[ word & 0xFF ]; k >= c; c = BYTE_BITS[ word & 0xFF ]) {
+            k -= c;
+            word >>= 8;
+            base += 8;
+        }
+        return base + BYTE_SELECT[ (word & 0xFF) * 8 + k ];
+    }
+
+
+private:
+    // Заполняет таблицы байтов.
+    // @return true
+    static bool fill();
+
+
+private:
+    // единичных битов в байте; номер k-го единичного бита байта 'b' -
+    // [ b * 8 + k ]
+    static uint8_t  BYTE_BITS[ 256 ];
+    static uint8_t  BYTE_SELECT[ 256 * 8 ];
+
+    // # Таблицы заполняются при инициализации статических данных, до
+    //   main(): конструкторы статических объектов Ranking не вызывают.
+    static const bool  mFilled;
+};
+
+
+} // puzzlen
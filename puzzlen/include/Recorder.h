@@ -0,0 +1,99 @@
+#pragma once
+
+#include "configure.h"
+#include "PuzzleN.h"
+
+
+namespace puzzlen {
+
+
+// Запись событий ввода, которые окно передаёт в PuzzleN (см. wndProc()).
+// # Запись детерминирована: Replayer повторяет её на другом PuzzleN и
+//   получает то же поле и то же состояние перетаскивания (move_t).
+// # Формат - поток байтов; числа - varint (по 7 бит, младшие вперёд),
+//   знаковые - zigzag. От порядка байтов не зависит.
+//     "PZNR" FORMAT_VERSION N M cellSize  поле[ N * M ]
+//     событие: тип  dt (мкс от прошлого события)  данные
+//       PRESS    x y        - нажата кнопка мыши (абсолютные координаты)
+//       MOVE     dx dy      - мышь сдвинулась от прошлой точки
+//       RELEASE             - кнопка отпущена
+//       SHUFFLE  seed       - поле перетасовано с зерном seed
+//       END      поле[ N * M ]  move_t - итоговое состояние, см. finish()
+//       UNDO / REDO         - ход отменён / повторён (см. PuzzleN::undo())
+// # Версия 2 - с событиями UNDO / REDO. Записи версии 1 (без них)
+//   Replayer тоже читает.
+// # Событие мыши - обычно 4..6 байтов.
+class Recorder {
+public:
+    typedef uint64_t  time_t;
+
+    enum event_t {
+        PRESS = 1,
+        MOVE,
+        RELEASE,
+        SHUFFLE,
+        END,
+        UNDO,
+        REDO
+    };
+
+    static const char     MAGIC[ 4 ];
+    static const uint8_t  FORMAT_VERSION = 2;
+
+
+public:
+    // Начинает запись с текущего поля.
+    explicit Recorder( const PuzzleN& );
+
+
+    virtual ~Recorder();
+
+
+    // События, уже переданные в PuzzleN. Время - мкс от любого начала.
+    void press( int x, int y, time_t now );
+    void move( int x, int y, time_t now );
+    void release( time_t now );
+    void shuffle( uint64_t seed, time_t now );
+    void undo( time_t now );
+    void redo( time_t now );
+
+
+    // Дописывает итоговое состояние PuzzleN. После - событий не будет.
+    void finish();
+
+
+    inline std::vector< uint8_t > const& data() const { return mData; }
+
+    // @return Сколько событий записано.
+    inline size_t events() const { return mEvents; }
+
+
+    // @throw Exception Если файл не записать.
+    void save( const std::string& file ) const;
+
+
+private:
+    void event( event_t, time_t now );
+
+    void put( uint64_t );
+    void putSigned( int64_t );
+    void putState();
+
+
+private:
+    const PuzzleN&  mPuzzle;
+
+    std::vector< uint8_t >  mData;
+    size_t  mEvents;
+    bool  mFinished;
+
+    time_t  mLast;
+    bool  mStarted;
+
+    // прошлая точка мыши
+    int  mX;
+    int  mY;
+};
+
+
+} // puzzlen
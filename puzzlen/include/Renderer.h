@@ -0,0 +1,72 @@
+#pragma once
+
+#include "configure.h"
+#include "Framebuffer.h"
+#include "PuzzleN.h"
+
+
+namespace puzzlen {
+
+
+// Программная визуализация пятнашек в Framebuffer: без окна и GDI+.
+// # Повторяет Painter: спрайты элементов рисуются один раз в атлас
+//   (ячейка с рамкой + номер), кадр копирует ячейки атласа.
+// # Умеет перерисовывать только изменившиеся области (PuzzleN::damage())
+//   поверх прошлого кадра и считает записанные пиксели.
+// # Кадр не выделяет памяти: рисует в готовый Framebuffer (см. FramePool).
+class Renderer {
+public:
+    static const Framebuffer::pixel_t  BACKGROUND = 0xFFFFFFFF;
+    static const Framebuffer::pixel_t  TILE       = 0xFFF0D9B5;
+    static const Framebuffer::pixel_t  BORDER     = 0xFF8B5A2B;
+    static const Framebuffer::pixel_t  TEXT       = 0xFFA90000;
+
+
+public:
+    explicit Renderer( const PuzzleN& );
+
+
+    // Рисует спрайтами из готового атласа (например, из Painter).
+    // # Элемент e - в ячейке атласа e - 1; атлас размером с поле.
+    // @throw Exception Если размер атласа не совпал с полем.
+    Renderer( const PuzzleN&,  const Framebuffer& atlas );
+
+
+    virtual ~Renderer();
+
+
+    // Перерисовывает области 'damage' в кадре, где лежит прошлый кадр.
+    // @return Сколько пикселей записано.
+    size_t draw( Framebuffer&,  const PuzzleN::damage_t& ) const;
+
+
+    // Рисует кадр целиком.
+    // @return Сколько пикселей записано.
+    size_t drawAll( Framebuffer& ) const;
+
+
+    inline Framebuffer const& atlas() const { return mAtlas; }
+
+
+private:
+    // Рисует всё, что попадает в 'region'.
+    size_t drawRegion( Framebuffer&,  const Framebuffer::rect_t& region ) const;
+
+
+    // Рисует спрайты всех элементов в атлас.
+    // # Элемент e лежит в ячейке атласа e - 1, как в Painter.
+    void prepareAtlas();
+
+
+    // Пишет номер элемента по центру ячейки атласа (x; y).
+    void drawNumber( PuzzleN::element_t,  int x,  int y );
+
+
+private:
+    const PuzzleN&  mPuzzle;
+
+    Framebuffer  mAtlas;
+};
+
+
+} // puzzlen
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "configure.h"
+#include "PuzzleN.h"
+#include "Recorder.h"
+
+
+namespace puzzlen {
+
+
+// Воспроизводит запись Recorder на PuzzleN без окна и с наибольшей
+// скоростью: для отладки и профилирования перетаскивания.
+// # События отрабатываются так же, как в wndProc().
+// # Запись разбирается и проверяется один раз, при создании.
+class Replayer {
+public:
+    typedef Recorder::time_t  time_t;
+
+
+public:
+    // @throw Exception Если данные - не запись Recorder или повреждены.
+    explicit Replayer( const std::vector< uint8_t >& );
+
+
+    virtual ~Replayer();
+
+
+    // @return Содержимое файла записи.
+    // @throw Exception Если файл не прочитать.
+    static std::vector< uint8_t > load( const std::string& file );
+
+
+    // Расставляет поле начала записи и повторяет на 'puzzle' все события.
+    // @return Сколько событий повторено.
+    // @throw Exception Если поле другого размера.
+    size_t replay( PuzzleN& ) const;
+
+
+    // @return В записи есть итоговое состояние (см. Recorder::finish()).
+    inline bool finished() const { return mFinished; }
+
+
+    // @return Поле и состояние перетаскивания совпали с итоговыми.
+    bool verify( const PuzzleN& ) const;
+
+
+    inline size_t events() const { return mEvents; }
+
+
+    // @return Длительность записи, мкс.
+    inline time_t duration() const { return mDuration; }
+
+
+public:
+    size_t  N;
+    size_t  M;
+    size_t  cellSize;
+
+
+private:
+    std::vector< uint8_t >  mData;
+    // где начинаются события
+    size_t  mBegin;
+    // где кончаются события (END или конец данных)
+    size_t  mEnd;
+
+    PuzzleN::field_t  mInitial;
+
+    bool  mFinished;
+    PuzzleN::field_t  mFinalField;
+    PuzzleN::move_t  mFinalMove;
+
+    size_t  mEvents;
+    time_t  mDuration;
+};
+
+
+} // puzzlen
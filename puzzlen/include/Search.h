@@ -0,0 +1,245 @@
+#pragma once
+
+#include "configure.h"
+#include "Geometry.h"
+#include "Perimeter.h"
+#include "PuzzleN.h"
+#include <atomic>
+#include <limits>
+
+
+namespace puzzlen {
+
+
+// Поиск IDA* по дереву ходов с эвристикой H (см. Heuristic.h).
+// # Своё поле, эвристика и путь: на поток - свой Search.
+// # Ходы делаются и отменяются на месте, в узлах память не выделяется.
+// # С периметром (см. Perimeter) поиск двунаправленный: идёт от поля
+//   навстречу периметру вокруг собранного поля и заканчивается на нём.
+template< class H >
+class Search {
+public:
+    // Решение найдено.
+    static const int FOUND = -1;
+
+    static const int INFINITE_COST = std::numeric_limits< int >::max();
+
+
+public:
+    Search( const Geometry& geometry, const H& heuristic ) :
+        mGeometry( geometry ),
+        mHeuristic( heuristic ),
+        mTiles( geometry.cells, 0 ),
+        mBlank( 0 ),
+        mPrefix( 0 ),
+        mDepth( 0 ),
+        mNodes( 0 ),
+        mPerimeter( nullptr ),
+        mStop( nullptr ),
+        mLimit( std::numeric_limits< uint64_t >::max() )
+    {
+    }
+
+
+    // Расставляет элементы, считает эвристику с нуля.
+    void reset( const PuzzleN::field_t& field ) {
+        DASSERT( field.size() == mGeometry.cells );
+        for (size_t i = 0; i < mGeometry.cells; ++i) {
+            mTiles[ i ] = static_cast< uint8_t >( field[ i ] );
+            if (field[ i ] == PuzzleN::EMPTY_ELEMENT) {
+                mBlank = static_cast< int >( i );
+            }
+        }
+        mHeuristic.reset( mTiles.data() );
+        mPrefix = 0;
+        mDepth = 0;
+        mNodes = 0;
+    }
+
+
+    // Делает ход в направлении 'd' до поиска: iterate() продолжит с этого
+    // узла, ходы войдут в начало решения.
+    // @return false, если ход невозможен.
+    bool push( int d ) {
+        const int from = mGeometry.source( mBlank, d );
+        if (from < 0) {
+            return false;
+        }
+        if (mPath.size() <= static_cast< size_t >( mPrefix )) {
+            mPath.resize( mPrefix + 1 );
+        }
+        shift( from );
+        mPath[ mPrefix++ ] = static_cast< char >( d );
+        return true;
+    }
+
+
+    // Подключает периметр вокруг собранного поля; nullptr - отключает.
+    inline void perimeter( const Perimeter* perimeter ) { mPerimeter = perimeter; }
+
+
+    // Флаг, по которому поиск прерывается (решение нашёл другой поток).
+    inline void stop( const std::atomic< bool >* flag ) { mStop = flag; }
+
+
+    // Наибольшее количество узлов с reset(): дальше поиск прерывается, как
+    // по stop(). Для ответов за ограниченное время (см. Hint).
+    inline void limit( uint64_t nodes ) { mLimit = nodes; }
+
+
+    // Один проход в глубину с порогом 'bound'.
+    // @return FOUND или наименьшая оценка, вышедшая за порог.
+    //         Прерванный поиск возвращает INFINITE_COST.
+    int iterate( int bound ) {
+        if (mPath.size() < static_cast< size_t >( bound ) + 1) {
+            mPath.resize( bound + 1 );
+        }
+        mDepth = 0;
+        const int prev = (mPrefix > 0) ? mPath[ mPrefix - 1 ] : -1;
+        return dfs( mPrefix, bound, prev );
+    }
+
+
+    // @return Оценка снизу для текущего поля.
+    inline int estimate() const { return mHeuristic.value(); }
+
+
+    inline uint64_t nodes() const { return mNodes; }
+
+
+    // @return Ходы найденного решения.
+    std::string moves() const {
+        std::string  s( mDepth, ' ' );
+        for (int k = 0; k < mDepth; ++k) {
+            s[ k ] = PuzzleN::DIRECTION_NAME[ static_cast< int >( mPath[ k ] ) ];
+        }
+        return s;
+    }
+
+
+private:
+    int dfs( int g, int bound, int prev ) {
+
+        ++mNodes;
+        if ( (mNodes > mLimit) || (mStop && mStop->load( std::memory_order_relaxed )) ) {
+            return INFINITE_COST;
+        }
+
+        const int h = mHeuristic.value();
+        int f = g + h;
+        // # Эвристика не превышает расстояния: если она больше глубины
+        //   периметра, поле точно за ним - искать в таблице незачем.
+        if ( mPerimeter && (h <= mPerimeter->depth()) ) {
+            const int d = mPerimeter->distance( mTiles.data() );
+            if (d >= 0) {
+                if (g + d > bound) {
+                    return g + d;
+                }
+                descend( g, d );
+                return FOUND;
+            }
+            // # Каждый ход сдвигает пустую ячейку на одну клетку: чётность
+            //   расстояния - чётность пути пустой ячейки к её месту.
+            const int goal = static_cast< int >( mGeometry.cells ) - 1;
+            const int parity = (
+                std::abs( mGeometry.row( mBlank ) - mGeometry.row( goal ) ) +
+                std::abs( mGeometry.column( mBlank ) - mGeometry.column( goal ) )
+            ) & 1;
+            const int beyond = mPerimeter->depth() + 1;
+            f = std::max( f,  g + beyond + ((beyond ^ parity) & 1) );
+        }
+        if (f > bound) {
+            return f;
+        }
+        if (h == 0) {
+            mDepth = g;
+            return FOUND;
+        }
+
+        int min = INFINITE_COST;
+        const int blank = mBlank;
+        for (int d = 0; d < 4; ++d) {
+            // не отменяем предыдущий ход
+            if (d == (prev ^ 1)) {
+                continue;
+            }
+            const int from = mGeometry.source( blank, d );
+            if (from < 0) {
+                continue;
+            }
+
+            shift( from );
+            mPath[ g ] = static_cast< char >( d );
+
+            const int t = dfs( g + 1, bound, d );
+
+            // отменяем ход: элемент возвращается на место
+            shift( blank );
+
+            if (t == FOUND) {
+                return FOUND;
+            }
+            if (t < min) {
+                min = t;
+            }
+        }
+
+        return min;
+    }
+
+
+    // Дописывает к пути 'g' ходов остаток решения по периметру: на каждом
+    // шаге - ход к расстановке, которая на ход ближе к сборке.
+    void descend( int g, int d ) {
+        for ( ; d > 0; --d) {
+            const int blank = mBlank;
+            for (int dir = 0; dir < 4; ++dir) {
+                const int from = mGeometry.source( blank, dir );
+                if (from < 0) {
+                    continue;
+                }
+                shift( from );
+                if (mPerimeter->distance( mTiles.data() ) == d - 1) {
+                    mPath[ g++ ] = static_cast< char >( dir );
+                    break;
+                }
+                shift( blank );
+            }
+        }
+        mDepth = g;
+    }
+
+
+    // Сдвигает элемент из 'from' в пустую ячейку.
+    inline void shift( int from ) {
+        const int to = mBlank;
+        const int tile = mTiles[ from ];
+        mTiles[ to ]   = static_cast< uint8_t >( tile );
+        mTiles[ from ] = static_cast< uint8_t >( PuzzleN::EMPTY_ELEMENT );
+        mBlank = from;
+        mHeuristic.shift( mTiles.data(), tile, from, to );
+    }
+
+
+private:
+    const Geometry&  mGeometry;
+    H  mHeuristic;
+
+    std::vector< uint8_t >  mTiles;
+    int  mBlank;
+
+    // ходы: сделанные push() и найденные поиском
+    std::vector< char >  mPath;
+    int  mPrefix;
+    int  mDepth;
+
+    uint64_t  mNodes;
+
+    const Perimeter*  mPerimeter;
+
+    const std::atomic< bool >*  mStop;
+    uint64_t  mLimit;
+};
+
+
+} // puzzlen
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "configure.h"
+#include "PuzzleN.h"
+#include <atomic>
+#include <mutex>
+#include <type_traits>
+
+
+namespace puzzlen {
+
+
+// Партии сервера (см. Host): тысячи PuzzleN, к которым одновременно
+// обращаются из разных потоков.
+// # Партии разложены по шардам (по кругу при открытии), у шарда - своя
+//   блокировка: ходы в разных шардах друг друга не ждут.
+// # Память шарда - блоки по SESSION_SLAB ячеек, PuzzleN строится прямо
+//   в ячейке. Ячейка закрытой партии идёт в список свободных вместе с
+//   построенным полем: партия того же размера открывается в ней без
+//   выделения памяти (поле и история уже есть), другого - поле строится
+//   заново.
+// # Номер партии - поколение ячейки (старшие 32 бита) и номер ячейки
+//   среди всех шардов. Поколение растёт при каждом открытии: номер
+//   закрытой партии не попадёт в новую партию в той же ячейке. 0 - не
+//   номер партии.
+class Sessions {
+public:
+    typedef uint64_t  id_t;
+
+
+public:
+    // @param shards  Количество шардов; 0 - SESSION_SHARDS.
+    explicit Sessions( size_t shards );
+
+
+    virtual ~Sessions();
+
+
+    // Открывает партию: поле n x m, перетасованное с зерном 'seed' (см.
+    // PuzzleN::shuffle()).
+    // @return Номер партии.
+    // @throw Exception Если сторона поля вне [2; SESSION_MAX_SIDE] или
+    //        ячейки кончились.
+    id_t open( size_t n,  size_t m,  uint64_t seed );
+
+
+    // @return Была ли партия открыта.
+    bool close( id_t );
+
+
+    // Вызывает f( PuzzleN& ) для открытой партии под блокировкой её шарда.
+    // @return Открыта ли партия.
+    template< class F >
+    bool with( id_t,  F&& f );
+
+
+    // @return Открытых партий.
+    inline size_t size() const { return mSize.load( std::memory_order_relaxed ); }
+
+
+    inline size_t shards() const { return mShards.size(); }
+
+
+private:
+    typedef struct {
+        typename std::aligned_storage< sizeof( PuzzleN ), alignof( PuzzleN ) >::type  storage;
+        uint32_t  generation;
+        // в 'storage' построен PuzzleN; остаётся и после закрытия партии
+        bool  built;
+        bool  open;
+    } slot_t;
+
+
+    typedef struct {
+        std::mutex  mutex;
+        std::vector< std::unique_ptr< slot_t[] > >  slabs;
+        // номера свободных ячеек шарда; последний - следующий
+        std::vector< uint32_t >  free;
+    } shard_t;
+
+
+    static inline PuzzleN& puzzle( slot_t& slot ) {
+        return *reinterpret_cast< PuzzleN* >( &slot.storage );
+    }
+
+
+    // @return Ячейка открытой партии 'id' или nullptr. Шард заблокирован.
+    slot_t* find( shard_t&,  id_t );
+
+
+    // @return Шард партии 'id'.
+    inline shard_t& shardOf( id_t id ) {
+        return *mShards[ static_cast< uint32_t >( id ) % mShards.size() ];
+    }
+
+
+private:
+    std::vector< std::unique_ptr< shard_t > >  mShards;
+
+    // шард для следующей партии
+    std::atomic< size_t >  mNext;
+    std::atomic< size_t >  mSize;
+};
+
+
+
+
+template< class F >
+bool
+Sessions::with( id_t id,  F&& f ) {
+
+    shard_t& shard = shardOf( id );
+    std::lock_guard< std::mutex >  lock( shard.mutex );
+    slot_t* slot = find( shard, id );
+    if ( !slot ) {
+        return false;
+    }
+    f( puzzle( *slot ) );
+    return true;
+}
+
+
+} // puzzlen
@@ -0,0 +1,176 @@
+#pragma once
+
+#include "configure.h"
+#include "Geometry.h"
+#include "Patterns.h"
+#include "Perimeter.h"
+#include "PuzzleN.h"
+#include "ThreadPool.h"
+#include "Walking.h"
+
+
+namespace puzzlen {
+
+
+// Оптимальный решатель пятнашек: IDA*.
+// # Эвристика - манхэттенское расстояние + линейные конфликты, walking
+//   distance (см. Walking) или, если подключены, аддитивные базы
+//   шаблонов (см. Patterns).
+// # Работает на PuzzleN::field_t для любого поля N x M. Эвристика при ходе
+//   обновляется только по затронутым строкам, столбцам или шаблону. Ходы
+//   делаются и отменяются на месте: в узлах поиска память не выделяется.
+// # С пулом потоков дерево делится на поддеревья на небольшой глубине
+//   (см. split()); поддеревья ищутся параллельно с общим порогом, первое
+//   найденное решение оптимально и останавливает остальные потоки.
+// # Двунаправленный режим (см. bidirectional()): от собранного поля
+//   один раз строится периметр (Perimeter), поиск от поля идёт ему
+//   навстречу. Решения те же, узлов меньше.
+class Solver {
+public:
+    // Эвристика без баз шаблонов.
+    enum heuristic_t {
+        // манхэттенское расстояние + линейные конфликты
+        CONFLICT = 0,
+        // walking distance
+        WALKING
+    };
+
+    // Имена для параметров командной строки, по индексу heuristic_t.
+    static const char* const  HEURISTIC_NAME[];
+
+    // @return Эвристика по имени из HEURISTIC_NAME.
+    // @throw Exception Если такой нет.
+    static heuristic_t heuristicByName( const std::string& );
+
+
+    typedef struct {
+        // Ходы решения, буквами PuzzleN::DIRECTION_NAME.
+        std::string  moves;
+        // Сколько узлов раскрыто.
+        uint64_t  nodes;
+        // Время поиска, с.
+        double  seconds;
+    } result_t;
+
+
+public:
+    Solver( size_t n, size_t m );
+
+
+    virtual ~Solver();
+
+
+    // Подключает базы шаблонов; nullptr - отключает.
+    // @throw Exception Если базы построены для поля другого размера.
+    void patterns( const std::shared_ptr< const Patterns >& );
+
+    inline std::shared_ptr< const Patterns > const& patterns() const {
+        return mPatterns;
+    }
+
+
+    // Выбирает эвристику. Для WALKING строит таблицы (см. Walking).
+    // # Базы шаблонов, если подключены, важнее.
+    // @throw Exception Если таблицы слишком велики для поля.
+    void heuristic( heuristic_t );
+
+    inline heuristic_t heuristic() const {
+        return mWalking ? WALKING : CONFLICT;
+    }
+
+    inline std::shared_ptr< const Walking > const& walking() const {
+        return mWalking;
+    }
+
+
+    // Подключает пул потоков для параллельного поиска; nullptr - ищем в
+    // вызывающем потоке.
+    // # Пул занимается одним решением за раз: решатели, которые делят пул,
+    //   не должны вызывать solve() одновременно.
+    inline void pool( const std::shared_ptr< ThreadPool >& pool ) {
+        mPool = pool;
+    }
+
+    inline std::shared_ptr< ThreadPool > const& pool() const {
+        return mPool;
+    }
+
+
+    // Включает двунаправленный поиск: строит периметр вокруг собранного
+    // поля, не больше 'budget' байт. 0 - выключает.
+    // # Если бюджета мало, периметр мельче; если не хватает даже на
+    //   первый слой - поиск остаётся однонаправленным (depth() == 0).
+    // # Строится здесь, а не в solve(): solve() можно вызывать из
+    //   нескольких потоков.
+    void bidirectional( size_t budget );
+
+    inline std::shared_ptr< const Perimeter > const& perimeter() const {
+        return mPerimeter;
+    }
+
+
+    // @return Оптимальное решение для расстановки.
+    // @throw Exception Если расстановка не решаема.
+    result_t solve( const PuzzleN::field_t& ) const;
+
+
+    // Ищет решение не длиннее 'bound' ходов, раскрыв не больше 'limit'
+    // узлов: для ответов за ограниченное время (см. Hint). Без пула
+    // потоков.
+    // # Пороги IDA* - от оценки до 'bound': найденное решение оптимально.
+    // @return Найдено ли решение. Если нет и result.nodes > limit - узлов
+    //         не хватило; иначе решения не длиннее 'bound' нет.
+    // @throw Exception Если расстановка не решаема.
+    bool solve(
+        const PuzzleN::field_t&,  int bound,  uint64_t limit,  result_t&
+    ) const;
+
+
+    // @return Оценка снизу для количества ходов до решения.
+    int estimate( const PuzzleN::field_t& ) const;
+
+
+    inline Geometry const& geometry() const { return mGeometry; }
+
+
+public:
+    const size_t  N;
+    const size_t  M;
+
+
+    // Поддеревьев на поток в параллельном поиске: с запасом, чтобы потоки
+    // выравнивали нагрузку, перехватывая задачи.
+    static const size_t TASKS_PER_THREAD = 64;
+
+    static const size_t MAX_SPLIT_DEPTH = 24;
+
+
+private:
+    template< class H >
+    result_t solve( const H&, const PuzzleN::field_t& ) const;
+
+    template< class H >
+    result_t solveParallel( const H&, const PuzzleN::field_t& ) const;
+
+    template< class H >
+    bool solve(
+        const H&,  const PuzzleN::field_t&,  int bound,  uint64_t limit,  result_t&
+    ) const;
+
+
+    // @return Начала путей одной длины (ходы без возвратов) от пустой
+    //         ячейки 'blank': самая малая длина, при которой путей не
+    //         меньше 'count'.
+    std::vector< std::string > split( int blank, size_t count ) const;
+
+
+private:
+    Geometry  mGeometry;
+    std::shared_ptr< const Patterns >  mPatterns;
+    std::shared_ptr< const Walking >  mWalking;
+    std::shared_ptr< ThreadPool >  mPool;
+    std::shared_ptr< const Perimeter >  mPerimeter;
+};
+
+
+} // puzzlen
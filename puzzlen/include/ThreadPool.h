@@ -0,0 +1,87 @@
+#pragma once
+
+#include "configure.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+
+namespace puzzlen {
+
+
+// Пул потоков с перехватом задач (work stealing).
+// # У каждого потока своя очередь: свои задачи он берёт с конца (последние
+//   поставленные - горячие в кэше), а когда очередь пуста - забирает
+//   задачи с начала чужих очередей.
+// # Задача получает номер потока [0; size()): по нему она находит
+//   состояние, заведённое заранее на каждый поток.
+class ThreadPool {
+public:
+    typedef std::function< void( size_t worker ) >  task_t;
+
+
+public:
+    // @param threads  Количество потоков; 0 - по количеству ядер.
+    explicit ThreadPool( size_t threads );
+
+
+    virtual ~ThreadPool();
+
+
+    // Ставит задачу в очередь. Из потока пула - в очередь этого потока,
+    // извне - в очереди потоков по кругу.
+    void submit( const task_t& );
+
+
+    // Ждёт, пока не будут выполнены все поставленные задачи.
+    void wait();
+
+
+    // # Очереди заводятся до запуска потоков: size() читается потоками и
+    //   во время конструктора.
+    inline size_t size() const { return mQueues.size(); }
+
+
+    // @return Сколько задач забрано из чужих очередей.
+    inline uint64_t steals() const { return mSteals.load(); }
+
+
+private:
+    typedef struct {
+        std::mutex  mutex;
+        std::deque< task_t >  tasks;
+    } queue_t;
+
+
+    void run( size_t worker );
+
+
+    // Берёт задачу из своей очереди или из чужой.
+    bool take( size_t worker, task_t& );
+
+
+    // @return Номер потока пула, в котором выполняется вызов, или size().
+    size_t current() const;
+
+
+private:
+    std::vector< std::unique_ptr< queue_t > >  mQueues;
+    std::vector< std::thread >  mThreads;
+
+    std::mutex  mMutex;
+    std::condition_variable  mWake;
+    std::condition_variable  mDone;
+    // поставлено, но ещё не взято / ещё не выполнено
+    size_t  mQueued;
+    size_t  mPending;
+    bool  mStop;
+
+    std::atomic< size_t >  mNext;
+    std::atomic< uint64_t >  mSteals;
+};
+
+
+} // puzzlen
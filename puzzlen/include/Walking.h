@@ -0,0 +1,108 @@
+#pragma once
+
+#include "configure.h"
+#include "Geometry.h"
+#include <map>
+
+
+namespace puzzlen {
+
+
+// Таблицы "walking distance" для поля N x M.
+// # По вертикали поле сводится к матрице M x M: сколько элементов в
+//   строке r должны стоять в строке g. Вертикальный ход - пустая ячейка
+//   меняется с элементом соседней строки: матрица меняется в двух
+//   клетках. Поиском в ширину от собранного поля находим, за сколько
+//   вертикальных ходов собирается каждая матрица. По горизонтали -
+//   то же по столбцам. Сумма двух расстояний - оценка снизу: ходы
+//   по вертикали и по горизонтали не пересекаются.
+// # В отличие от манхэттенского расстояния, учитывает, что элементы
+//   одной строки мешают друг другу.
+// # Таблица оси - расстояния и переходы по индексам матриц: ход меняет
+//   индекс за одно обращение (см. WalkingHeuristic). Матрицы нужны
+//   только reset().
+// # Строятся один раз на размер поля и только читаются - общие для всех
+//   поисков и потоков. У квадратного поля таблица одна на обе оси.
+class Walking {
+public:
+    typedef uint32_t  id_t;
+
+    static const id_t  NONE = ~id_t( 0 );
+
+    // Меньше матриц по оси - переходы хранятся 16-битными индексами.
+    static const size_t NARROW_STATES = 0xFFFF;
+
+
+    // Таблица одной оси: L линий (строк или столбцов) по C ячеек.
+    typedef struct {
+        size_t  lines;
+        size_t  cells;
+
+        // ходов до сборки, по индексу матрицы
+        std::vector< uint8_t >  distance;
+
+        // индекс после хода: [ (id * 2 + from) * lines + goal ], где
+        // from - 0, если элемент пришёл из предыдущей линии, 1 - из
+        // следующей; goal - линия, где элементу место
+        // # До NARROW_STATES матриц (4 x 4 - 24964) - next16: таблица
+        //   вдвое меньше (~400 Кб на 4 x 4) и остаётся в L2. Иначе -
+        //   next32. Читать через next().
+        bool  narrow;
+        std::vector< uint16_t >  next16;
+        std::vector< id_t >  next32;
+
+        inline id_t next( size_t k ) const {
+            return narrow ? next16[ k ] : next32[ k ];
+        }
+
+        // матрица (по линиям: элементов с местом в линии 0, 1, ...) - индекс
+        std::map< std::vector< uint8_t >, id_t >  index;
+    } table_t;
+
+
+public:
+    // @throw Exception Если у поля больше WALKING_MAX_STATES матриц по
+    //        одной из осей.
+    explicit Walking( const Geometry& );
+
+
+    virtual ~Walking();
+
+
+    // @return Индекс матрицы расстановки по строкам / столбцам.
+    id_t rowId( const uint8_t* tiles ) const;
+    id_t columnId( const uint8_t* tiles ) const;
+
+
+    inline table_t const& rows() const { return *mRows; }
+    inline table_t const& columns() const { return *mColumns; }
+
+
+    // @return Память таблиц, байт (без матриц для reset()).
+    size_t bytes() const;
+
+
+    inline Geometry const& geometry() const { return mGeometry; }
+
+
+private:
+    // Строит таблицу оси из 'lines' линий по 'cells' ячеек.
+    // # Пустая ячейка собранного поля - в последней линии.
+    static std::unique_ptr< table_t > build( size_t lines,  size_t cells );
+
+
+    // @return Индекс матрицы 'tiles' по оси.
+    // @param line  Линия ячейки / места элемента по оси.
+    template< class F >
+    id_t id( const table_t&,  const uint8_t* tiles,  F line ) const;
+
+
+private:
+    const Geometry&  mGeometry;
+
+    std::shared_ptr< const table_t >  mRows;
+    std::shared_ptr< const table_t >  mColumns;
+};
+
+
+} // puzzlen
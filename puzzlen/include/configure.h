@@ -7,41 +7,150 @@
 namespace puzzlen {
 
 
-//   .
+// Путь к изображениям.
 static const std::wstring  PATH_MEDIA = L"../media";
 
 
 
 
-//    .
+// Размер поля по умолчанию.
 static const size_t DEFAULT_N = 4;
 static const size_t DEFAULT_M = DEFAULT_N;
 
 
 
 
-// ,      ""  , %.
+// Расстояние, при котором смещаемый элемент сам "прилипнет" к соседу, %.
 static const size_t GLUE_PERCENT = 20;
 
 
 
 
-//    .
+// Размер ячейки в пкс.
 static const size_t CELL_SIZE = 50;
 
 
 
 
-//  .
+// Наименьший промежуток между кадрами, мкс (60 кадров/с).
+// # Кадры рисуются только после изменений, см. FrameScheduler.
+static const size_t FRAME_INTERVAL = 16667;
+
+
+
+
+// Сколько задних буферов разных размеров хранить (см. FramePool).
+static const size_t FRAME_POOL_CAPACITY = 4;
+
+
+
+
+// Куда окно записывает замеры (см. Instrument) по F12 и при выходе.
+// # Замеры есть только в сборке с PUZZLEN_INSTRUMENT.
+static const std::string  INSTRUMENT_FILE = "puzzlen-instrument.txt";
+
+
+
+
+// Сколько ходов история партии (History) окна вмещает без выделения
+// памяти: 64 K ходов - 16 Кб (см. PuzzleN::reserveHistory()).
+static const size_t HISTORY_RESERVE = 65536;
+
+
+
+
+// Сервер партий (см. Sessions, Host): шарды - у каждого своя блокировка;
+// партий в одном блоке памяти шарда; наибольшая сторона поля партии.
+// # Партия - PuzzleN, история растёт по мере ходов: сотни байт на 4 x 4,
+//   10 000 партий - ~2 Мб.
+static const size_t SESSION_SHARDS = 16;
+static const size_t SESSION_SLAB = 256;
+static const size_t SESSION_MAX_SIDE = 16;
+
+// UNIX-сокет сервера партий по умолчанию (puzzlen-host, puzzlen-load).
+static const std::string  HOST_SOCKET = "puzzlen-host.sock";
+
+
+
+
+// Узлов поиска на подсказку (см. Hint), когда игрок отошёл от плана:
+// ~20 мс на 4 x 4. Не хватило - подсказка без гарантии кратчайшего пути.
+static const uint64_t HINT_NODES = 1 << 18;
+
+
+
+
+// Наибольшая сторона поля в нагрузочных прогонах (puzzlen-sim --huge):
+// 65535 x 65535 ячеек ещё нумеруются 32-битными элементами (см. HugeBoard).
+static const size_t HUGE_MAX_SIDE = 65535;
+
+
+
+
+// Наибольшее количество матриц в таблице walking distance (см. Walking)
+// по одной оси. 4 x 4 - 24964 матрицы, 5 x 5 - больше миллиона.
+static const size_t WALKING_MAX_STATES = 1 << 21;
+
+
+
+
+// Наибольшее поле для полного перебора расстановок (см. Enumerator):
+// 12 ячеек - 239 500 800 расстановок, 60 Мб на 2 бита состояния и ещё
+// 240 Мб на таблицу расстояний. У 14 ячеек расстановок в 182 раза больше.
+static const size_t ENUMERATE_MAX_CELLS = 12;
+
+
+
+
+// Генератор полей заданной сложности (см. Generator): ожидаемых попыток
+// выборки из таблицы расстояний, после которых ищем k-ю подходящую
+// расстановку по порядку; сколько блужданий пробовать без таблицы;
+// до скольких ячеек puzzlen-generate сам строит таблицу (3 x 3 - 0.1 с).
+static const uint64_t GENERATE_REJECT = 1 << 10;
+static const uint64_t GENERATE_MAX_ATTEMPTS = 1 << 12;
+static const size_t GENERATE_TABLE_CELLS = 9;
+
+
+
+
+// Окно пакетного решателя (puzzlen-batch): полей на поток, которые можно
+// прочитать, пока не выведены предыдущие.
+static const size_t BATCH_WINDOW_PER_THREAD = 16;
+
+
+
+
+// Микробенчмарки (puzzlen-bench): время на замер, мс; прогонов в замере
+// (берётся лучший); поля для решателя и сколько ходов их перемешивает
+// на полях больше 3 x 3.
+static const size_t BENCH_TIME = 200;
+static const size_t BENCH_REPEATS = 3;
+static const size_t BENCH_SOLVE_BOARDS = 8;
+static const size_t BENCH_SOLVE_SCRAMBLE = 30;
+// периметр двунаправленного поиска, байт (см. Solver::bidirectional())
+static const size_t BENCH_BIDIRECTIONAL_BUDGET = 16 << 20;
+// размещения для замеров Ranking: сколько разных и по сколько элементов
+// (как в шаблоне 6-6-3)
+static const size_t BENCH_RANKING_INPUTS = 1024;
+static const size_t BENCH_RANKING_PATTERN = 6;
+
+
+
+
+// Для отладки.
 #ifdef _DEBUG
 #define ASSERT(EXPR)   assert(EXPR);
+#ifdef _MSC_VER
 #define DASSERT(EXPR)  if (!(EXPR)) __debugbreak();
+#else
+#define DASSERT(EXPR)  if (!(EXPR)) __builtin_trap();
+#endif
 
 #define QUOTE_(WHAT)      #WHAT
 #define QUOTE(WHAT)       QUOTE_(WHAT)
-#define DBG(format, ...)  printf("%s: "format, __FILE__":"QUOTE(__LINE__), ## __VA_ARGS__)
+#define DBG(format, ...)  printf("%s: " format, __FILE__ ":" QUOTE(__LINE__), ## __VA_ARGS__)
 
-//  PuzzleN    .
+// Состояние PuzzleN отразится в заголовке окна.
 //#define CONSOLE_DEBUG_PUZZLEN
 
 #else
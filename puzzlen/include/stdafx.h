@@ -1,9 +1,12 @@
 #pragma once
 
-//    WinDef.h
+// # Windows-часть нужна только визуализации (см. Painter). Ядро пятнашек
+//   (PuzzleN) собирается без неё - в т.ч. под Linux.
+#ifdef _WIN32
+// Отключим макрос в WinDef.h
 #define NOMINMAX
 
-//   GDI+
+// настройка для GDI+
 #undef WIN32_LEAN_AND_MEAN
 #define STRICT
 #include <windows.h>
@@ -11,8 +14,14 @@
 using std::min;
 using std::max;
 #include <GdiPlus.h>
+#include <windowsx.h>
+#endif
 
+#include <algorithm>
 #include <assert.h>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
 #include <iostream>
 #include <math.h>
 #include <memory>
@@ -20,6 +29,5 @@ using std::max;
 #include <string>
 #include <time.h>
 #include <vector>
-#include <windowsx.h>
 
 #include "Exception.h"
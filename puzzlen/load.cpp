@@ -0,0 +1,366 @@
+/**
+* Нагрузка на сервер партий (puzzlen-host): открывает партии, делает
+* случайные ходы из нескольких соединений и сверяет ответы с полями,
+* которые ведёт сам.
+*
+* Запускается из консоли командой
+*   "puzzlen-load [N [M]] [--socket FILE] [--connections C] [--sessions S]
+*                 [--commands K] [--seed S] [--serve SHARDS]"
+* Где N, M          - количество ячеек по ширине и высоте партий, [2; 16].
+*     --socket      - UNIX-сокет сервера, по умолчанию "puzzlen-host.sock".
+*     --connections - соединений (у каждого свой поток), по умолчанию 4.
+*     --sessions    - партий на все соединения, по умолчанию 1000.
+*     --commands    - команд на все соединения: ходы и каждая 16-я -
+*                     запрос поля. По умолчанию 100000.
+*     --seed        - зерно для партий и ходов.
+*     --serve       - поднять сервер с SHARDS шардами в этом же процессе:
+*                     для проверок без отдельного puzzlen-host.
+* Каждая партия дублируется у клиента (HugeBoard): результат хода,
+* собранность и поле должны совпасть с ответами сервера. Сообщает
+* скорость, команд/с, и по каждой команде p50 / p99 - с сокетом (у
+* клиента) и выполнения (у сервера, команда stats).
+* Пример: puzzlen-load --serve 16 --connections 8 --sessions 10000
+*         puzzlen-load 3 3 --socket /tmp/puzzlen.sock --commands 1000000
+*/
+
+
+#include "include/stdafx.h"
+#include "include/Host.h"
+#include "include/HugeBoard.h"
+#include <iomanip>
+
+
+namespace {
+
+
+struct options_t {
+    size_t  n;
+    size_t  m;
+    std::string  socket;
+    size_t  connections;
+    size_t  sessions;
+    size_t  commands;
+    uint64_t  seed;
+    size_t  serve;
+};
+
+
+// Каждая какая команда - запрос поля.
+static const size_t FIELD_EVERY = 16;
+
+
+// Итоги соединения.
+typedef struct {
+    size_t  commands;
+    size_t  mismatches;
+    std::string  error;
+} result_t;
+
+
+// Разбирает параметры командной строки.
+options_t parse( int argc, char** argv );
+
+
+// Ведёт партии соединения 'connection': каждую C-ю из S.
+// @param latency  Время команд с сокетом, по индексу Host::command_t.
+void drive(
+    const options_t&,  size_t connection,  puzzlen::Latency* latency,  result_t&
+);
+
+
+} // namespace
+
+
+
+
+int main( int argc, char** argv ) {
+
+    using namespace puzzlen;
+
+    try {
+        const options_t  options = parse( argc, argv );
+
+        std::unique_ptr< Sessions >  sessions;
+        std::unique_ptr< Host >  host;
+        std::thread  serving;
+        if (options.serve > 0) {
+            sessions = std::unique_ptr< Sessions >( new Sessions( options.serve ) );
+            host = std::unique_ptr< Host >( new Host( *sessions, options.socket ) );
+            serving = std::thread( [ & ] () { host->run(); } );
+        }
+
+        Latency  latency[ Host::COMMAND_COUNT ];
+        for (size_t c = 0; c < Host::COMMAND_COUNT; ++c) {
+            latency[ c ].reset();
+        }
+        std::vector< result_t >  results( options.connections );
+        std::vector< std::thread >  threads;
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t c = 0; c < options.connections; ++c) {
+            threads.emplace_back( [ &, c ] () {
+                drive( options, c, latency, results[ c ] );
+            } );
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        const double seconds = std::chrono::duration< double >(
+            std::chrono::steady_clock::now() - start
+        ).count();
+
+        HostClient  client( options.socket );
+        std::istringstream  stats( client.request( "stats" ) );
+        if (options.serve > 0) {
+            host->stop();
+            serving.join();
+        }
+
+        size_t commands = 0;
+        size_t mismatches = 0;
+        for (const auto& r : results) {
+            if ( !r.error.empty() ) {
+                throw Exception( r.error );
+            }
+            commands += r.commands;
+            mismatches += r.mismatches;
+        }
+
+        std::string  word;
+        size_t open = 0;
+        stats >> word >> open;
+        if (word != "ok") {
+            throw Exception( "Host does not report statistics." );
+        }
+        std::cout <<
+            "board        " << options.n << " x " << options.m << "\n" <<
+            "connections  " << options.connections << "\n" <<
+            "sessions     " << options.sessions << "\n" <<
+            "commands     " << commands << "\n" <<
+            "time         " << seconds << " s\n" <<
+            "commands/s   " << commands / seconds << "\n" <<
+            "open         " << open << "\n" <<
+            "mismatches   " << mismatches << "\n";
+        std::cout <<
+            std::left << std::setw( 10 ) << "command" << std::right <<
+            std::setw( 12 ) << "count" <<
+            std::setw( 12 ) << "p50 us" <<
+            std::setw( 12 ) << "p99 us" <<
+            std::setw( 12 ) << "host p50" <<
+            std::setw( 12 ) << "host p99" << "\n";
+        std::cout << std::fixed << std::setprecision( 2 );
+        for (size_t c = 0; c < Host::COMMAND_COUNT; ++c) {
+            std::string  name;
+            uint64_t count = 0;
+            uint64_t p50 = 0;
+            uint64_t p99 = 0;
+            stats >> name >> count >> p50 >> p99;
+            const auto s = latency[ c ].summary();
+            if (s.count == 0) {
+                continue;
+            }
+            std::cout <<
+                std::left << std::setw( 10 ) << Host::COMMAND_NAME[ c ] << std::right <<
+                std::setw( 12 ) << s.count <<
+                std::setw( 12 ) << (s.p50 / 1e3) <<
+                std::setw( 12 ) << (s.p99 / 1e3) <<
+                std::setw( 12 ) << (p50 / 1e3) <<
+                std::setw( 12 ) << (p99 / 1e3) << "\n";
+        }
+        std::cout << std::defaultfloat;
+        std::cout.flush();
+
+        if ( (mismatches > 0) || (open > 0) ) {
+            std::cerr << "Host answers do not match the boards." << std::endl;
+            return -1;
+        }
+
+    } catch ( const Exception& ex ) {
+        std::cerr << ex.what() << std::endl;
+        return -1;
+    }
+
+    return 0;
+}
+
+
+
+
+namespace {
+
+
+options_t
+parse( int argc, char** argv ) {
+
+    using namespace puzzlen;
+
+    options_t  options;
+    options.n = DEFAULT_N;
+    options.m = DEFAULT_M;
+    options.socket = HOST_SOCKET;
+    options.connections = 4;
+    options.sessions = 1000;
+    options.commands = 100000;
+    options.seed = 1;
+    options.serve = 0;
+
+    size_t count = 0;
+    for (int k = 1; k < argc; ++k) {
+        const std::string  word = argv[ k ];
+        if ( (word.size() > 2) && (word.compare( 0, 2, "--" ) == 0) ) {
+            if (k + 1 >= argc) {
+                throw Exception( "Option " + word + " needs a value." );
+            }
+            std::istringstream  wss( argv[ ++k ] );
+            if (word == "--socket") {
+                wss >> options.socket;
+            } else if (word == "--connections") {
+                wss >> options.connections;
+            } else if (word == "--sessions") {
+                wss >> options.sessions;
+            } else if (word == "--commands") {
+                wss >> options.commands;
+            } else if (word == "--seed") {
+                wss >> options.seed;
+            } else if (word == "--serve") {
+                wss >> options.serve;
+            } else {
+                throw Exception( "Unknown option " + word + "." );
+            }
+            if ( wss.fail() ) {
+                throw Exception( "Value of option " + word + " is not recognized." );
+            }
+            continue;
+        }
+
+        std::istringstream  wss( word );
+        switch ( count ) {
+            // ширина
+            case 0:
+                wss >> options.n;
+                if ( wss.fail() ) {
+                    throw Exception( "Width of puzzle is not recognized." );
+                }
+                break;
+
+            // высота
+            case 1:
+                wss >> options.m;
+                if ( wss.fail() ) {
+                    throw Exception( "Height of puzzle is not recognized." );
+                }
+                break;
+
+            default:
+                throw Exception( "Too many parameters in command line." );
+        };
+        ++count;
+    }
+
+    if (count == 1) {
+        // # Допустимо не указывать высоту.
+        options.m = options.n;
+    }
+    if ( (options.n < 2) || (options.m < 2)
+      || (options.n > SESSION_MAX_SIDE) || (options.m > SESSION_MAX_SIDE)
+    ) {
+        throw Exception(
+            "Width and height of puzzle must have diapason [2; " +
+            std::to_string( SESSION_MAX_SIDE ) + "]."
+        );
+    }
+    if ( (options.connections == 0) || (options.sessions < options.connections) ) {
+        throw Exception( "Every connection needs at least one session." );
+    }
+
+    return options;
+}
+
+
+
+
+void
+drive(
+    const options_t& options,  size_t connection,  puzzlen::Latency* latency,  result_t& result
+) {
+    using namespace puzzlen;
+
+    typedef HugeBoard< uint16_t >  board_t;
+
+    result.commands = 0;
+    result.mismatches = 0;
+    try {
+        HostClient  client( options.socket );
+
+        // # Команда с замером: время - по индексу 'command'.
+        std::string  response;
+        const auto request = [ & ] ( Host::command_t command, const std::string& line ) {
+            const auto begin = std::chrono::steady_clock::now();
+            response = client.request( line );
+            latency[ command ].record( Latency::since( begin ) );
+            ++result.commands;
+            if (response.compare( 0, 2, "ok" ) != 0) {
+                throw Exception( "Host: " + response );
+            }
+        };
+
+        // # Поле сервера - ответ field: сверяем с полем клиента.
+        const auto check = [ & ] ( const std::string& id, const board_t& board ) {
+            request( Host::FIELD, "field " + id );
+            std::istringstream  in( response.substr( 2 ) );
+            for (const auto element : board.elements()) {
+                size_t e = board_t::MAX_CELLS;
+                in >> e;
+                if (e != element) {
+                    ++result.mismatches;
+                    return;
+                }
+            }
+        };
+
+        std::vector< std::string >  ids;
+        std::vector< board_t >  boards;
+        for (size_t s = connection; s < options.sessions; s += options.connections) {
+            const uint64_t seed = options.seed + s;
+            request( Host::OPEN,
+                "open " + std::to_string( options.n ) + " " +
+                std::to_string( options.m ) + " " + std::to_string( seed )
+            );
+            ids.push_back( response.substr( 3 ) );
+            boards.emplace_back( options.n, options.m );
+            boards.back().shuffle( seed );
+        }
+
+        const size_t share = options.commands / options.connections +
+            ((connection < options.commands % options.connections) ? 1 : 0);
+        Random  random( options.seed, connection + 1 );
+        for (size_t k = 0; k < share; ++k) {
+            const size_t s = random.below( static_cast< uint32_t >( ids.size() ) );
+            if (k % FIELD_EVERY == FIELD_EVERY - 1) {
+                check( ids[ s ], boards[ s ] );
+                continue;
+            }
+            const auto direction = static_cast< PuzzleN::direction_t >( random.below( 4 ) );
+            request( Host::MOVE,
+                "move " + ids[ s ] + " " + PuzzleN::DIRECTION_NAME[ direction ]
+            );
+            const bool moved = boards[ s ].shift( direction );
+            const bool solved = boards[ s ].solved();
+            if ( (response[ 3 ] != (moved ? '1' : '0'))
+              || (response[ 5 ] != (solved ? '1' : '0'))
+            ) {
+                ++result.mismatches;
+            }
+        }
+
+        for (size_t s = 0; s < ids.size(); ++s) {
+            check( ids[ s ], boards[ s ] );
+            request( Host::CLOSE, "close " + ids[ s ] );
+        }
+
+    } catch ( const Exception& ex ) {
+        result.error = ex.what();
+    }
+}
+
+
+} // namespace
@@ -1,39 +1,83 @@
 /**
-*    "".
+* Заготовка для игры "пятнашки".
 *
-*      "puzzlen [N [M]]".
-*  N, M -      .
-* : puzzlen 7 10
+* Запускается приложение из консоли командой "puzzlen [N [M]] [--record FILE]".
+* Где N, M     - количество ячеек по ширине и высоте.
+*     --record - записать события ввода в файл (см. Recorder); запись
+*                воспроизводит "puzzlen-sim --replay FILE".
+* Пример: puzzlen 7 10
+*         puzzlen 4 --record session.pznr
 *
-* 
-*   LeftClick + move   .
-*   SPACE              .
-*   ESC               .
+* Управление
+*   LeftClick + move  Перемещает элемент.
+*   SPACE             Перетасовывает элементы.
+*   Ctrl + Z          Отменяет ход.
+*   Ctrl + Y          Повторяет отменённый ход.
+*   H                 Подсказка следующего хода в заголовке окна (см.
+*                     Hint): включает / выключает.
+*   F12               Записывает замеры (см. Instrument) в INSTRUMENT_FILE.
+*                     Только в сборке с PUZZLEN_INSTRUMENT; при выходе
+*                     замеры записываются туда же.
+*   ESC               Выход.
 *
-* @see configure.h   .
+* @see configure.h для установки параметров.
 *
-* @author  , +38 050 335-16-18
+* @author Андрей Сырокомский, +38 050 335-16-18
 */
 
 
 #include "include/stdafx.h"
+#include "include/FrameScheduler.h"
+#include "include/Hint.h"
+#include "include/Instrument.h"
 #include "include/PuzzleN.h"
+#include "include/Painter.h"
+#include "include/Recorder.h"
+#include <fstream>
 
 
 static std::unique_ptr< puzzlen::PuzzleN >  puzzlenPtr;
+static std::unique_ptr< puzzlen::Painter >  painterPtr;
+static std::unique_ptr< puzzlen::FrameScheduler >  schedulerPtr;
+// # Только с параметром --record.
+static std::unique_ptr< puzzlen::Recorder >  recorderPtr;
+// # Только после клавиши H.
+static std::unique_ptr< puzzlen::Solver >  solverPtr;
+static std::unique_ptr< puzzlen::Hint >  hintPtr;
 
 
-//   .
-std::pair< size_t, size_t >  parse( const LPSTR cmdLine );
+// Таймер отложенного кадра, см. schedule().
+static const UINT_PTR  FRAME_TIMER = 1;
 
 
-//   .
+// Параметры приложения.
+typedef struct {
+    size_t  n;
+    size_t  m;
+    // куда записать события ввода
+    std::string  record;
+} params_t;
+
+
+// Распознаёт параметры приложения.
+params_t parse( const LPSTR cmdLine );
+
+
+// Для визуальной отладки.
 void debug( HWND wnd );
 
 
+// Записывает замеры в INSTRUMENT_FILE, задержки кадра - в заголовок окна.
+void instrument( HWND wnd );
+
+
+// Пишет в заголовок окна подсказку следующего хода, если они включены.
+void hint( HWND wnd );
 
 
-// .    GDI+.
+
+
+// Исп. для работы с GDI+.
 LRESULT CALLBACK wndProc(
     HWND wnd, UINT message, WPARAM wparam, LPARAM lparam
 );
@@ -41,6 +85,17 @@ LRESULT CALLBACK wndProc(
 void draw( HDC hdc,  const RECT& rc );
 
 
+// Планирует кадр после события ввода: сразу или по таймеру, если
+// прошлый кадр был недавно.
+void schedule( HWND wnd );
+
+// Запрашивает перерисовку изменившихся областей.
+void invalidate( HWND wnd );
+
+// @return Время для FrameScheduler, мкс.
+puzzlen::FrameScheduler::time_t now();
+
+
 
 
 int WINAPI WinMain(
@@ -57,13 +112,13 @@ int WINAPI WinMain(
     setlocale( LC_NUMERIC, "C" );
 
 
-    //  GDI+
+    // инициализируем GDI+
     GdiplusStartupInput  gdiplusStartupInput; 
     ULONG_PTR  gdiplusToken; 
     GdiplusStartup( &gdiplusToken, &gdiplusStartupInput, nullptr );
 
 
-    //   
+    // создаём окно визуализации
     WNDCLASSEX ex;
     ex.cbSize        = sizeof( WNDCLASSEX );
     ex.style         = 0;
@@ -84,7 +139,7 @@ int WINAPI WinMain(
     }
 
 
-    std::pair< size_t, size_t >  params;
+    params_t  params;
     try {
         params = parse( cmdLine );
 
@@ -94,8 +149,8 @@ int WINAPI WinMain(
     }
 
 
-    const int WINDOW_WIDTH  = params.first  * CELL_SIZE;
-    const int WINDOW_HEIGHT = params.second * CELL_SIZE;
+    const int WINDOW_WIDTH  = params.n * CELL_SIZE;
+    const int WINDOW_HEIGHT = params.m * CELL_SIZE;
 
     auto wnd = CreateWindow(
         "win32app", "",
@@ -112,7 +167,7 @@ int WINAPI WinMain(
         return -1;
     }
 
-    //  ,  
+    // центрируем окно, корректируем размер
     {
         RECT  rc = { 0, 0, WINDOW_WIDTH, WINDOW_HEIGHT };
         const DWORD style = GetWindowLongPtr( wnd, GWL_STYLE );
@@ -131,24 +186,38 @@ int WINAPI WinMain(
     }
 
 
-    //  PuzzleN
+    // создаём PuzzleN
     try {
         puzzlenPtr = std::unique_ptr< PuzzleN >(
-            new PuzzleN( params.first, params.second, CELL_SIZE )
+            new PuzzleN( params.n, params.m, CELL_SIZE )
+        );
+        // # Ходы окна - без выделения памяти (см. HISTORY_RESERVE).
+        puzzlenPtr->reserveHistory( HISTORY_RESERVE );
+        painterPtr = std::unique_ptr< Painter >( new Painter( *puzzlenPtr ) );
+        schedulerPtr = std::unique_ptr< FrameScheduler >(
+            new FrameScheduler( *puzzlenPtr )
         );
+        if ( !params.record.empty() ) {
+            recorderPtr = std::unique_ptr< Recorder >( new Recorder( *puzzlenPtr ) );
+        }
     } catch ( const Exception& ex ) {
         std::cerr << ex.what() << std::endl;
         return -1;
     }
 
 
-    //  
+#ifdef PUZZLEN_INSTRUMENT
+    Instrument::reportAtExit( INSTRUMENT_FILE );
+#endif
+
+
+    // заголовок окна
     std::ostringstream  title;
     title << "Puzzle  " << puzzlenPtr->N << " x " << puzzlenPtr->M;
     SetWindowText( wnd,  title.str().c_str() );
 
 
-    // 
+    // визуализируем
     ShowWindow( wnd, cmdShow );
     UpdateWindow( wnd );
 
@@ -161,6 +230,15 @@ int WINAPI WinMain(
         DispatchMessage( &msg );
     }
 
+    if ( recorderPtr ) {
+        try {
+            recorderPtr->finish();
+            recorderPtr->save( params.record );
+        } catch ( const Exception& ex ) {
+            MessageBox( nullptr, ex.what(), "PuzzleN", 0 );
+        }
+    }
+
     GdiplusShutdown( gdiplusToken );
 
     return 0;
@@ -181,49 +259,123 @@ LRESULT CALLBACK wndProc(
 
     switch ( message ) {
         case WM_CREATE:
-            SetTimer( wnd, 0, 10, 0 );
+            // # Кадры рисуются только после изменений: см. schedule().
             return 0;
 
         case WM_TIMER:
-            InvalidateRect( wnd, nullptr, false );
-            UpdateWindow( wnd );
-#ifdef CONSOLE_DEBUG_PUZZLEN
-            debug( wnd );
-#endif
+            KillTimer( wnd, FRAME_TIMER );
+            invalidate( wnd );
             return 0;
 
         case WM_PAINT:
-            hdc = BeginPaint( wnd, &ps );
-            puzzlenPtr->draw( hdc, ps.rcPaint );
-            EndPaint( wnd, &ps );
+            {
+                PUZZLEN_PROBE( FRAME )
+                const auto begin = now();
+                hdc = BeginPaint( wnd, &ps );
+                painterPtr->draw( hdc, ps.rcPaint );
+                puzzlenPtr->clearDamage();
+                EndPaint( wnd, &ps );
+                schedulerPtr->presented( begin, now() );
+            }
+#ifdef CONSOLE_DEBUG_PUZZLEN
+            debug( wnd );
+#endif
             return 0;
 
+        // # Те же вызовы повторяет Replayer::replay().
         case WM_LBUTTONDOWN:
-            puzzlenPtr->pressMouseButton( true );
-            puzzlenPtr->firstClick(
-                GET_X_LPARAM( lparam ),
-                GET_Y_LPARAM( lparam )
-            );
+            {
+                PUZZLEN_PROBE( INPUT )
+                puzzlenPtr->pressMouseButton( true );
+                puzzlenPtr->firstClick(
+                    GET_X_LPARAM( lparam ),
+                    GET_Y_LPARAM( lparam )
+                );
+                if ( recorderPtr ) {
+                    recorderPtr->press( GET_X_LPARAM( lparam ),  GET_Y_LPARAM( lparam ),  now() );
+                }
+                schedule( wnd );
+            }
             break;
 
         case WM_MOUSEMOVE:
-            puzzlenPtr->move(
-                GET_X_LPARAM( lparam ),
-                GET_Y_LPARAM( lparam )
-            );
+            {
+                PUZZLEN_PROBE( INPUT )
+                puzzlenPtr->move(
+                    GET_X_LPARAM( lparam ),
+                    GET_Y_LPARAM( lparam )
+                );
+                if ( recorderPtr ) {
+                    recorderPtr->move( GET_X_LPARAM( lparam ),  GET_Y_LPARAM( lparam ),  now() );
+                }
+                schedule( wnd );
+            }
             break;
 
         case WM_LBUTTONUP:
-            puzzlenPtr->pressMouseButton( false );
-            puzzlenPtr->stickMove();
-            puzzlenPtr->resetFirstClick();
+            {
+                PUZZLEN_PROBE( INPUT )
+                puzzlenPtr->pressMouseButton( false );
+                puzzlenPtr->stickMove();
+                puzzlenPtr->resetFirstClick();
+                if ( recorderPtr ) {
+                    recorderPtr->release( now() );
+                }
+                hint( wnd );
+                schedule( wnd );
+            }
             break;
 
         case WM_KEYUP:
-            if (wparam == VK_SPACE) {
-                puzzlenPtr->shuffle();
-            } else if (wparam == VK_ESCAPE) {
-                PostQuitMessage( 0 );
+            {
+                PUZZLEN_PROBE( INPUT )
+                if (wparam == VK_SPACE) {
+                    const uint64_t seed = puzzlenPtr->shuffle();
+                    if ( recorderPtr ) {
+                        recorderPtr->shuffle( seed, now() );
+                    }
+                    hint( wnd );
+                    schedule( wnd );
+                } else if ( (wparam == 'Z') && (GetKeyState( VK_CONTROL ) < 0) ) {
+                    if ( puzzlenPtr->undo() ) {
+                        if ( recorderPtr ) {
+                            recorderPtr->undo( now() );
+                        }
+                        hint( wnd );
+                        schedule( wnd );
+                    }
+                } else if ( (wparam == 'Y') && (GetKeyState( VK_CONTROL ) < 0) ) {
+                    if ( puzzlenPtr->redo() ) {
+                        if ( recorderPtr ) {
+                            recorderPtr->redo( now() );
+                        }
+                        hint( wnd );
+                        schedule( wnd );
+                    }
+                } else if (wparam == 'H') {
+                    if ( hintPtr ) {
+                        hintPtr.reset();
+                        std::ostringstream  title;
+                        title << "Puzzle  " << puzzlenPtr->N << " x " << puzzlenPtr->M;
+                        SetWindowText( wnd,  title.str().c_str() );
+                    } else {
+                        if ( !solverPtr ) {
+                            solverPtr = std::unique_ptr< puzzlen::Solver >(
+                                new puzzlen::Solver( puzzlenPtr->N, puzzlenPtr->M )
+                            );
+                        }
+                        hintPtr = std::unique_ptr< puzzlen::Hint >(
+                            new puzzlen::Hint( *solverPtr, 0 )
+                        );
+                        hint( wnd );
+                    }
+#ifdef PUZZLEN_INSTRUMENT
+                } else if (wparam == VK_F12) {
+                    instrument( wnd );
+#endif
+                } else if (wparam == VK_ESCAPE) {
+                    PostQuitMessage( 0 );
+                }
             }
             break;
 
@@ -238,6 +390,52 @@ LRESULT CALLBACK wndProc(
 
 
 
+void
+schedule( HWND wnd ) {
+
+    using namespace puzzlen;
+
+    const FrameScheduler::time_t delay = schedulerPtr->event( now() );
+    if (delay == FrameScheduler::NONE) {
+        return;
+    }
+    if (delay == 0) {
+        invalidate( wnd );
+        return;
+    }
+    // # Таймер одноразовый: его гасит WM_TIMER.
+    SetTimer( wnd, FRAME_TIMER, static_cast< UINT >( (delay + 999) / 1000 ), nullptr );
+}
+
+
+
+
+void
+invalidate( HWND wnd ) {
+
+    const auto& damage = puzzlenPtr->damage();
+    for (auto itr = damage.cbegin(); itr != damage.cend(); ++itr) {
+        const RECT  rc = { itr->left, itr->top, itr->right, itr->bottom };
+        InvalidateRect( wnd, &rc, false );
+    }
+}
+
+
+
+
+puzzlen::FrameScheduler::time_t
+now() {
+
+    return static_cast< puzzlen::FrameScheduler::time_t >(
+        std::chrono::duration_cast< std::chrono::microseconds >(
+            std::chrono::steady_clock::now().time_since_epoch()
+        ).count()
+    );
+}
+
+
+
+
 void
 debug( HWND wnd ) {
 
@@ -254,24 +452,53 @@ debug( HWND wnd ) {
 
 
 
+void
+instrument( HWND wnd ) {
 
+    using namespace puzzlen;
+
+    std::ofstream  out( INSTRUMENT_FILE.c_str() );
+    Instrument::report( out );
 
+    const auto frame = Instrument::summary( Instrument::FRAME );
+    std::ostringstream  ss;
+    ss << "Puzzle  " << puzzlenPtr->N << " x " << puzzlenPtr->M <<
+        "  frames " << frame.count <<
+        "  p50 " << (frame.p50 / 1000) << " us" <<
+        "  p99 " << (frame.p99 / 1000) << " us";
+    SetWindowText( wnd,  ss.str().c_str() );
+}
 
 
-std::pair< size_t, size_t >
+
+
+
+
+
+
+params_t
 parse( const LPSTR cmdLine ) {
 
     using namespace puzzlen;
 
-    size_t n = DEFAULT_N;
-    size_t m = DEFAULT_M;
+    params_t  params;
+    params.n = DEFAULT_N;
+    params.m = DEFAULT_M;
+    size_t& n = params.n;
+    size_t& m = params.m;
     std::istringstream  ss( cmdLine, std::istringstream::in );
     std::string  word;
     size_t count = 0;
-    for ( ; ss >> word; ++count) {
+    while (ss >> word) {
+        if (word == "--record") {
+            if ( !(ss >> params.record) ) {
+                throw Exception( "Option --record needs a value." );
+            }
+            continue;
+        }
         std::istringstream  wss( word );
         switch ( count ) {
-            // 
+            // ширина
             case 0:
                 wss >> n;
                 if ( wss.fail() ) {
@@ -282,7 +509,7 @@ parse( const LPSTR cmdLine ) {
                 }
                 break;
 
-            // 
+            // высота
             case 1:
                 wss >> m;
                 if ( wss.fail() ) {
@@ -296,14 +523,41 @@ parse( const LPSTR cmdLine ) {
             default:
                 throw Exception( "Too many parameters in command line." );
         };
+        ++count;
     };
 
 
     if (count == 1) {
-        // #    .
+        // # Допустимо не указывать высоту.
         m = n;
     }
 
 
-    return std::make_pair( n, m );
+    return params;
+}
+
+
+
+
+void
+hint( HWND wnd ) {
+
+    using namespace puzzlen;
+
+    if ( !hintPtr ) {
+        return;
+    }
+
+    // # Ход - буква направления, куда сдвинуть элемент к пустой ячейке;
+    //   "~" - путь может быть не кратчайшим.
+    const Hint::hint_t  h = hintPtr->next( puzzlenPtr->field() );
+    std::ostringstream  ss;
+    ss << "Puzzle  " << puzzlenPtr->N << " x " << puzzlenPtr->M << "  hint ";
+    if (h.direction < 0) {
+        ss << "solved";
+    } else {
+        ss << PuzzleN::DIRECTION_NAME[ h.direction ] <<
+            "  " << (h.optimal ? "" : "~") << h.remaining << " moves";
+    }
+    SetWindowText( wnd,  ss.str().c_str() );
 }
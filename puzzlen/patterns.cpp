@@ -0,0 +1,174 @@
+/**
+* Строит аддитивные базы шаблонов для решателя игры "пятнашки".
+*
+* Запускается из консоли командой
+*   "puzzlen-patterns [N [M]] [--tiles K] [--out FILE]"
+* Где N, M    - количество ячеек по ширине и высоте.
+*     --tiles - элементов в шаблоне: элементы группируются подряд по
+*               строкам. По умолчанию 6-6-3 для 4 x 4 и по 5 для прочих.
+*     --out   - файл баз, по умолчанию "puzzlen-NxM.pdb".
+* Пример: puzzlen-patterns 4 4
+*         puzzlen-solve 4 --patterns puzzlen-4x4.pdb
+*
+* Базы сохраняются в формате, который решатель отображает в память
+* (см. Patterns.h): построить один раз, пользоваться из всех процессов.
+*/
+
+
+#include "include/stdafx.h"
+#include "include/Patterns.h"
+#include "include/Ranking.h"
+
+
+namespace {
+
+
+struct options_t {
+    size_t  n;
+    size_t  m;
+    size_t  tiles;
+    std::string  out;
+};
+
+
+// Разбирает параметры командной строки.
+options_t parse( int argc, char** argv );
+
+
+} // namespace
+
+
+
+
+int main( int argc, char** argv ) {
+
+    using namespace puzzlen;
+
+    try {
+        const options_t  options = parse( argc, argv );
+        const Patterns::partition_t  partition = (options.tiles > 0) ?
+            Patterns::rowPartition( options.n, options.m, options.tiles ) :
+            Patterns::defaultPartition( options.n, options.m );
+
+        const auto start = std::chrono::steady_clock::now();
+        const Patterns  patterns( options.n, options.m, partition );
+        const auto built = std::chrono::steady_clock::now();
+        patterns.save( options.out );
+
+        // проверяем, что файл читается
+        const auto loading = std::chrono::steady_clock::now();
+        const Patterns  loaded( options.out );
+        const auto loaded_ = std::chrono::steady_clock::now();
+
+        std::cout << "board     " << options.n << " x " << options.m << "\n";
+        for (size_t k = 0; k < loaded.partition().size(); ++k) {
+            const auto& pattern = loaded.partition()[ k ];
+            std::cout << "pattern   ";
+            for (auto itr = pattern.cbegin(); itr != pattern.cend(); ++itr) {
+                std::cout << *itr << " ";
+            }
+            std::cout << "(" <<
+                Ranking::arrangements( pattern.size(), options.n * options.m ) <<
+                " entries)\n";
+        }
+        std::cout <<
+            "build     " << std::chrono::duration< double >( built - start ).count() << " s\n" <<
+            "load      " << std::chrono::duration< double, std::milli >( loaded_ - loading ).count() << " ms\n" <<
+            "file      " << options.out << std::endl;
+
+    } catch ( const Exception& ex ) {
+        std::cerr << ex.what() << std::endl;
+        return -1;
+    } catch ( const std::bad_alloc& ) {
+        std::cerr << "Not enough memory to build the patterns." << std::endl;
+        return -1;
+    }
+
+    return 0;
+}
+
+
+
+
+namespace {
+
+
+options_t
+parse( int argc, char** argv ) {
+
+    using namespace puzzlen;
+
+    options_t  options;
+    options.n = DEFAULT_N;
+    options.m = DEFAULT_M;
+    options.tiles = 0;
+
+    size_t count = 0;
+    for (int k = 1; k < argc; ++k) {
+        const std::string  word = argv[ k ];
+        if ( (word.size() > 2) && (word.compare( 0, 2, "--" ) == 0) ) {
+            if (k + 1 >= argc) {
+                throw Exception( "Option " + word + " needs a value." );
+            }
+            std::istringstream  wss( argv[ ++k ] );
+            if (word == "--tiles") {
+                wss >> options.tiles;
+            } else if (word == "--out") {
+                wss >> options.out;
+            } else {
+                throw Exception( "Unknown option " + word + "." );
+            }
+            if ( wss.fail() ) {
+                throw Exception( "Value of option " + word + " is not recognized." );
+            }
+            continue;
+        }
+
+        std::istringstream  wss( word );
+        switch ( count ) {
+            // ширина
+            case 0:
+                wss >> options.n;
+                if ( wss.fail() ) {
+                    throw Exception( "Width of puzzle is not recognized." );
+                }
+                if ( (options.n > 10) || (options.n < 3) ) {
+                    throw Exception( "Width of puzzle must have diapason [3; 10]." );
+                }
+                break;
+
+            // высота
+            case 1:
+                wss >> options.m;
+                if ( wss.fail() ) {
+                    throw Exception( "Height of puzzle is not recognized." );
+                }
+                if ( (options.m > 10) || (options.m < 3) ) {
+                    throw Exception( "Height must have diapason [3; 10]." );
+                }
+                break;
+
+            default:
+                throw Exception( "Too many parameters in command line." );
+        };
+        ++count;
+    }
+
+
+    if (count == 1) {
+        // # Допустимо не указывать высоту.
+        options.m = options.n;
+    }
+
+    if ( options.out.empty() ) {
+        std::ostringstream  ss;
+        ss << "puzzlen-" << options.n << "x" << options.m << ".pdb";
+        options.out = ss.str();
+    }
+
+
+    return options;
+}
+
+
+} // namespace
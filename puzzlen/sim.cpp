@@ -0,0 +1,1302 @@
+/**
+* Headless-симулятор для игры "пятнашки".
+*
+* Прогоняет сценарии ходов через ядро PuzzleN без окна и GDI+ с
+* максимальной скоростью. Каждый ход отрабатывается так же, как
+* перетаскивание мышью в игре: firstClick() > move() > stickMove().
+*
+* Запускается из консоли командой
+*   "puzzlen-sim [N [M]] [--moves COUNT] [--boards COUNT] [--seed S]
+*                [--script FILE] [--shuffles COUNT] [--shifts COUNT]
+*                [--frames COUNT] [--schedule COUNT]
+*                [--record FILE] [--replay FILE] [--repeat R]
+*                [--history COUNT] [--huge COUNT] [--compact COUNT]"
+* Где N, M       - количество ячеек по ширине и высоте, [3; 10]; с --huge -
+*                  [2; HUGE_MAX_SIDE].
+*     --moves    - количество случайных ходов на одно поле.
+*     --boards   - количество полей. Поле k перетасовано с зерном seed + k,
+*                  без --seed поля начинаются собранными.
+*     --seed     - зерно для полей и случайных ходов.
+*     --script   - файл со сценарием ходов ('-' - стандартный ввод).
+*                  Ход - направление, куда сдвигается элемент: N, S, W, E.
+*                  Прочие символы игнорируются.
+*     --shuffles - вместо ходов генерирует COUNT решаемых полей пачками
+*                  (PuzzleN::shuffleBatch), проверяет решаемость каждого
+*                  и сообщает скорость генерации, полей/с.
+*     --shifts   - делает COUNT случайных ходов без мыши на каждом поле
+*                  дважды: PuzzleN::shift() и Board< N, M >::shift(),
+*                  сверяет поля и сравнивает скорость, ходов/с. Ход
+*                  PuzzleN ещё пишет историю (History) и области
+*                  перерисовки, ход Board - нет: ускорение включает и это.
+*     --frames   - протягивает мышью COUNT элементов (часть - не до конца) и
+*                  после каждого события мыши рисует кадр программно
+*                  (Renderer): по изменившимся областям и целиком. Кадры
+*                  должны совпасть; сообщает, сколько пикселей записано.
+*     --schedule - протягивает мышью COUNT элементов в модельном времени:
+*                  события мыши раз в 1 мс, между перетаскиваниями мышь
+*                  водят без нажатия. Кадры планирует FrameScheduler.
+*                  Проверяет, что кадры не чаще FRAME_INTERVAL, что без
+*                  изменений поля кадров нет и что последний кадр совпал
+*                  с полной перерисовкой; сравнивает с таймером 100 к/с.
+*     --record   - записывает в файл (см. Recorder) сеанс из --moves
+*                  перетаскиваний мышью (часть - не до конца, между ними
+*                  мышь водят без нажатия, изредка поле перетасовывается,
+*                  ходы отменяются и повторяются) и сразу проверяет его
+*                  воспроизведением.
+*     --replay   - воспроизводит запись (сделанную окном с --record или
+*                  симулятором) R раз с наибольшей скоростью, сверяет
+*                  итоговое поле и состояние перетаскивания (move_t) с
+*                  записанными и сообщает скорость, событий/с. Для
+*                  профилирования: perf record puzzlen-sim --replay FILE.
+*     --history  - делает COUNT случайных ходов, запоминая поле в случайных
+*                  точках. Отменяет все ходы, повторяет их и переходит
+*                  (PuzzleN::seek) к запомненным точкам, сверяя поля.
+*                  Сообщает память истории и скорость undo / redo, ходов/с.
+*     --huge     - делает COUNT случайных ходов на поле любого размера
+*                  (HugeBoard: элементы по 16 или 32 бита, ход - O(1)) и
+*                  отменяет их, проверяя permitShift() каждого элемента,
+*                  который сдвигается обратно, и возврат к исходному полю.
+*                  Сообщает память поля и скорость, ходов/с.
+*     --compact  - на полях от 3 x 3 до 10 x 10 (N, M не нужны) упаковывает
+*                  COUNT перетасованных полей в CompactState и сверяет
+*                  распаковку с полем, равенство и хеш одинаковых полей,
+*                  swap() - со сдвигом PuzzleN::shift() после каждого хода.
+* Пример: puzzlen-sim 4 4 --moves 10000000
+*         echo "EESSWN" | puzzlen-sim 3 --script -
+*         puzzlen-sim 4 --shuffles 10000000 --seed 1
+*         puzzlen-sim 4 --shifts 100000000
+*         puzzlen-sim 10 --frames 10000 --seed 1
+*         puzzlen-sim 4 --schedule 1000 --seed 1
+*         puzzlen-sim 4 --moves 100000 --record session.pznr --seed 1
+*         puzzlen-sim --replay session.pznr --repeat 100
+*         puzzlen-sim 4 --history 10000000 --seed 1
+*         puzzlen-sim 1000 1000 --huge 100000000 --seed 1
+*         puzzlen-sim --compact 1000 --seed 1
+*
+* @see configure.h для установки параметров.
+*/
+
+
+#include "include/stdafx.h"
+#include "include/Board.h"
+#include "include/CompactState.h"
+#include "include/FrameScheduler.h"
+#include "include/Geometry.h"
+#include "include/HugeBoard.h"
+#include "include/Instrument.h"
+#include "include/PuzzleN.h"
+#include "include/Recorder.h"
+#include "include/Renderer.h"
+#include "include/Replayer.h"
+#include <cctype>
+#include <cstring>
+#include <fstream>
+
+
+namespace {
+
+
+struct options_t {
+    size_t  n;
+    size_t  m;
+    size_t  moves;
+    size_t  boards;
+    size_t  shuffles;
+    size_t  shifts;
+    size_t  frames;
+    size_t  schedule;
+    bool      seeded;
+    uint64_t  seed;
+    std::string  script;
+    std::string  record;
+    std::string  replay;
+    size_t  repeat;
+    size_t  history;
+    size_t  huge;
+    size_t  compact;
+};
+
+
+// Смещения для направлений PuzzleN::direction_t.
+static const int DIRECTION_DX[] = { 0,  0, -1,  1 };
+static const int DIRECTION_DY[] = { -1, 1,  0,  0 };
+
+
+// Разбирает параметры командной строки.
+options_t parse( int argc, char** argv );
+
+
+// Считывает сценарий ходов.
+// @return Направления, см. PuzzleN::direction_t.
+std::vector< int > loadScript( const std::string& file );
+
+
+// Сдвигает элемент в направлении 'direction' так, как это делает мышь.
+// # Ячейку элемента и её координаты берёт из таблиц 'T': Board< N, M >
+//   (константы при компиляции) или Geometry.
+// @return Был ли ход разрешён.
+template< class T >
+bool gesture( puzzlen::PuzzleN&,  const T& tables,  int direction );
+
+
+// Генерирует перетасованные поля пачками, проверяет их решаемость.
+// @return Код возврата для main().
+int shuffles( const options_t& );
+
+
+// Сравнивает ходы PuzzleN и Board< N, M >.
+// @return Код возврата для main().
+int shifts( const options_t& );
+
+
+// Сравнивает кадры, нарисованные по изменившимся областям и целиком.
+// @return Код возврата для main().
+int frames( const options_t& );
+
+
+// Планирует кадры по событиям мыши и проверяет FrameScheduler.
+// @return Код возврата для main().
+int schedule( const options_t& );
+
+
+// Записывает сеанс перетаскиваний и проверяет его воспроизведением.
+// @return Код возврата для main().
+int record( const options_t& );
+
+
+// Воспроизводит запись и сверяет итоговое состояние.
+// @return Код возврата для main().
+int replay( const options_t& );
+
+
+// Отменяет и повторяет ходы, сверяя поля с запомненными.
+// @return Код возврата для main().
+int history( const options_t& );
+
+
+// Делает ходы на поле любого размера и отменяет их.
+// @return Код возврата для main().
+int huge( const options_t& );
+
+
+// Упаковывает поля в CompactState и сверяет с PuzzleN.
+// @return Код возврата для main().
+int compact( const options_t& );
+
+
+// Ходы и проверка для huge() на поле с элементами 'B::element_t'.
+template< class B >
+int hugeMoves( const options_t&,  B& board );
+
+
+// Делает 'count' случайных ходов на каждом поле через T::shift().
+// @return Время, с.
+template< class T >
+double shiftBoards(
+    const options_t&,  T& puzzle,  puzzlen::PuzzleN::field_t& last,  size_t& applied
+);
+
+
+} // namespace
+
+
+
+
+int main( int argc, char** argv ) {
+
+    using namespace puzzlen;
+
+    options_t  options;
+    std::vector< int >  script;
+    try {
+        options = parse( argc, argv );
+        if ( !options.script.empty() ) {
+            script = loadScript( options.script );
+        }
+
+    } catch ( const Exception& ex ) {
+        std::cerr << ex.what() << std::endl;
+        return -1;
+    }
+
+#ifdef PUZZLEN_INSTRUMENT
+    Instrument::reportAtExit( "" );
+#endif
+
+    if (options.shuffles > 0) {
+        return shuffles( options );
+    }
+    if (options.shifts > 0) {
+        return shifts( options );
+    }
+    if (options.frames > 0) {
+        return frames( options );
+    }
+    if (options.schedule > 0) {
+        return schedule( options );
+    }
+    if ( !options.record.empty() ) {
+        return record( options );
+    }
+    if ( !options.replay.empty() ) {
+        return replay( options );
+    }
+    if (options.history > 0) {
+        return history( options );
+    }
+    if (options.huge > 0) {
+        return huge( options );
+    }
+    if (options.compact > 0) {
+        return compact( options );
+    }
+
+    Random  random( options.seed );
+
+    size_t applied  = 0;
+    size_t rejected = 0;
+    size_t checksum = 0;
+    const auto play = [ & ] ( const auto& tables ) {
+        for (size_t b = 0; b < options.boards; ++b) {
+            PuzzleN  puzzle( options.n, options.m, CELL_SIZE );
+            if ( options.seeded ) {
+                puzzle.shuffle( options.seed + b );
+            }
+            if ( script.empty() ) {
+                for (size_t k = 0; k < options.moves; ++k) {
+                    gesture( puzzle, tables, static_cast< int >( random.below( 4 ) ) ) ?
+                        ++applied : ++rejected;
+                }
+            } else {
+                for (auto itr = script.cbegin(); itr != script.cend(); ++itr) {
+                    gesture( puzzle, tables, *itr ) ? ++applied : ++rejected;
+                }
+            }
+            // # Не позволяем компилятору выбросить работу.
+            checksum += static_cast< size_t >( puzzle.emptyElement() );
+        }
+    };
+
+    // # Ячейки ходов - из таблиц Board, если размер инстанцирован.
+    const auto start = std::chrono::steady_clock::now();
+    const bool specialised = withBoard( options.n, options.m, [ & ] ( auto board ) {
+        play( board );
+    } );
+    if ( !specialised ) {
+        play( Geometry( options.n, options.m ) );
+    }
+    const auto finish = std::chrono::steady_clock::now();
+
+    const double seconds =
+        std::chrono::duration< double >( finish - start ).count();
+    const size_t total = applied + rejected;
+    std::cout <<
+        "board     " << options.n << " x " << options.m << "\n" <<
+        "tables    " << (specialised ? "Board< N, M >" : "Geometry") << "\n" <<
+        "boards    " << options.boards << "\n" <<
+        "moves     " << total << " (applied " << applied <<
+            ", rejected " << rejected << ")\n" <<
+        "time      " << seconds << " s\n" <<
+        "moves/s   " << ((seconds > 0.0) ? (total / seconds) : 0.0) << "\n" <<
+        "checksum  " << checksum << std::endl;
+
+    return 0;
+}
+
+
+
+
+namespace {
+
+
+options_t
+parse( int argc, char** argv ) {
+
+    using namespace puzzlen;
+
+    options_t  options;
+    options.n = DEFAULT_N;
+    options.m = DEFAULT_M;
+    options.moves  = 1000000;
+    options.boards = 1;
+    options.shuffles = 0;
+    options.shifts = 0;
+    options.frames = 0;
+    options.schedule = 0;
+    options.seeded = false;
+    options.seed   = 0;
+    options.repeat = 1;
+    options.history = 0;
+    options.huge = 0;
+    options.compact = 0;
+
+    size_t count = 0;
+    for (int k = 1; k < argc; ++k) {
+        const std::string  word = argv[ k ];
+        if ( (word.size() > 2) && (word.compare( 0, 2, "--" ) == 0) ) {
+            if (k + 1 >= argc) {
+                throw Exception( "Option " + word + " needs a value." );
+            }
+            std::istringstream  wss( argv[ ++k ] );
+            if (word == "--moves") {
+                wss >> options.moves;
+            } else if (word == "--boards") {
+                wss >> options.boards;
+            } else if (word == "--shuffles") {
+                wss >> options.shuffles;
+            } else if (word == "--shifts") {
+                wss >> options.shifts;
+            } else if (word == "--frames") {
+                wss >> options.frames;
+            } else if (word == "--schedule") {
+                wss >> options.schedule;
+            } else if (word == "--seed") {
+                wss >> options.seed;
+                options.seeded = true;
+            } else if (word == "--script") {
+                wss >> options.script;
+            } else if (word == "--record") {
+                wss >> options.record;
+            } else if (word == "--replay") {
+                wss >> options.replay;
+            } else if (word == "--repeat") {
+                wss >> options.repeat;
+            } else if (word == "--history") {
+                wss >> options.history;
+            } else if (word == "--huge") {
+                wss >> options.huge;
+            } else if (word == "--compact") {
+                wss >> options.compact;
+            } else {
+                throw Exception( "Unknown option " + word + "." );
+            }
+            if ( wss.fail() ) {
+                throw Exception( "Value of option " + word + " is not recognized." );
+            }
+            continue;
+        }
+
+        std::istringstream  wss( word );
+        switch ( count ) {
+            // ширина
+            case 0:
+                wss >> options.n;
+                if ( wss.fail() ) {
+                    throw Exception( "Width of puzzle is not recognized." );
+                }
+                break;
+
+            // высота
+            case 1:
+                wss >> options.m;
+                if ( wss.fail() ) {
+                    throw Exception( "Height of puzzle is not recognized." );
+                }
+                break;
+
+            default:
+                throw Exception( "Too many parameters in command line." );
+        };
+        ++count;
+    }
+
+
+    if (count == 1) {
+        // # Допустимо не указывать высоту.
+        options.m = options.n;
+    }
+
+    // # Размер проверяем, когда известен режим: без окна и кадров поле
+    //   может быть любым.
+    if (options.huge > 0) {
+        if ( (options.n > HUGE_MAX_SIDE) || (options.n < 2) ) {
+            throw Exception( "Width of huge puzzle must have diapason [2; 65535]." );
+        }
+        if ( (options.m > HUGE_MAX_SIDE) || (options.m < 2) ) {
+            throw Exception( "Height of huge puzzle must have diapason [2; 65535]." );
+        }
+    } else {
+        if ( (options.n > 10) || (options.n < 3) ) {
+            throw Exception( "Width of puzzle must have diapason [3; 10]." );
+        }
+        if ( (options.m > 10) || (options.m < 3) ) {
+            throw Exception( "Height must have diapason [3; 10]." );
+        }
+    }
+
+
+    return options;
+}
+
+
+
+
+std::vector< int >
+loadScript( const std::string& file ) {
+
+    using namespace puzzlen;
+
+    std::ifstream  fs;
+    if (file != "-") {
+        fs.open( file.c_str() );
+        if ( !fs.is_open() ) {
+            throw Exception( "Script " + file + " is not found." );
+        }
+    }
+    std::istream&  in = (file == "-") ? std::cin : fs;
+
+    std::vector< int >  script;
+    char c;
+    while ( in.get( c ) ) {
+        const char* d =
+            std::strchr( PuzzleN::DIRECTION_NAME, std::toupper( c ) );
+        if ( (c != '\0') && d ) {
+            script.push_back( static_cast< int >( d - PuzzleN::DIRECTION_NAME ) );
+        }
+    }
+
+    return script;
+}
+
+
+
+
+template< class T >
+bool
+gesture( puzzlen::PuzzleN& puzzle,  const T& tables,  int direction ) {
+
+    using namespace puzzlen;
+
+    // сдвинуть можно только соседа пустой ячейки с противоположной стороны
+    const int from = tables.source( puzzle.emptyElement(), direction );
+    if (from < 0) {
+        return false;
+    }
+
+    // тянем элемент мышью за центр ровно на одну ячейку
+    const int dx = DIRECTION_DX[ direction ];
+    const int dy = DIRECTION_DY[ direction ];
+    const int cellSize = static_cast< int >( puzzle.cellSize );
+    const int x = tables.column( from ) * cellSize + cellSize / 2;
+    const int y = tables.row( from ) * cellSize + cellSize / 2;
+    puzzle.pressMouseButton( true );
+    puzzle.firstClick( x, y );
+    puzzle.move( x + dx * cellSize,  y + dy * cellSize );
+    puzzle.pressMouseButton( false );
+    puzzle.stickMove();
+    puzzle.resetFirstClick();
+
+    return true;
+}
+
+
+int
+shuffles( const options_t& options ) {
+
+    using namespace puzzlen;
+
+    // # Пачками, чтобы не держать в памяти миллионы полей сразу.
+    static const size_t BATCH = 1 << 16;
+
+    const size_t cells = options.n * options.m;
+    PuzzleN::field_t  batch;
+    PuzzleN::field_t  board( cells );
+    size_t generated = 0;
+    size_t unsolvable = 0;
+    size_t checksum = 0;
+    double seconds = 0.0;
+    for (uint64_t k = 0; generated < options.shuffles; ++k) {
+        const size_t count = std::min( BATCH, options.shuffles - generated );
+        const auto start = std::chrono::steady_clock::now();
+        PuzzleN::shuffleBatch(
+            batch, options.n, options.m, options.seed + k * BATCH, count
+        );
+        seconds += std::chrono::duration< double >(
+            std::chrono::steady_clock::now() - start
+        ).count();
+        generated += count;
+        checksum += batch.back();
+        // # Решаемость проверяется у каждого поля пачки, вне замера.
+        for (size_t j = 0; j < count; ++j) {
+            const auto first = batch.cbegin() + j * cells;
+            std::copy( first, first + cells, board.begin() );
+            if ( !PuzzleN::solvable( board, options.n, options.m ) ) {
+                ++unsolvable;
+            }
+        }
+    }
+
+    std::cout <<
+        "board       " << options.n << " x " << options.m << "\n" <<
+        "shuffles    " << generated << "\n" <<
+        "unsolvable  " << unsolvable << "\n" <<
+        "time        " << seconds << " s\n" <<
+        "boards/s    " << ((seconds > 0.0) ? (generated / seconds) : 0.0) << "\n" <<
+        "checksum    " << checksum << std::endl;
+
+    return (unsolvable == 0) ? 0 : -1;
+}
+
+
+
+
+
+
+int
+shifts( const options_t& options ) {
+
+    using namespace puzzlen;
+
+    PuzzleN  puzzle( options.n, options.m, CELL_SIZE );
+    PuzzleN::field_t  runtimeLast;
+    size_t runtimeApplied = 0;
+    const double runtime = shiftBoards( options, puzzle, runtimeLast, runtimeApplied );
+
+    PuzzleN::field_t  boardLast;
+    size_t boardApplied = 0;
+    double compiled = 0.0;
+    const bool specialised = withBoard( options.n, options.m, [ & ] ( auto board ) {
+        compiled = shiftBoards( options, board, boardLast, boardApplied );
+    } );
+
+    const size_t total = options.shifts * options.boards;
+    std::cout <<
+        "board       " << options.n << " x " << options.m << "\n" <<
+        "boards      " << options.boards << "\n" <<
+        "shifts      " << total << " (applied " << runtimeApplied << ")\n" <<
+        "PuzzleN     " << ((runtime > 0.0) ? (total / runtime) : 0.0) <<
+            " moves/s (with history and damage)\n";
+    if ( !specialised ) {
+        std::cout << "Board       not instantiated for this size" << std::endl;
+        return 0;
+    }
+    std::cout <<
+        "Board       " << ((compiled > 0.0) ? (total / compiled) : 0.0) << " moves/s\n" <<
+        "speedup     " << ((compiled > 0.0) ? (runtime / compiled) : 0.0) <<
+            " (Board records neither)" << std::endl;
+
+    if ( (boardLast != runtimeLast) || (boardApplied != runtimeApplied) ) {
+        std::cerr << "Board and PuzzleN diverged." << std::endl;
+        return -1;
+    }
+
+    return 0;
+}
+
+
+
+
+int
+frames( const options_t& options ) {
+
+    using namespace puzzlen;
+
+    // шагов мыши на одно перетаскивание
+    static const int STEPS = 8;
+    // каждое такое перетаскивание - перетасовка поля
+    static const size_t SHUFFLE_EVERY = 1000;
+
+    PuzzleN  puzzle( options.n, options.m, CELL_SIZE );
+    if ( options.seeded ) {
+        puzzle.shuffle( options.seed );
+    }
+    const Renderer  renderer( puzzle );
+    const size_t width  = options.n * CELL_SIZE;
+    const size_t height = options.m * CELL_SIZE;
+    Framebuffer  incremental( width, height );
+    Framebuffer  full( width, height );
+    renderer.drawAll( incremental );
+    puzzle.clearDamage();
+
+    Random  random( options.seed );
+    size_t count = 0;
+    size_t touchedIncremental = 0;
+    size_t touchedFull = 0;
+    size_t maxIncremental = 0;
+    const auto frame = [ & ] () -> bool {
+        const size_t touched = renderer.draw( incremental, puzzle.damage() );
+        puzzle.clearDamage();
+        touchedIncremental += touched;
+        maxIncremental = std::max( maxIncremental, touched );
+        touchedFull += renderer.drawAll( full );
+        ++count;
+        return (incremental == full);
+    };
+
+    const int cs = static_cast< int >( CELL_SIZE );
+    for (size_t k = 0; k < options.frames; ++k) {
+        if ( (k > 0) && (k % SHUFFLE_EVERY == 0) ) {
+            puzzle.shuffle( options.seed + k );
+            if ( !frame() ) {
+                std::cerr << "Frame " << count << " differs after shuffle." << std::endl;
+                return -1;
+            }
+        }
+
+        // тянем соседа пустой ячейки на случайную долю ячейки
+        const int direction = static_cast< int >( random.below( 4 ) );
+        const int dx = DIRECTION_DX[ direction ];
+        const int dy = DIRECTION_DY[ direction ];
+        const PuzzleN::logicCoord_t elc = puzzle.ci( puzzle.emptyElement() );
+        const PuzzleN::logicCoord_t lc = { elc.x - dx,  elc.y - dy };
+        if ( !puzzle.inside( lc ) ) {
+            continue;
+        }
+        const int distance = static_cast< int >( random.below( cs + 1 ) );
+        const int x = lc.x * cs + cs / 2;
+        const int y = lc.y * cs + cs / 2;
+        puzzle.pressMouseButton( true );
+        puzzle.firstClick( x, y );
+        for (int step = 1; step <= STEPS; ++step) {
+            puzzle.move(
+                x + dx * distance * step / STEPS,
+                y + dy * distance * step / STEPS
+            );
+            if ( !frame() ) {
+                std::cerr << "Frame " << count << " differs while dragging." << std::endl;
+                return -1;
+            }
+        }
+        puzzle.pressMouseButton( false );
+        puzzle.stickMove();
+        puzzle.resetFirstClick();
+        if ( !frame() ) {
+            std::cerr << "Frame " << count << " differs after release." << std::endl;
+            return -1;
+        }
+    }
+
+    std::cout <<
+        "board         " << options.n << " x " << options.m <<
+            " (" << width << " x " << height << " px)\n" <<
+        "frames        " << count << " (all equal to full redraws)\n" <<
+        "pixels/frame  " << ((count > 0) ? (touchedIncremental / count) : 0) <<
+            " (max " << maxIncremental << ")\n" <<
+        "full redraw   " << ((count > 0) ? (touchedFull / count) : 0) << "\n" <<
+        "saved         " << ((touchedFull > 0) ?
+            (100.0 - 100.0 * touchedIncremental / touchedFull) : 0.0) << " %" << std::endl;
+
+    return 0;
+}
+
+
+
+
+int
+schedule( const options_t& options ) {
+
+    using namespace puzzlen;
+
+    typedef FrameScheduler::time_t  time_t;
+
+    // мышь опрашивается 1000 раз в секунду
+    static const time_t EVENT_INTERVAL = 1000;
+    // событий мыши на одно перетаскивание
+    static const int DRAG_EVENTS = 48;
+    // событий мыши без нажатия между перетаскиваниями
+    static const int IDLE_EVENTS = 250;
+    // прежняя перерисовка по таймеру, мкс
+    static const time_t TIMER_INTERVAL = 10000;
+
+    PuzzleN  puzzle( options.n, options.m, CELL_SIZE );
+    if ( options.seeded ) {
+        puzzle.shuffle( options.seed );
+    }
+    const Renderer  renderer( puzzle );
+    const size_t width  = options.n * CELL_SIZE;
+    const size_t height = options.m * CELL_SIZE;
+    Framebuffer  frame( width, height );
+    Framebuffer  full( width, height );
+    renderer.drawAll( frame );
+    puzzle.clearDamage();
+
+    FrameScheduler  scheduler( puzzle );
+    time_t now = 0;
+    time_t lastFrame = 0;
+    time_t minGap = FrameScheduler::NONE;
+    bool drawn = false;
+
+    // Рисует запланированный кадр, если подошло его время.
+    // # Как WM_TIMER / WM_PAINT в окне: кадр рисуется в момент due().
+    const auto flush = [ & ] () -> bool {
+        if ( !scheduler.pending() || (scheduler.due() > now) ) {
+            return true;
+        }
+        const time_t at = scheduler.due();
+        if ( drawn ) {
+            const time_t gap = at - lastFrame;
+            if (gap < scheduler.interval) {
+                std::cerr << "Frame " << scheduler.counters().frames <<
+                    " follows the previous one in " << gap << " us." << std::endl;
+                return false;
+            }
+            minGap = std::min( minGap, gap );
+        }
+        const auto begin = std::chrono::steady_clock::now();
+        renderer.draw( frame, puzzle.damage() );
+        puzzle.clearDamage();
+        const auto cost = std::chrono::duration_cast< std::chrono::microseconds >(
+            std::chrono::steady_clock::now() - begin
+        ).count();
+        scheduler.presented( at,  at + static_cast< time_t >( cost ) );
+        lastFrame = at;
+        drawn = true;
+        return true;
+    };
+
+    // Событие мыши через EVENT_INTERVAL после прошлого.
+    const auto input = [ & ] ( int x, int y, int button ) -> bool {
+        now += EVENT_INTERVAL;
+        if ( !flush() ) {
+            return false;
+        }
+        if (button > 0) {
+            puzzle.pressMouseButton( true );
+            puzzle.firstClick( x, y );
+        } else if (button < 0) {
+            puzzle.pressMouseButton( false );
+            puzzle.stickMove();
+            puzzle.resetFirstClick();
+        } else {
+            puzzle.move( x, y );
+        }
+        scheduler.event( now );
+        return flush();
+    };
+
+    Random  random( options.seed );
+    const int cs = static_cast< int >( CELL_SIZE );
+    size_t drags = 0;
+    while (drags < options.schedule) {
+        // тянем соседа пустой ячейки на случайную долю ячейки
+        const int direction = static_cast< int >( random.below( 4 ) );
+        const int dx = DIRECTION_DX[ direction ];
+        const int dy = DIRECTION_DY[ direction ];
+        const PuzzleN::logicCoord_t elc = puzzle.ci( puzzle.emptyElement() );
+        const PuzzleN::logicCoord_t lc = { elc.x - dx,  elc.y - dy };
+        if ( !puzzle.inside( lc ) ) {
+            continue;
+        }
+        const int distance = static_cast< int >( random.below( cs + 1 ) );
+        const int x = lc.x * cs + cs / 2;
+        const int y = lc.y * cs + cs / 2;
+        if ( !input( x, y, 1 ) ) {
+            return -1;
+        }
+        for (int step = 1; step <= DRAG_EVENTS; ++step) {
+            if ( !input(
+                x + dx * distance * step / DRAG_EVENTS,
+                y + dy * distance * step / DRAG_EVENTS,
+                0
+            ) ) {
+                return -1;
+            }
+        }
+        if ( !input( x + dx * distance,  y + dy * distance,  -1 ) ) {
+            return -1;
+        }
+        ++drags;
+
+        // без нажатия поле не меняется: после отложенного кадра
+        // за отпускание кадров быть не должно
+        const uint64_t framesAtRelease =
+            scheduler.counters().frames + (scheduler.pending() ? 1 : 0);
+        for (int k = 0; k < IDLE_EVENTS; ++k) {
+            if ( !input(
+                static_cast< int >( random.below( width ) ),
+                static_cast< int >( random.below( height ) ),
+                0
+            ) ) {
+                return -1;
+            }
+        }
+        if ( scheduler.pending() || !puzzle.damage().empty() ) {
+            std::cerr << "Drag " << drags << " left the damage undrawn." << std::endl;
+            return -1;
+        }
+        if (scheduler.counters().frames != framesAtRelease) {
+            std::cerr << "Drag " << drags << ": " <<
+                (scheduler.counters().frames - framesAtRelease) <<
+                " frames while idle." << std::endl;
+            return -1;
+        }
+        renderer.drawAll( full );
+        if (frame != full) {
+            std::cerr << "Drag " << drags << ": last frame differs from full redraw." << std::endl;
+            return -1;
+        }
+    }
+
+    const FrameScheduler::counters_t& c = scheduler.counters();
+    const uint64_t timerFrames = now / TIMER_INTERVAL;
+    std::cout <<
+        "board         " << options.n << " x " << options.m <<
+            " (" << width << " x " << height << " px)\n" <<
+        "drags         " << drags << "\n" <<
+        "model time    " << (static_cast< double >( now ) / 1e6) << " s\n" <<
+        "events        " << c.events <<
+            " (idle " << c.idleEvents << ", coalesced " << c.coalesced << ")\n" <<
+        "frames        " << c.frames << " (min gap " <<
+            ((minGap != FrameScheduler::NONE) ? minGap : 0) << " us)\n" <<
+        "timer frames  " << timerFrames << " (every " << TIMER_INTERVAL / 1000 << " ms)\n" <<
+        "saved         " << ((timerFrames > 0) ?
+            (100.0 - 100.0 * c.frames / timerFrames) : 0.0) << " %\n" <<
+        "active time   " << (static_cast< double >( c.activeTime ) / 1e3) << " ms (" <<
+            ((c.frames > 0) ? (c.activeTime / c.frames) : 0) << " us/frame)" << std::endl;
+
+    return 0;
+}
+
+
+
+
+int
+record( const options_t& options ) {
+
+    using namespace puzzlen;
+
+    // шагов мыши на одно перетаскивание
+    static const int STEPS = 8;
+    // событий мыши без нажатия между перетаскиваниями
+    static const int IDLE_EVENTS = 4;
+    // каждое такое перетаскивание - перетасовка поля
+    static const size_t SHUFFLE_EVERY = 1000;
+    // каждое такое перетаскивание отменяется, следующее за ним - повторяется
+    static const size_t UNDO_EVERY = 16;
+    // мышь опрашивается 1000 раз в секунду
+    static const Recorder::time_t EVENT_INTERVAL = 1000;
+
+    PuzzleN  puzzle( options.n, options.m, CELL_SIZE );
+    puzzle.shuffle( options.seed );
+    Recorder  recorder( puzzle );
+
+    Random  random( options.seed );
+    Recorder::time_t now = 0;
+    const int cs = static_cast< int >( CELL_SIZE );
+    const int width  = static_cast< int >( options.n ) * cs;
+    const int height = static_cast< int >( options.m ) * cs;
+    for (size_t k = 0; k < options.moves; ++k) {
+        if ( (k > 0) && (k % SHUFFLE_EVERY == 0) ) {
+            now += EVENT_INTERVAL;
+            recorder.shuffle( puzzle.shuffle(), now );
+        }
+
+        // тянем мышью случайную ячейку на случайное расстояние: часть
+        // перетаскиваний не разрешены, часть - не до конца
+        const int x = static_cast< int >( random.below( width ) );
+        const int y = static_cast< int >( random.below( height ) );
+        const int direction = static_cast< int >( random.below( 4 ) );
+        const int distance = static_cast< int >( random.below( cs * 3 / 2 ) );
+        now += EVENT_INTERVAL;
+        puzzle.pressMouseButton( true );
+        puzzle.firstClick( x, y );
+        recorder.press( x, y, now );
+        for (int step = 1; step <= STEPS; ++step) {
+            const int mx = x + DIRECTION_DX[ direction ] * distance * step / STEPS;
+            const int my = y + DIRECTION_DY[ direction ] * distance * step / STEPS;
+            now += EVENT_INTERVAL;
+            puzzle.move( mx, my );
+            recorder.move( mx, my, now );
+        }
+        now += EVENT_INTERVAL;
+        puzzle.pressMouseButton( false );
+        puzzle.stickMove();
+        puzzle.resetFirstClick();
+        recorder.release( now );
+
+        if (k % UNDO_EVERY == 0) {
+            now += EVENT_INTERVAL;
+            if ( puzzle.undo() ) {
+                recorder.undo( now );
+            }
+        } else if (k % UNDO_EVERY == 1) {
+            now += EVENT_INTERVAL;
+            if ( puzzle.redo() ) {
+                recorder.redo( now );
+            }
+        }
+
+        for (int e = 0; e < IDLE_EVENTS; ++e) {
+            const int mx = static_cast< int >( random.below( width ) );
+            const int my = static_cast< int >( random.below( height ) );
+            now += EVENT_INTERVAL;
+            puzzle.move( mx, my );
+            recorder.move( mx, my, now );
+        }
+        puzzle.clearDamage();
+    }
+    recorder.finish();
+
+    try {
+        recorder.save( options.record );
+        const Replayer  replayer( Replayer::load( options.record ) );
+        PuzzleN  copy( replayer.N, replayer.M, replayer.cellSize );
+        replayer.replay( copy );
+        if ( !replayer.verify( copy ) || !replayer.verify( puzzle ) ) {
+            std::cerr << "Replay of " << options.record << " diverged." << std::endl;
+            return -1;
+        }
+    } catch ( const Exception& ex ) {
+        std::cerr << ex.what() << std::endl;
+        return -1;
+    }
+
+    const size_t bytes = recorder.data().size();
+    std::cout <<
+        "board         " << options.n << " x " << options.m << "\n" <<
+        "events        " << recorder.events() << "\n" <<
+        "size          " << bytes << " bytes (" <<
+            (static_cast< double >( bytes ) / std::max( recorder.events(), size_t( 1 ) )) <<
+            " per event)\n" <<
+        "file          " << options.record << " (replay verified)" << std::endl;
+
+    return 0;
+}
+
+
+
+
+int
+replay( const options_t& options ) {
+
+    using namespace puzzlen;
+
+    try {
+        const Replayer  replayer( Replayer::load( options.replay ) );
+        PuzzleN  puzzle( replayer.N, replayer.M, replayer.cellSize );
+
+        size_t events = 0;
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t r = 0; r < options.repeat; ++r) {
+            events += replayer.replay( puzzle );
+        }
+        const double seconds = std::chrono::duration< double >(
+            std::chrono::steady_clock::now() - start
+        ).count();
+
+        std::cout <<
+            "board         " << replayer.N << " x " << replayer.M << "\n" <<
+            "events        " << replayer.events() << " (" <<
+                (replayer.duration() / 1e6) << " s recorded)\n" <<
+            "repeats       " << options.repeat << "\n" <<
+            "time          " << seconds << " s\n" <<
+            "events/s      " << ((seconds > 0.0) ? (events / seconds) : 0.0) << std::endl;
+
+        if ( !replayer.finished() ) {
+            std::cout << "final state   not recorded" << std::endl;
+            return 0;
+        }
+        if ( !replayer.verify( puzzle ) ) {
+            std::cerr << "Final field or move state differs from the recording." << std::endl;
+            return -1;
+        }
+        std::cout << "final state   equal" << std::endl;
+
+    } catch ( const Exception& ex ) {
+        std::cerr << ex.what() << std::endl;
+        return -1;
+    }
+
+    return 0;
+}
+
+
+
+
+int
+history( const options_t& options ) {
+
+    using namespace puzzlen;
+
+    // сколько раз запоминаем поле
+    static const size_t CHECKPOINTS = 64;
+
+    PuzzleN  puzzle( options.n, options.m, CELL_SIZE );
+    puzzle.shuffle( options.seed );
+    const PuzzleN::field_t  initial = puzzle.field();
+
+    // # Точка - (ходов в истории, поле после них).
+    Random  random( options.seed );
+    std::vector< size_t >  marks;
+    for (size_t c = 0; c < CHECKPOINTS; ++c) {
+        marks.push_back( random.below( options.history + 1 ) );
+    }
+    std::sort( marks.begin(), marks.end() );
+    std::vector< std::pair< size_t, PuzzleN::field_t > >  checkpoints;
+
+    auto mark = marks.cbegin();
+    while (puzzle.history().size() < options.history) {
+        for ( ; (mark != marks.cend()) && (*mark == puzzle.history().size()); ++mark) {
+            checkpoints.emplace_back( *mark, puzzle.field() );
+        }
+        puzzle.shift( static_cast< PuzzleN::direction_t >( random.below( 4 ) ) );
+    }
+    for ( ; mark != marks.cend(); ++mark) {
+        checkpoints.emplace_back( *mark, puzzle.field() );
+    }
+    const PuzzleN::field_t  last = puzzle.field();
+
+    const auto start = std::chrono::steady_clock::now();
+    size_t undone = 0;
+    while ( puzzle.undo() ) {
+        ++undone;
+    }
+    const auto middle = std::chrono::steady_clock::now();
+    size_t redone = 0;
+    while ( puzzle.redo() ) {
+        ++redone;
+    }
+    const auto finish = std::chrono::steady_clock::now();
+
+    if ( (undone != options.history) || (redone != options.history) ) {
+        std::cerr << "History lost moves." << std::endl;
+        return -1;
+    }
+    if (puzzle.field() != last) {
+        std::cerr << "Redo did not restore the final field." << std::endl;
+        return -1;
+    }
+    puzzle.seek( 0 );
+    if (puzzle.field() != initial) {
+        std::cerr << "Undo did not restore the initial field." << std::endl;
+        return -1;
+    }
+
+    // # Переходим к точкам вразброс: назад и вперёд.
+    for (size_t c = checkpoints.size(); c > 1; --c) {
+        std::swap( checkpoints[ c - 1 ],  checkpoints[ random.below( c ) ] );
+    }
+    for (auto itr = checkpoints.cbegin(); itr != checkpoints.cend(); ++itr) {
+        puzzle.seek( itr->first );
+        if ( (puzzle.history().position() != itr->first) || (puzzle.field() != itr->second) ) {
+            std::cerr << "Seek to move " << itr->first << " gave another field." << std::endl;
+            return -1;
+        }
+    }
+
+    const double undoSeconds = std::chrono::duration< double >( middle - start ).count();
+    const double redoSeconds = std::chrono::duration< double >( finish - middle ).count();
+    const size_t bytes = puzzle.history().bytes();
+    const double snapshots = static_cast< double >( options.history ) *
+        options.n * options.m * sizeof( PuzzleN::element_t );
+    std::cout <<
+        "board         " << options.n << " x " << options.m << "\n" <<
+        "moves         " << options.history << "\n" <<
+        "memory        " << bytes << " bytes (" <<
+            (static_cast< double >( bytes ) * 8 / options.history) << " bits per move)\n" <<
+        "snapshots     " << snapshots << " bytes (a field per move)\n" <<
+        "undo/s        " << ((undoSeconds > 0.0) ? (undone / undoSeconds) : 0.0) << "\n" <<
+        "redo/s        " << ((redoSeconds > 0.0) ? (redone / redoSeconds) : 0.0) << "\n" <<
+        "checkpoints   " << checkpoints.size() << " equal" << std::endl;
+
+    return 0;
+}
+
+
+
+int
+huge( const options_t& options ) {
+
+    using namespace puzzlen;
+
+    int code = 0;
+    try {
+        withHugeBoard( options.n, options.m, [ & ] ( auto& board ) {
+            code = hugeMoves( options, board );
+        } );
+    } catch ( const Exception& ex ) {
+        std::cerr << ex.what() << std::endl;
+        return -1;
+    } catch ( const std::bad_alloc& ) {
+        std::cerr << "Not enough memory for the board." << std::endl;
+        return -1;
+    }
+
+    return code;
+}
+
+
+
+
+int
+compact( const options_t& options ) {
+
+    using namespace puzzlen;
+
+    // случайных ходов на каждом поле
+    static const size_t MOVES = 64;
+
+    Random  random( options.seed );
+    size_t boards = 0;
+    size_t moves = 0;
+    for (size_t side = 3; side <= 10; ++side) {
+        const Packing  packing( side, side );
+        const Geometry  g( side, side );
+        for (size_t k = 0; k < options.compact; ++k, ++boards) {
+            PuzzleN  puzzle( side, side, CELL_SIZE );
+            puzzle.shuffle( options.seed + k );
+
+            CompactState100  state( puzzle.field(), packing );
+            if (state.field( packing ) != puzzle.field()) {
+                std::cerr << "Decoded field differs on " << side << " x " << side << "." << std::endl;
+                return -1;
+            }
+            // # Поле до 16 ячеек - ещё и в одном слове.
+            if ( (packing.words == 1) &&
+                 (CompactState16( puzzle.field(), packing ).field( packing ) != puzzle.field())
+            ) {
+                std::cerr << "Decoded single-word field differs." << std::endl;
+                return -1;
+            }
+
+            for (size_t j = 0; j < MOVES; ++j) {
+                const auto d = static_cast< PuzzleN::direction_t >( random.below( 4 ) );
+                const int blank = puzzle.emptyElement();
+                const int from = g.source( blank, d );
+                const CompactState100  before = state;
+                if ( !puzzle.shift( d ) ) {
+                    if (from >= 0) {
+                        std::cerr << "Shift was rejected for a valid cell." << std::endl;
+                        return -1;
+                    }
+                    continue;
+                }
+                ++moves;
+                state.swap( blank, from, packing );
+
+                // # Равные состояния - равный хеш; ход меняет состояние.
+                const CompactState100  expected( puzzle.field(), packing );
+                if ( (state != expected) || (state.hash() != expected.hash())
+                  || (std::hash< CompactState100 >()( state ) != std::hash< CompactState100 >()( expected ))
+                  || (state == before)
+                ) {
+                    std::cerr << "Swap does not match PuzzleN::shift() on " <<
+                        side << " x " << side << "." << std::endl;
+                    return -1;
+                }
+            }
+            if (state.field( packing ) != puzzle.field()) {
+                std::cerr << "Decoded field differs after moves." << std::endl;
+                return -1;
+            }
+        }
+    }
+
+    std::cout <<
+        "boards        " << boards << " (3 x 3 .. 10 x 10)\n" <<
+        "moves         " << moves << "\n" <<
+        "states        equal" << std::endl;
+
+    return 0;
+}
+
+
+
+
+template< class B >
+int
+hugeMoves( const options_t& options,  B& board ) {
+
+    using namespace puzzlen;
+
+    const auto start = std::chrono::steady_clock::now();
+    if ( options.seeded ) {
+        board.shuffle( options.seed );
+    }
+    const auto shuffled = std::chrono::steady_clock::now();
+    const std::vector< typename B::element_t >  initial = board.elements();
+    const bool solved = board.solved();
+
+    History  history;
+    history.reserve( options.huge );
+    Random  random( options.seed );
+    const auto moving = std::chrono::steady_clock::now();
+    for (size_t k = 0; k < options.huge; ++k) {
+        const auto direction = static_cast< PuzzleN::direction_t >( random.below( 4 ) );
+        if ( board.shift( direction ) ) {
+            history.push( direction );
+        }
+    }
+    const auto moved = std::chrono::steady_clock::now();
+
+    // # Обратный ход делает элемент по другую сторону пустой ячейки: он
+    //   должен разрешать сдвиг в эту сторону.
+    const size_t applied = history.size();
+    const size_t n = options.n;
+    while ( history.canUndo() ) {
+        const auto direction = PuzzleN::opposite(
+            static_cast< PuzzleN::direction_t >( history.undo() )
+        );
+        const size_t e = board.emptyElement();
+        const size_t from =
+            (direction == PuzzleN::NORTH) ? (e + n) :
+            (direction == PuzzleN::SOUTH) ? (e - n) :
+            (direction == PuzzleN::WEST)  ? (e + 1) : (e - 1);
+        const auto ps = board.permitShift( from );
+        const bool permitted =
+            (direction == PuzzleN::NORTH) ? ps.north :
+            (direction == PuzzleN::SOUTH) ? ps.south :
+            (direction == PuzzleN::WEST)  ? ps.west : ps.east;
+        if ( !permitted || !board.shift( direction ) ) {
+            std::cerr << "Element at " << from << " may not move back." << std::endl;
+            return -1;
+        }
+    }
+    const auto undone = std::chrono::steady_clock::now();
+    if ( (board.elements() != initial) || (board.solved() != solved) ) {
+        std::cerr << "Undo did not restore the initial field." << std::endl;
+        return -1;
+    }
+
+    const auto seconds = [] ( std::chrono::steady_clock::time_point a,
+                              std::chrono::steady_clock::time_point b ) {
+        return std::chrono::duration< double >( b - a ).count();
+    };
+    const double moveSeconds = seconds( moving, moved );
+    const double undoSeconds = seconds( moved, undone );
+    std::cout <<
+        "board         " << options.n << " x " << options.m << "\n" <<
+        "element       " << sizeof( typename B::element_t ) * 8 << " bit\n" <<
+        "field         " << board.bytes() << " bytes\n" <<
+        "history       " << history.bytes() << " bytes\n" <<
+        "shuffle       " << seconds( start, shuffled ) << " s\n" <<
+        "moves         " << options.huge << " (applied " << applied << ")\n" <<
+        "moves/s       " << ((moveSeconds > 0.0) ? (options.huge / moveSeconds) : 0.0) << "\n" <<
+        "undo/s        " << ((undoSeconds > 0.0) ? (applied / undoSeconds) : 0.0) << "\n" <<
+        "undo          initial field restored" << std::endl;
+
+    return 0;
+}
+
+
+
+
+template< class T >
+double
+shiftBoards(
+    const options_t& options,  T& puzzle,  puzzlen::PuzzleN::field_t& last,  size_t& applied
+) {
+    using namespace puzzlen;
+
+    Random  random( options.seed );
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t b = 0; b < options.boards; ++b) {
+        PuzzleN  shuffled( options.n, options.m, CELL_SIZE );
+        if ( options.seeded ) {
+            shuffled.shuffle( options.seed + b );
+        }
+        puzzle.field( shuffled.field() );
+        for (size_t k = 0; k < options.shifts; ++k) {
+            if ( puzzle.shift( static_cast< PuzzleN::direction_t >( random.below( 4 ) ) ) ) {
+                ++applied;
+            }
+        }
+    }
+    const auto finish = std::chrono::steady_clock::now();
+    last = puzzle.field();
+
+    return std::chrono::duration< double >( finish - start ).count();
+}
+
+
+} // namespace
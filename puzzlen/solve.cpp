@@ -0,0 +1,581 @@
+/**
+* Решатель для игры "пятнашки".
+*
+* Находит оптимальные решения (IDA*) и сообщает скорость поиска, узлов/с.
+*
+* Запускается из консоли командой
+*   "puzzlen-solve [N [M]] [--count COUNT] [--seed S] [--board ELEMENTS]
+*                  [--patterns FILE] [--threads T] [--scaling T]
+*                  [--bidirectional MB] [--heuristic NAME] [--hints P]"
+* Где N, M     - количество ячеек по ширине и высоте.
+*     --count  - сколько случайных решаемых полей решить.
+*     --seed   - зерно для случайных полей.
+*     --board  - решить заданное поле: элементы в порядке PuzzleN::field_t
+*                через пробел или запятую, 0 - пустая ячейка.
+*     --patterns - базы шаблонов, построенные puzzlen-patterns; без них
+*                эвристика - манхэттенское расстояние + линейные конфликты.
+*     --threads  - потоков параллельного поиска, 0 - по количеству ядер.
+*     --scaling  - решить те же поля на 1, 2, 4, ... T потоках и сравнить
+*                скорость.
+*     --heuristic - эвристика без баз шаблонов: conflict (по умолчанию) или
+*                walking (walking distance, см. Walking). С walking те же
+*                поля решаются и с conflict, и печатается, во сколько раз
+*                меньше узлов.
+*     --bidirectional - решить те же поля однонаправленным и двунаправленным
+*                поиском (периметр вокруг собранного поля не больше MB
+*                мегабайт, см. Perimeter) и сравнить узлы и время.
+*     --hints  - сыграть поля по подсказкам (см. Hint): каждый ход с
+*                вероятностью P % - не по подсказке. Сообщает, сколько
+*                подсказок из плана, после отступлений, с нуля и по
+*                оценке, их p50 / p99 и долю кратчайших. На полях до
+*                3 x 3 каждая кратчайшая подсказка сверяется с решателем.
+* Пример: puzzlen-solve 3 --count 100
+*         puzzlen-solve 4 --count 10 --scaling 64
+*         puzzlen-solve 4 --count 10 --bidirectional 256
+*         puzzlen-solve 4 --count 10 --heuristic walking
+*         puzzlen-solve 4 --count 10 --hints 10
+*         puzzlen-solve 4 --board "1 2 3 4 5 6 7 8 9 10 11 12 13 14 0 15"
+*
+* @see configure.h для установки параметров.
+*/
+
+
+#include "include/stdafx.h"
+#include "include/Hint.h"
+#include "include/Instrument.h"
+#include "include/PuzzleN.h"
+#include "include/Solver.h"
+#include <cstring>
+#include <iomanip>
+
+
+namespace {
+
+
+struct options_t {
+    size_t  n;
+    size_t  m;
+    size_t  count;
+    uint64_t  seed;
+    puzzlen::PuzzleN::field_t  board;
+    std::string  patterns;
+    size_t  threads;
+    size_t  scaling;
+    // мегабайт на периметр, 0 - только однонаправленный поиск
+    size_t  bidirectional;
+    puzzlen::Solver::heuristic_t  heuristic;
+    // % ходов не по подсказке; больше 100 - без подсказок
+    size_t  hints;
+};
+
+
+// Поля, на которых кратчайшие подсказки сверяются с решателем.
+static const size_t HINT_CHECK_CELLS = 9;
+
+
+// Разбирает параметры командной строки.
+options_t parse( int argc, char** argv );
+
+
+// Итоги по решённым полям.
+typedef struct {
+    size_t  count;
+    size_t  length;
+    uint64_t  nodes;
+    double  seconds;
+} total_t;
+
+
+// Решает поля по очереди, проверяя решения.
+// @param verbose  Печатать строку по каждому полю.
+// @throw Exception Если решение неверно.
+total_t solve(
+    const options_t&,
+    const puzzlen::Solver&,
+    const puzzlen::PuzzleN::field_t& boards,
+    bool verbose
+);
+
+
+// Проверяет решение, повторяя его ходы на поле.
+bool verify(
+    const options_t&,
+    const puzzlen::PuzzleN::field_t&,
+    const std::string& moves
+);
+
+
+// Играет поля по подсказкам, отступая от них с вероятностью
+// options.hints %, и печатает итоги.
+// @throw Exception Если подсказки не ведут к сборке или кратчайшая
+//        подсказка не совпала с решателем.
+void play(
+    const options_t&,
+    const puzzlen::Solver&,
+    const puzzlen::PuzzleN::field_t& boards
+);
+
+
+} // namespace
+
+
+
+
+int main( int argc, char** argv ) {
+
+    using namespace puzzlen;
+
+    options_t  options;
+    try {
+        options = parse( argc, argv );
+    } catch ( const Exception& ex ) {
+        std::cerr << ex.what() << std::endl;
+        return -1;
+    }
+
+#ifdef PUZZLEN_INSTRUMENT
+    Instrument::reportAtExit( "" );
+#endif
+
+    PuzzleN::field_t  boards = options.board;
+    if ( boards.empty() ) {
+        PuzzleN::shuffleBatch(
+            boards, options.n, options.m, options.seed, options.count
+        );
+    }
+
+    try {
+        Solver  solver( options.n, options.m );
+        if ( !options.patterns.empty() ) {
+            solver.patterns( std::make_shared< const Patterns >( options.patterns ) );
+        }
+
+        if (options.threads != 1) {
+            solver.pool( std::make_shared< ThreadPool >( options.threads ) );
+        }
+
+        if ( options.patterns.empty() && (options.heuristic != Solver::CONFLICT) &&
+             (options.bidirectional == 0) && (options.scaling == 0)
+        ) {
+            // # Те же поля с манхэттенским расстоянием + конфликтами.
+            const total_t  base = solve( options, solver, boards, false );
+
+            const auto start = std::chrono::steady_clock::now();
+            solver.heuristic( options.heuristic );
+            const double building = std::chrono::duration< double >(
+                std::chrono::steady_clock::now() - start
+            ).count();
+            const total_t  total = solve( options, solver, boards, true );
+            if (total.length != base.length) {
+                throw Exception( "Heuristics found solutions of different length." );
+            }
+
+            const std::string  name = Solver::HEURISTIC_NAME[ options.heuristic ];
+            std::cout <<
+                "board          " << options.n << " x " << options.m << "\n" <<
+                "threads        " << (solver.pool() ? solver.pool()->size() : 1) << "\n" <<
+                "solved         " << total.count << "\n" <<
+                "length         " << total.length << " (equal)\n" <<
+                "tables         " << solver.walking()->bytes() << " bytes (" <<
+                    (solver.walking()->rows().narrow ? 16 : 32) << "-bit transitions), " <<
+                    building << " s\n" <<
+                "nodes          conflict " << base.nodes << " > " << name << " " << total.nodes <<
+                    " (x" << ((total.nodes > 0) ? (double( base.nodes ) / total.nodes) : 0.0) << ")\n" <<
+                "time           conflict " << base.seconds << " s > " << name << " " << total.seconds <<
+                    " s (x" << ((total.seconds > 0.0) ? (base.seconds / total.seconds) : 0.0) << ")" <<
+                    std::endl;
+            return 0;
+        }
+        solver.heuristic( options.heuristic );
+
+        if (options.hints <= 100) {
+            play( options, solver, boards );
+            return 0;
+        }
+
+        if (options.bidirectional > 0) {
+            // # Сначала однонаправленный поиск: периметра ещё нет.
+            const total_t  uni = solve( options, solver, boards, false );
+
+            const auto start = std::chrono::steady_clock::now();
+            solver.bidirectional( options.bidirectional << 20 );
+            const double building = std::chrono::duration< double >(
+                std::chrono::steady_clock::now() - start
+            ).count();
+            const Perimeter&  perimeter = *solver.perimeter();
+            const total_t  bi = solve( options, solver, boards, true );
+            if (bi.length != uni.length) {
+                throw Exception( "Bidirectional search found longer solutions." );
+            }
+
+            std::cout <<
+                "board          " << options.n << " x " << options.m << "\n" <<
+                "threads        " << (solver.pool() ? solver.pool()->size() : 1) << "\n" <<
+                "solved         " << bi.count << "\n" <<
+                "length         " << bi.length << " (equal)\n" <<
+                "perimeter      depth " << perimeter.depth() <<
+                    ", " << perimeter.size() << " boards, " <<
+                    (perimeter.bytes() >> 20) << " of " << options.bidirectional << " MB, " <<
+                    building << " s\n";
+            if (perimeter.depth() == 0) {
+                std::cout << "               budget too small: unidirectional search\n";
+            }
+            std::cout <<
+                "nodes          " << uni.nodes << " > " << bi.nodes <<
+                    " (x" << ((bi.nodes > 0) ? (double( uni.nodes ) / bi.nodes) : 0.0) << ")\n" <<
+                "time           " << uni.seconds << " s > " << bi.seconds <<
+                    " s (x" << ((bi.seconds > 0.0) ? (uni.seconds / bi.seconds) : 0.0) << ")" <<
+                    std::endl;
+            return 0;
+        }
+
+        if (options.scaling == 0) {
+            const total_t  total = solve( options, solver, boards, true );
+            std::cout <<
+                "board     " << options.n << " x " << options.m << "\n" <<
+                "threads   " << (solver.pool() ? solver.pool()->size() : 1) << "\n" <<
+                "solved    " << total.count << "\n" <<
+                "length    " << total.length << "\n" <<
+                "nodes     " << total.nodes << "\n" <<
+                "time      " << total.seconds << " s\n" <<
+                "nodes/s   " << ((total.seconds > 0.0) ? (total.nodes / total.seconds) : 0.0) << std::endl;
+            return 0;
+        }
+
+        // # Масштабирование: одни и те же поля на 1, 2, 4, ... потоках.
+        //   Один поток - поиск без пула.
+        std::cout <<
+            "board     " << options.n << " x " << options.m << "\n" <<
+            "boards    " << boards.size() / (options.n * options.m) << "\n" <<
+            "threads   time, s   nodes        nodes/s      speedup" << std::endl;
+        double base = 0.0;
+        for (size_t threads = 1; threads <= options.scaling; ) {
+            solver.pool( (threads > 1) ?
+                std::make_shared< ThreadPool >( threads ) :
+                std::shared_ptr< ThreadPool >()
+            );
+            const total_t  total = solve( options, solver, boards, false );
+            if (threads == 1) {
+                base = total.seconds;
+            }
+            std::cout << std::left <<
+                std::setw( 10 ) << threads <<
+                std::setw( 10 ) << total.seconds <<
+                std::setw( 13 ) << total.nodes <<
+                std::setw( 13 ) << ((total.seconds > 0.0) ? (total.nodes / total.seconds) : 0.0) <<
+                ((total.seconds > 0.0) ? (base / total.seconds) : 0.0) << std::endl;
+            threads = ( (threads * 2 > options.scaling) && (threads < options.scaling) ) ?
+                options.scaling : (threads * 2);
+        }
+
+    } catch ( const Exception& ex ) {
+        std::cerr << ex.what() << std::endl;
+        return -1;
+    }
+
+    return 0;
+}
+
+
+
+
+namespace {
+
+
+options_t
+parse( int argc, char** argv ) {
+
+    using namespace puzzlen;
+
+    options_t  options;
+    options.n = DEFAULT_N;
+    options.m = DEFAULT_M;
+    options.count = 1;
+    options.seed  = 0;
+    options.threads = 1;
+    options.scaling = 0;
+    options.bidirectional = 0;
+    options.heuristic = Solver::CONFLICT;
+    options.hints = 101;
+
+    std::string  board;
+    size_t count = 0;
+    for (int k = 1; k < argc; ++k) {
+        const std::string  word = argv[ k ];
+        if ( (word.size() > 2) && (word.compare( 0, 2, "--" ) == 0) ) {
+            if (k + 1 >= argc) {
+                throw Exception( "Option " + word + " needs a value." );
+            }
+            std::istringstream  wss( argv[ ++k ] );
+            if (word == "--count") {
+                wss >> options.count;
+            } else if (word == "--seed") {
+                wss >> options.seed;
+            } else if (word == "--board") {
+                board = wss.str();
+            } else if (word == "--patterns") {
+                wss >> options.patterns;
+            } else if (word == "--threads") {
+                wss >> options.threads;
+            } else if (word == "--scaling") {
+                wss >> options.scaling;
+            } else if (word == "--bidirectional") {
+                wss >> options.bidirectional;
+            } else if (word == "--heuristic") {
+                options.heuristic = Solver::heuristicByName( wss.str() );
+            } else if (word == "--hints") {
+                wss >> options.hints;
+                if ( !wss.fail() && (options.hints > 100) ) {
+                    throw Exception( "Share of moves against hints must have diapason [0; 100]." );
+                }
+            } else {
+                throw Exception( "Unknown option " + word + "." );
+            }
+            if ( wss.fail() ) {
+                throw Exception( "Value of option " + word + " is not recognized." );
+            }
+            continue;
+        }
+
+        std::istringstream  wss( word );
+        switch ( count ) {
+            // ширина
+            case 0:
+                wss >> options.n;
+                if ( wss.fail() ) {
+                    throw Exception( "Width of puzzle is not recognized." );
+                }
+                if ( (options.n > 10) || (options.n < 3) ) {
+                    throw Exception( "Width of puzzle must have diapason [3; 10]." );
+                }
+                break;
+
+            // высота
+            case 1:
+                wss >> options.m;
+                if ( wss.fail() ) {
+                    throw Exception( "Height of puzzle is not recognized." );
+                }
+                if ( (options.m > 10) || (options.m < 3) ) {
+                    throw Exception( "Height must have diapason [3; 10]." );
+                }
+                break;
+
+            default:
+                throw Exception( "Too many parameters in command line." );
+        };
+        ++count;
+    }
+
+
+    if (count == 1) {
+        // # Допустимо не указывать высоту.
+        options.m = options.n;
+    }
+
+    if ( !board.empty() ) {
+        options.board = PuzzleN::parseField( board );
+        if (options.board.size() != options.n * options.m) {
+            throw Exception( "Board does not match the size of puzzle." );
+        }
+    }
+
+
+    return options;
+}
+
+
+
+
+total_t
+solve(
+    const options_t& options,
+    const puzzlen::Solver& solver,
+    const puzzlen::PuzzleN::field_t& boards,
+    bool verbose
+) {
+    using namespace puzzlen;
+
+    const size_t cells = options.n * options.m;
+    total_t  total = {};
+    total.count = boards.size() / cells;
+    for (size_t k = 0; k < total.count; ++k) {
+        const PuzzleN::field_t  board(
+            boards.cbegin() + k * cells,
+            boards.cbegin() + (k + 1) * cells
+        );
+        const auto r = solver.solve( board );
+        if ( !verify( options, board, r.moves ) ) {
+            std::ostringstream  ss;
+            ss << "Board " << k << ": solution is wrong.";
+            throw Exception( ss.str() );
+        }
+        total.nodes   += r.nodes;
+        total.seconds += r.seconds;
+        total.length  += r.moves.size();
+        if ( verbose ) {
+            std::cout <<
+                "#" << k <<
+                "  length " << r.moves.size() <<
+                "  nodes " << r.nodes <<
+                "  time " << r.seconds << " s" <<
+                "  nodes/s " << ((r.seconds > 0.0) ? (r.nodes / r.seconds) : 0.0) <<
+                "  " << r.moves << "\n";
+        }
+    }
+
+    return total;
+}
+
+
+
+
+bool
+verify(
+    const options_t& options,
+    const puzzlen::PuzzleN::field_t& board,
+    const std::string& moves
+) {
+    using namespace puzzlen;
+
+    PuzzleN  puzzle( options.n, options.m, CELL_SIZE );
+    puzzle.field( board );
+    for (auto itr = moves.cbegin(); itr != moves.cend(); ++itr) {
+        const char* d = std::strchr( PuzzleN::DIRECTION_NAME, *itr );
+        const auto direction = static_cast< PuzzleN::direction_t >(
+            d - PuzzleN::DIRECTION_NAME
+        );
+        if ( !puzzle.shift( direction ) ) {
+            return false;
+        }
+    }
+
+    return puzzle.solved();
+}
+
+
+void
+play(
+    const options_t& options,
+    const puzzlen::Solver& solver,
+    const puzzlen::PuzzleN::field_t& boards
+) {
+    using namespace puzzlen;
+
+    const size_t cells = options.n * options.m;
+    const size_t count = boards.size() / cells;
+
+    Hint  hint( solver, 0 );
+    Latency  latency[ Hint::SOURCE_COUNT ];
+    uint64_t nodes[ Hint::SOURCE_COUNT ] = {};
+    for (size_t s = 0; s < Hint::SOURCE_COUNT; ++s) {
+        latency[ s ].reset();
+    }
+
+    Random  random( options.seed, 1 );
+    size_t hints = 0;
+    size_t optimal = 0;
+    size_t deviations = 0;
+    size_t checked = 0;
+    double planning = 0.0;
+    for (size_t k = 0; k < count; ++k) {
+        const PuzzleN::field_t  board(
+            boards.cbegin() + k * cells,
+            boards.cbegin() + (k + 1) * cells
+        );
+        PuzzleN  puzzle( options.n, options.m, CELL_SIZE );
+        puzzle.field( board );
+
+        const auto start = std::chrono::steady_clock::now();
+        hint.solve( board );
+        planning += std::chrono::duration< double >(
+            std::chrono::steady_clock::now() - start
+        ).count();
+
+        // # Отступление удлиняет путь не больше чем на 2 хода.
+        const size_t cap = (hint.plan().size() + 2) * 4;
+        size_t previous = 0;
+        bool followed = false;
+        for (size_t moves = 0; ; ++moves) {
+            const auto begin = std::chrono::steady_clock::now();
+            const Hint::hint_t  h = hint.next( puzzle.field() );
+            latency[ h.source ].record( Latency::since( begin ) );
+            nodes[ h.source ] += h.nodes;
+            ++hints;
+
+            if ( followed && (h.source == Hint::PLAN) && (h.remaining + 1 != previous) ) {
+                throw Exception( "Plan did not shorten after a followed hint." );
+            }
+            if ( h.optimal && (h.source != Hint::SOLVED) ) {
+                ++optimal;
+                if ( (cells <= HINT_CHECK_CELLS) &&
+                     (solver.solve( puzzle.field() ).moves.size() != h.remaining)
+                ) {
+                    throw Exception( "Shortest hint does not match the solver." );
+                }
+                checked += (cells <= HINT_CHECK_CELLS) ? 1 : 0;
+            }
+            if (h.source == Hint::SOLVED) {
+                break;
+            }
+            if (moves > cap) {
+                throw Exception( "Hints do not lead to the goal." );
+            }
+
+            followed = (random.below( 100 ) >= options.hints);
+            if ( followed ) {
+                puzzle.shift( static_cast< PuzzleN::direction_t >( h.direction ) );
+            } else {
+                ++deviations;
+                for ( ; ; ) {
+                    const int d = static_cast< int >( random.below( 4 ) );
+                    if ( (d != h.direction) &&
+                         puzzle.shift( static_cast< PuzzleN::direction_t >( d ) )
+                    ) {
+                        break;
+                    }
+                }
+            }
+            previous = h.remaining;
+        }
+        if ( !puzzle.solved() ) {
+            throw Exception( "Hints stopped before the goal." );
+        }
+    }
+
+    std::cout <<
+        "board       " << options.n << " x " << options.m << "\n" <<
+        "boards      " << count << "\n" <<
+        "against     " << options.hints << " %\n" <<
+        "planning    " << planning << " s\n" <<
+        "hints       " << hints << "\n" <<
+        "deviations  " << deviations << "\n" <<
+        "shortest    " << optimal << "\n" <<
+        "checked     " << checked << "\n";
+    std::cout <<
+        std::left << std::setw( 10 ) << "source" << std::right <<
+        std::setw( 12 ) << "count" <<
+        std::setw( 12 ) << "nodes" <<
+        std::setw( 12 ) << "p50 us" <<
+        std::setw( 12 ) << "p99 us" <<
+        std::setw( 12 ) << "max us" << "\n";
+    std::cout << std::fixed << std::setprecision( 2 );
+    for (size_t s = 0; s < Hint::SOURCE_COUNT; ++s) {
+        const auto l = latency[ s ].summary();
+        if (l.count == 0) {
+            continue;
+        }
+        std::cout <<
+            std::left << std::setw( 10 ) << Hint::SOURCE_NAME[ s ] << std::right <<
+            std::setw( 12 ) << l.count <<
+            std::setw( 12 ) << (nodes[ s ] / l.count) <<
+            std::setw( 12 ) << (l.p50 / 1e3) <<
+            std::setw( 12 ) << (l.p99 / 1e3) <<
+            std::setw( 12 ) << (l.max / 1e3) << "\n";
+    }
+    std::cout << std::defaultfloat;
+    std::cout.flush();
+}
+
+
+} // namespace
@@ -0,0 +1,24 @@
+#include "../include/stdafx.h"
+#include "../include/Board.h"
+
+
+namespace puzzlen {
+
+
+template class Board< 3, 3 >;
+template class Board< 4, 4 >;
+template class Board< 5, 5 >;
+template class Board< 6, 6 >;
+template class Board< 7, 7 >;
+template class Board< 8, 8 >;
+template class Board< 9, 9 >;
+template class Board< 10, 10 >;
+template class Board< 3, 4 >;
+template class Board< 4, 3 >;
+template class Board< 3, 5 >;
+template class Board< 5, 3 >;
+template class Board< 2, 6 >;
+template class Board< 6, 2 >;
+
+
+} // puzzlen
@@ -0,0 +1,21 @@
+#include "../include/stdafx.h"
+#include "../include/CompactState.h"
+
+
+namespace puzzlen {
+
+
+Packing::Packing( size_t n, size_t m ) :
+    N( n ), M( m ),
+    cells( n * m ),
+    bits( bitsFor( n * m ) ),
+    words( wordsFor( n * m ) ),
+    mask( (1ULL << bitsFor( n * m )) - 1 )
+{
+    if (cells < 2) {
+        throw Exception( "Puzzle must have at least 2 cells." );
+    }
+}
+
+
+} // puzzlen
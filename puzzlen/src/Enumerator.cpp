@@ -0,0 +1,368 @@
+#include "../include/stdafx.h"
+#include "../include/Enumerator.h"
+#include "../include/Ranking.h"
+#include "../include/ThreadPool.h"
+#include <cstring>
+#include <fstream>
+
+
+namespace puzzlen {
+
+
+const uint32_t  Enumerator::FORMAT_VERSION;
+const size_t    Enumerator::TABLE_ALIGNMENT;
+const uint64_t  Enumerator::CHUNK;
+const uint64_t  Enumerator::UNSEEN;
+const uint64_t  Enumerator::FRONTIER;
+const uint64_t  Enumerator::NEXT;
+const uint64_t  Enumerator::CLOSED;
+
+
+
+
+namespace {
+
+
+static const char MAGIC[ 8 ] = { 'P', 'Z', 'L', 'N', 'D', 'S', 'T', '\0' };
+
+static const uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+// младшие биты 2-битных состояний в слове
+static const uint64_t LOW_BITS = 0x5555555555555555ULL;
+
+static const uint64_t STATES_PER_WORD = 32;
+
+
+// @return 'size', выровненный вверх до 'alignment'.
+inline uint64_t align( uint64_t size, uint64_t alignment ) {
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+
+// @return Заголовок отображённой таблицы расстояний.
+// @throw Exception Если файл не похож на таблицу.
+const Enumerator::header_t& header( const MappedFile& file ) {
+
+    if (file.size() < sizeof( Enumerator::header_t )) {
+        throw Exception( "Distance table is truncated." );
+    }
+    const auto& h = *reinterpret_cast< const Enumerator::header_t* >( file.data() );
+    if (std::memcmp( h.magic, MAGIC, sizeof( MAGIC ) ) != 0) {
+        throw Exception( "File is not a distance table." );
+    }
+    if (h.byteOrder != BYTE_ORDER_MARK) {
+        throw Exception( "Distance table has foreign byte order." );
+    }
+    if (h.version != Enumerator::FORMAT_VERSION) {
+        throw Exception( "Distance table has unsupported version." );
+    }
+    if (h.fileSize != file.size()) {
+        throw Exception( "Distance table is truncated." );
+    }
+
+    return h;
+}
+
+
+} // namespace
+
+
+
+
+Enumerator::Enumerator( size_t n, size_t m, size_t threads, bool table ) :
+    N( n ), M( m ),
+    mCells( n * m ),
+    mStates( 0 ),
+    mDistance( nullptr )
+{
+    const Geometry  geometry( N, M );
+    if (mCells > ENUMERATE_MAX_CELLS) {
+        throw Exception( "Puzzle is too large to enumerate." );
+    }
+    mStates = Ranking::arrangements( mCells - 2, mCells );
+
+    // # Лишние состояния последнего слова - пройденные: их не раскрывают
+    //   и не считают.
+    const size_t words = static_cast< size_t >(
+        (mStates + STATES_PER_WORD - 1) / STATES_PER_WORD
+    );
+    std::unique_ptr< std::atomic< uint64_t >[] >  bits( new std::atomic< uint64_t >[ words ] );
+    for (size_t k = 0; k < words; ++k) {
+        bits[ k ].store( UNSEEN, std::memory_order_relaxed );
+    }
+    for (uint64_t r = mStates; r < words * STATES_PER_WORD; ++r) {
+        bits[ r / STATES_PER_WORD ] |= CLOSED << (r % STATES_PER_WORD * 2);
+    }
+    if ( table ) {
+        mTable.assign( static_cast< size_t >( mStates ), 0xFF );
+    }
+
+    // собранное поле
+    std::vector< uint8_t >  tiles( mCells );
+    for (size_t i = 0; i < mCells; ++i) {
+        tiles[ i ] = static_cast< uint8_t >(
+            (i + 1 < mCells) ? (i + 1) : PuzzleN::EMPTY_ELEMENT
+        );
+    }
+    const uint64_t goal = rank( tiles.data() );
+    bits[ goal / STATES_PER_WORD ] |= FRONTIER << (goal % STATES_PER_WORD * 2);
+    if ( table ) {
+        mTable[ goal ] = 0;
+    }
+    mCounts.push_back( 1 );
+
+    // # Куски кратны слову: слово раскрывает и переводит одна задача.
+    ThreadPool  pool( threads );
+    auto* b = bits.get();
+    for (uint8_t depth = 1; ; ++depth) {
+        DASSERT( depth < 0xFF );
+        for (uint64_t from = 0; from < mStates; from += CHUNK) {
+            const uint64_t to = std::min( from + CHUNK, mStates );
+            pool.submit( [ this, &geometry, b, from, to, depth ] ( size_t ) {
+                expand( geometry, b, from, to, depth );
+            } );
+        }
+        pool.wait();
+
+        std::atomic< uint64_t >  found( 0 );
+        const size_t step = static_cast< size_t >( CHUNK / STATES_PER_WORD );
+        for (size_t from = 0; from < words; from += step) {
+            const size_t to = std::min( from + step, words );
+            pool.submit( [ b, from, to, &found ] ( size_t ) {
+                found.fetch_add( advance( b, from, to ), std::memory_order_relaxed );
+            } );
+        }
+        pool.wait();
+
+        if (found.load() == 0) {
+            break;
+        }
+        mCounts.push_back( found.load() );
+    }
+
+    if ( table ) {
+        mDistance = mTable.data();
+    }
+}
+
+
+
+
+Enumerator::Enumerator( const std::string& file ) :
+    Enumerator( std::unique_ptr< MappedFile >( new MappedFile( file ) ) )
+{
+}
+
+
+
+
+Enumerator::Enumerator( std::unique_ptr< MappedFile > f ) :
+    N( header( *f ).n ), M( header( *f ).m ),
+    mCells( N * M ),
+    mStates( 0 ),
+    mDistance( nullptr )
+{
+    const auto& h = header( *f );
+    if ( (N < 2) || (M < 2) || (mCells > ENUMERATE_MAX_CELLS) ) {
+        throw Exception( "Distance table has wrong size of puzzle." );
+    }
+    mStates = Ranking::arrangements( mCells - 2, mCells );
+    const uint64_t described = sizeof( header_t ) + h.depths * sizeof( uint64_t );
+    if ( (h.depths == 0) || (h.states != mStates)
+      || (h.offset < described) || (h.offset + h.states != h.fileSize) )
+    {
+        throw Exception( "Distance table is corrupted." );
+    }
+
+    const auto* counts = reinterpret_cast< const uint64_t* >( f->data() + sizeof( header_t ) );
+    mCounts.assign( counts, counts + h.depths );
+    mDistance = f->data() + h.offset;
+
+    mFile = std::move( f );
+}
+
+
+
+
+Enumerator::~Enumerator() {
+}
+
+
+
+
+void
+Enumerator::save( const std::string& file ) const {
+
+    if ( !hasTable() ) {
+        throw Exception( "Distances were not kept by the enumeration." );
+    }
+
+    header_t  h;
+    std::memset( &h, 0, sizeof( h ) );
+    std::memcpy( h.magic, MAGIC, sizeof( MAGIC ) );
+    h.byteOrder = BYTE_ORDER_MARK;
+    h.version   = FORMAT_VERSION;
+    h.n = static_cast< uint32_t >( N );
+    h.m = static_cast< uint32_t >( M );
+    h.depths = static_cast< uint32_t >( mCounts.size() );
+    h.states = mStates;
+    h.offset = align(
+        sizeof( header_t ) + mCounts.size() * sizeof( uint64_t ),  TABLE_ALIGNMENT
+    );
+    h.fileSize = h.offset + h.states;
+
+    std::ofstream  fs( file.c_str(), std::ios::binary | std::ios::trunc );
+    if ( !fs.is_open() ) {
+        throw Exception( "File " + file + " can not be created." );
+    }
+    fs.write( reinterpret_cast< const char* >( &h ), sizeof( h ) );
+    fs.write(
+        reinterpret_cast< const char* >( mCounts.data() ),
+        mCounts.size() * sizeof( uint64_t )
+    );
+    const uint64_t gap = h.offset - static_cast< uint64_t >( fs.tellp() );
+    const std::vector< char >  zero( static_cast< size_t >( gap ), 0 );
+    fs.write( zero.data(), zero.size() );
+    fs.write(
+        reinterpret_cast< const char* >( mDistance ),
+        static_cast< std::streamsize >( mStates )
+    );
+    if ( !fs.good() ) {
+        throw Exception( "File " + file + " can not be written." );
+    }
+}
+
+
+
+
+uint64_t
+Enumerator::rank( const uint8_t* tiles ) const {
+
+    int position[ ENUMERATE_MAX_CELLS ];
+    for (size_t i = 0; i < mCells; ++i) {
+        position[ tiles[ i ] ] = static_cast< int >( i );
+    }
+    return Ranking::rank( position, mCells - 2, mCells );
+}
+
+
+
+
+void
+Enumerator::unrank( uint64_t rank,  uint8_t* tiles ) const {
+
+    int position[ ENUMERATE_MAX_CELLS ];
+    positions( rank, position );
+    for (size_t e = 0; e < mCells; ++e) {
+        tiles[ position[ e ] ] = static_cast< uint8_t >( e );
+    }
+}
+
+
+
+
+void
+Enumerator::expand(
+    const Geometry& geometry,
+    std::atomic< uint64_t >* bits,
+    uint64_t from,  uint64_t to,
+    uint8_t depth
+) {
+    const size_t count = mCells - 2;
+    int position[ ENUMERATE_MAX_CELLS ];
+    int at[ ENUMERATE_MAX_CELLS ];
+    for (uint64_t w = from / STATES_PER_WORD; w * STATES_PER_WORD < to; ++w) {
+        // # Фронт - состояния 01: младший бит есть, старшего нет.
+        const uint64_t word = bits[ w ].load( std::memory_order_relaxed );
+        uint64_t frontier = word & ~(word >> 1) & LOW_BITS;
+        for (uint64_t s = 0; frontier != 0; ++s, frontier >>= 2) {
+            if ((frontier & FRONTIER) == 0) {
+                continue;
+            }
+            positions( w * STATES_PER_WORD + s,  position );
+            for (size_t e = 0; e < mCells; ++e) {
+                at[ position[ e ] ] = static_cast< int >( e );
+            }
+
+            const int blank = position[ PuzzleN::EMPTY_ELEMENT ];
+            for (int d = 0; d < 4; ++d) {
+                const int source = geometry.source( blank, d );
+                if (source < 0) {
+                    continue;
+                }
+                // # Места двух последних элементов в номер не входят.
+                const size_t e = static_cast< size_t >( at[ source ] );
+                position[ PuzzleN::EMPTY_ELEMENT ] = source;
+                if (e < count) {
+                    position[ e ] = blank;
+                }
+                const uint64_t child = Ranking::rank( position, count, mCells );
+                position[ PuzzleN::EMPTY_ELEMENT ] = blank;
+                if (e < count) {
+                    position[ e ] = source;
+                }
+
+                auto& cell = bits[ child / STATES_PER_WORD ];
+                const uint64_t shift = child % STATES_PER_WORD * 2;
+                if (((cell.load( std::memory_order_relaxed ) >> shift) & 3) != UNSEEN) {
+                    continue;
+                }
+                const uint64_t old = cell.fetch_or( NEXT << shift, std::memory_order_relaxed );
+                if ( (((old >> shift) & 3) == UNSEEN) && !mTable.empty() ) {
+                    mTable[ child ] = depth;
+                }
+            }
+        }
+    }
+}
+
+
+
+
+uint64_t
+Enumerator::advance(
+    std::atomic< uint64_t >* bits,  size_t from,  size_t to
+) {
+    // # 01 -> 11, 10 -> 01: старший бит - бывший младший, младший -
+    //   любой из двух.
+    uint64_t count = 0;
+    for (size_t w = from; w < to; ++w) {
+        const uint64_t word = bits[ w ].load( std::memory_order_relaxed );
+        const uint64_t low  = word & LOW_BITS;
+        const uint64_t high = (word >> 1) & LOW_BITS;
+        count += Ranking::bitCount( high & ~low );
+        bits[ w ].store( (low << 1) | low | high,  std::memory_order_relaxed );
+    }
+    return count;
+}
+
+
+
+
+void
+Enumerator::positions( uint64_t rank,  int* position ) const {
+
+    // # Сумма цифр ранга - чётность перестановки без двух последних
+    //   элементов. Решаемость (PuzzleN::solvable()) требует, чтобы
+    //   чётность перестановки мест совпадала с чётностью C - 1 плюс
+    //   расстояния пустой ячейки до её места.
+    const size_t count = mCells - 2;
+    size_t parity = Ranking::unrank( rank, position, count, mCells );
+    const int blank = position[ PuzzleN::EMPTY_ELEMENT ];
+    const int last = static_cast< int >( mCells - 1 );
+    const int n = static_cast< int >( N );
+    parity += std::abs( blank / n - last / n ) + std::abs( blank % n - last % n ) + last;
+
+    uint64_t free = (uint64_t( 1 ) << mCells) - 1;
+    for (size_t e = 0; e < count; ++e) {
+        free &= ~(uint64_t( 1 ) << position[ e ]);
+    }
+    const int first  = static_cast< int >( Ranking::lowestBit( free ) );
+    const int second = static_cast< int >( Ranking::lowestBit( free & (free - 1) ) );
+    const bool swap = ((parity & 1) != 0);
+    position[ count ]     = swap ? second : first;
+    position[ count + 1 ] = swap ? first : second;
+}
+
+
+} // puzzlen
@@ -0,0 +1,51 @@
+#include "../include/stdafx.h"
+#include "../include/FramePool.h"
+
+
+namespace puzzlen {
+
+
+FramePool::FramePool( size_t capacity ) :
+    capacity( std::max( capacity,  static_cast< size_t >( 1 ) ) ),
+    mCreated( 0 )
+{
+    mBuffers.reserve( this->capacity );
+}
+
+
+
+
+FramePool::~FramePool() {
+}
+
+
+
+
+Framebuffer&
+FramePool::acquire( size_t width,  size_t height,  bool& stale ) {
+
+    for (auto itr = mBuffers.begin(); itr != mBuffers.end(); ++itr) {
+        const Framebuffer& b = **itr;
+        if ( (b.width() == width) && (b.height() == height) ) {
+            stale = (itr != mBuffers.begin());
+            // # Недавно нужные - в начале: уходит последний.
+            std::rotate( mBuffers.begin(),  itr,  itr + 1 );
+            return *mBuffers.front();
+        }
+    }
+
+    if (mBuffers.size() >= capacity) {
+        mBuffers.pop_back();
+    }
+    mBuffers.insert(
+        mBuffers.begin(),
+        std::unique_ptr< Framebuffer >( new Framebuffer( width, height ) )
+    );
+    ++mCreated;
+    stale = true;
+
+    return *mBuffers.front();
+}
+
+
+} // puzzlen
@@ -0,0 +1,69 @@
+#include "../include/stdafx.h"
+#include "../include/FrameScheduler.h"
+
+
+namespace puzzlen {
+
+
+const FrameScheduler::time_t  FrameScheduler::NONE;
+
+
+
+
+FrameScheduler::FrameScheduler( const PuzzleN& puzzle,  time_t interval ) :
+    interval( interval ),
+    mPuzzle( puzzle ),
+    mPending( false ),
+    mDue( 0 ),
+    mLastFrame( 0 ),
+    mPresented( false ),
+    mCounters()
+{
+}
+
+
+
+
+FrameScheduler::~FrameScheduler() {
+}
+
+
+
+
+FrameScheduler::time_t
+FrameScheduler::event( time_t now ) {
+
+    ++mCounters.events;
+
+    if ( mPuzzle.damage().empty() ) {
+        ++mCounters.idleEvents;
+        return NONE;
+    }
+
+    if ( mPending ) {
+        ++mCounters.coalesced;
+        return NONE;
+    }
+
+    mPending = true;
+    const time_t earliest = mPresented ? (mLastFrame + interval) : now;
+    mDue = std::max( now, earliest );
+
+    return mDue - now;
+}
+
+
+
+
+void
+FrameScheduler::presented( time_t begin,  time_t end ) {
+
+    mPending = false;
+    mPresented = true;
+    mLastFrame = begin;
+    ++mCounters.frames;
+    mCounters.activeTime += (end > begin) ? (end - begin) : 0;
+}
+
+
+} // puzzlen
@@ -0,0 +1,79 @@
+#include "../include/stdafx.h"
+#include "../include/Framebuffer.h"
+
+
+namespace puzzlen {
+
+
+Framebuffer::Framebuffer( size_t width,  size_t height,  pixel_t color ) :
+    mWidth( width ),
+    mHeight( height ),
+    mPixels( width * height, color )
+{
+}
+
+
+
+
+Framebuffer::~Framebuffer() {
+}
+
+
+
+
+size_t
+Framebuffer::fill( const rect_t& r,  pixel_t color ) {
+
+    const rect_t  c = intersect( r, bounds() );
+    if ( empty( c ) ) {
+        return 0;
+    }
+    for (int y = c.top; y < c.bottom; ++y) {
+        std::fill( row( y ) + c.left,  row( y ) + c.right,  color );
+    }
+
+    return area( c );
+}
+
+
+
+
+size_t
+Framebuffer::copy(
+    const Framebuffer& source,  int sx,  int sy,
+    const rect_t& dest,  const rect_t& clip
+) {
+    const rect_t  c = intersect( intersect( dest, clip ),  bounds() );
+    if ( empty( c ) ) {
+        return 0;
+    }
+    // смещение источника относительно приёмника
+    const int ox = sx - dest.left;
+    const int oy = sy - dest.top;
+    DASSERT( (c.left + ox >= 0) && (c.right + ox <= static_cast< int >( source.width() )) );
+    DASSERT( (c.top + oy >= 0) && (c.bottom + oy <= static_cast< int >( source.height() )) );
+    for (int y = c.top; y < c.bottom; ++y) {
+        const pixel_t* from = source.row( y + oy ) + c.left + ox;
+        std::copy( from,  from + (c.right - c.left),  row( y ) + c.left );
+    }
+
+    return area( c );
+}
+
+
+
+
+Framebuffer::rect_t
+Framebuffer::intersect( const rect_t& a,  const rect_t& b ) {
+
+    const rect_t  r = {
+        std::max( a.left,   b.left ),
+        std::max( a.top,    b.top ),
+        std::min( a.right,  b.right ),
+        std::min( a.bottom, b.bottom )
+    };
+    return r;
+}
+
+
+} // puzzlen
@@ -0,0 +1,193 @@
+#include "../include/stdafx.h"
+#include "../include/Generator.h"
+#include "../include/Heuristic.h"
+
+
+namespace puzzlen {
+
+
+Generator::Generator( const Solver& solver ) :
+    mSolver( solver ),
+    mExact( false )
+{
+}
+
+
+
+
+Generator::~Generator() {
+}
+
+
+
+
+void
+Generator::table( const std::shared_ptr< const Enumerator >& table ) {
+
+    if ( table && !table->hasTable() ) {
+        throw Exception( "Enumeration has no distance table." );
+    }
+    if ( table && ((table->N != mSolver.N) || (table->M != mSolver.M)) ) {
+        throw Exception( "Distance table is built for another size of puzzle." );
+    }
+    mTable = table;
+}
+
+
+
+
+Generator::board_t
+Generator::generate( int lower,  int upper,  Random& random ) const {
+
+    if ( (lower < 0) || (upper < lower) ) {
+        throw Exception( "Range of distances is empty." );
+    }
+
+    if ( mTable ) {
+        return sample( lower, upper, random );
+    }
+
+    const Geometry& g = mSolver.geometry();
+    if ( mSolver.patterns() ) {
+        return walk( PatternHeuristic( g, *mSolver.patterns() ), lower, upper, random );
+    }
+    if ( mSolver.walking() ) {
+        return walk( WalkingHeuristic( *mSolver.walking() ), lower, upper, random );
+    }
+    return walk( ConflictHeuristic( g ), lower, upper, random );
+}
+
+
+
+
+Generator::board_t
+Generator::sample( int lower,  int upper,  Random& random ) const {
+
+    const Enumerator& table = *mTable;
+    const auto& counts = table.counts();
+    uint64_t matching = 0;
+    for (int d = lower; (d <= upper) && (d < static_cast< int >( counts.size() )); ++d) {
+        matching += counts[ d ];
+    }
+    if (matching == 0) {
+        throw Exception( "No boards at this distance from the goal." );
+    }
+
+    // # Номеров в таблице меньше 2^32: ENUMERATE_MAX_CELLS = 12.
+    const uint32_t states = static_cast< uint32_t >( table.states() );
+    board_t  board;
+    board.attempts = 0;
+    uint64_t rank = 0;
+    if (table.states() / matching <= GENERATE_REJECT) {
+        do {
+            rank = random.below( states );
+            ++board.attempts;
+        } while ( (table.distance( rank ) < lower) || (table.distance( rank ) > upper) );
+    } else {
+        // # Подходящих мало: k-я по порядку номеров - тоже равновероятно.
+        uint32_t k = random.below( static_cast< uint32_t >( matching ) );
+        for ( ; ; ++rank) {
+            const int d = table.distance( rank );
+            if ( (d >= lower) && (d <= upper) ) {
+                if (k == 0) {
+                    break;
+                }
+                --k;
+            }
+        }
+        board.attempts = 1;
+    }
+
+    std::vector< uint8_t >  tiles( mSolver.geometry().cells );
+    table.unrank( rank, tiles.data() );
+    board.field.assign( tiles.cbegin(), tiles.cend() );
+    board.lower = board.upper = table.distance( rank );
+
+    return board;
+}
+
+
+
+
+template< class H >
+Generator::board_t
+Generator::walk( const H& heuristic,  int lower,  int upper,  Random& random ) const {
+
+    const Geometry& g = mSolver.geometry();
+    const int cells = static_cast< int >( g.cells );
+    std::vector< uint8_t >  tiles( cells );
+    H  h( heuristic );
+
+    board_t  board;
+    for (board.attempts = 1; board.attempts <= GENERATE_MAX_ATTEMPTS; ++board.attempts) {
+        for (int i = 0; i + 1 < cells; ++i) {
+            tiles[ i ] = static_cast< uint8_t >( i + 1 );
+        }
+        tiles[ cells - 1 ] = static_cast< uint8_t >( PuzzleN::EMPTY_ELEMENT );
+        int blank = cells - 1;
+        h.reset( tiles.data() );
+
+        int prev = -1;
+        for (int step = 1; step <= upper; ++step) {
+            // # Оценка после каждого хода: сдвиг и обратный сдвиг.
+            int candidates[ 4 ];
+            int values[ 4 ];
+            int count = 0;
+            int best = -1;
+            for (int d = 0; d < 4; ++d) {
+                const int from = g.source( blank, d );
+                if ( (from < 0) || (d == (prev ^ 1)) ) {
+                    continue;
+                }
+                const int tile = tiles[ from ];
+                std::swap( tiles[ from ], tiles[ blank ] );
+                h.shift( tiles.data(), tile, from, blank );
+                values[ count ] = h.value();
+                std::swap( tiles[ from ], tiles[ blank ] );
+                h.shift( tiles.data(), tile, blank, from );
+                candidates[ count ] = d;
+                best = std::max( best, values[ count ] );
+                ++count;
+            }
+
+            // # Только ходы с лучшей оценкой, если она не меньше текущей.
+            const int current = h.value();
+            int chosen[ 4 ];
+            int n = 0;
+            for (int c = 0; c < count; ++c) {
+                if ( (best < current) || (values[ c ] == best) ) {
+                    chosen[ n++ ] = candidates[ c ];
+                }
+            }
+            const int d = chosen[ random.below( static_cast< uint32_t >( n ) ) ];
+            const int from = g.source( blank, d );
+            const int tile = tiles[ from ];
+            std::swap( tiles[ from ], tiles[ blank ] );
+            h.shift( tiles.data(), tile, from, blank );
+            blank = from;
+            prev = d;
+
+            // # Расстояние той же чётности, что и число ходов.
+            const int v = h.value();
+            const int bound = v + ((step - v) & 1);
+            if (bound < lower) {
+                continue;
+            }
+
+            board.field.assign( tiles.cbegin(), tiles.cend() );
+            board.lower = bound;
+            board.upper = step;
+            if ( mExact && (board.lower < board.upper) ) {
+                board.lower = board.upper = static_cast< int >(
+                    mSolver.solve( board.field ).moves.size()
+                );
+            }
+            return board;
+        }
+    }
+
+    throw Exception( "No board at this distance is found by random walks." );
+}
+
+
+} // puzzlen
@@ -0,0 +1,59 @@
+#include "../include/stdafx.h"
+#include "../include/Geometry.h"
+
+
+namespace puzzlen {
+
+
+const size_t  Geometry::MAX_CELLS;
+
+
+
+
+Geometry::Geometry( size_t n, size_t m ) :
+    N( n ), M( m ),
+    cells( n * m )
+{
+    if ( (n < 2) || (m < 2) ) {
+        throw Exception( "Width and height of puzzle must have value above 1." );
+    }
+    if (cells > MAX_CELLS) {
+        throw Exception( "Puzzle is too large for the solver." );
+    }
+
+    mRow.resize( cells );
+    mColumn.resize( cells );
+    for (size_t i = 0; i < cells; ++i) {
+        mRow[ i ]    = static_cast< int >( i / n );
+        mColumn[ i ] = static_cast< int >( i % n );
+    }
+
+    // # Элемент, сдвигающийся на север, стоит южнее пустой ячейки и т.д.
+    static const int DX[] = { 0,  0,  1, -1 };
+    static const int DY[] = { 1, -1,  0,  0 };
+    mSource.resize( cells * 4 );
+    for (size_t i = 0; i < cells; ++i) {
+        for (int d = 0; d < 4; ++d) {
+            const int x = mColumn[ i ] + DX[ d ];
+            const int y = mRow[ i ]    + DY[ d ];
+            const bool inside = (x >= 0) && (x < static_cast< int >( n ))
+                             && (y >= 0) && (y < static_cast< int >( m ));
+            mSource[ i * 4 + d ] =
+                inside ? (x + y * static_cast< int >( n )) : -1;
+        }
+    }
+
+    // # Пустую ячейку в сумму не включаем: её строка нулевая.
+    mDistance.assign( cells * cells, 0 );
+    for (size_t e = 1; e < cells; ++e) {
+        const int g = goal( static_cast< int >( e ) );
+        for (size_t i = 0; i < cells; ++i) {
+            mDistance[ e * cells + i ] =
+                std::abs( mRow[ i ] - mRow[ g ] )
+              + std::abs( mColumn[ i ] - mColumn[ g ] );
+        }
+    }
+}
+
+
+} // puzzlen
@@ -0,0 +1,176 @@
+#include "../include/stdafx.h"
+#include "../include/Heuristic.h"
+
+
+namespace puzzlen {
+
+
+ConflictHeuristic::ConflictHeuristic( const Geometry& geometry ) :
+    mGeometry( geometry ),
+    mManhattan( 0 ),
+    mRowConflict( geometry.M, 0 ),
+    mColumnConflict( geometry.N, 0 ),
+    mConflict( 0 )
+{
+}
+
+
+
+
+void
+ConflictHeuristic::reset( const uint8_t* tiles ) {
+
+    const auto& g = mGeometry;
+
+    mManhattan = 0;
+    for (size_t i = 0; i < g.cells; ++i) {
+        mManhattan += g.distance( tiles[ i ], static_cast< int >( i ) );
+    }
+
+    mConflict = 0;
+    for (size_t y = 0; y < g.M; ++y) {
+        mRowConflict[ y ] = rowConflict( tiles, static_cast< int >( y ) );
+        mConflict += mRowConflict[ y ];
+    }
+    for (size_t x = 0; x < g.N; ++x) {
+        mColumnConflict[ x ] = columnConflict( tiles, static_cast< int >( x ) );
+        mConflict += mColumnConflict[ x ];
+    }
+}
+
+
+
+
+WalkingHeuristic::WalkingHeuristic( const Walking& walking ) :
+    mWalking( walking ),
+    mConflict( walking.geometry() ),
+    mRow( 0 ),
+    mColumn( 0 )
+{
+}
+
+
+
+
+void
+WalkingHeuristic::reset( const uint8_t* tiles ) {
+
+    mConflict.reset( tiles );
+    mRow = mWalking.rowId( tiles );
+    mColumn = mWalking.columnId( tiles );
+}
+
+
+
+
+int
+ConflictHeuristic::rowConflict( const uint8_t* tiles, int y ) const {
+
+    const auto& g = mGeometry;
+    int sequence[ Geometry::MAX_CELLS ];
+    int length = 0;
+    const int n = static_cast< int >( g.N );
+    for (int i = y * n; i < (y + 1) * n; ++i) {
+        const int tile = tiles[ i ];
+        if (tile == PuzzleN::EMPTY_ELEMENT) {
+            continue;
+        }
+        const int goal = g.goal( tile );
+        if (g.row( goal ) == y) {
+            sequence[ length++ ] = g.column( goal );
+        }
+    }
+
+    return 2 * (length - increasing( sequence, length ));
+}
+
+
+
+
+int
+ConflictHeuristic::columnConflict( const uint8_t* tiles, int x ) const {
+
+    const auto& g = mGeometry;
+    int sequence[ Geometry::MAX_CELLS ];
+    int length = 0;
+    const int n = static_cast< int >( g.N );
+    for (int i = x; i < static_cast< int >( g.cells ); i += n) {
+        const int tile = tiles[ i ];
+        if (tile == PuzzleN::EMPTY_ELEMENT) {
+            continue;
+        }
+        const int goal = g.goal( tile );
+        if (g.column( goal ) == x) {
+            sequence[ length++ ] = g.row( goal );
+        }
+    }
+
+    return 2 * (length - increasing( sequence, length ));
+}
+
+
+
+
+int
+ConflictHeuristic::increasing( const int* sequence, int length ) {
+
+    // хвосты возрастающих подпоследовательностей каждой длины
+    int tail[ Geometry::MAX_CELLS ];
+    int size = 0;
+    for (int k = 0; k < length; ++k) {
+        const int v = sequence[ k ];
+        int lo = 0;
+        int hi = size;
+        while (lo < hi) {
+            const int mid = (lo + hi) / 2;
+            if (tail[ mid ] < v) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        tail[ lo ] = v;
+        if (lo == size) {
+            ++size;
+        }
+    }
+
+    return size;
+}
+
+
+
+
+PatternHeuristic::PatternHeuristic(
+    const Geometry& geometry,  const Patterns& patterns
+) :
+    mGeometry( geometry ),
+    mPatterns( patterns ),
+    mPosition( geometry.cells, 0 ),
+    mCost( patterns.partition().size(), 0 ),
+    mValue( 0 )
+{
+    if ( (patterns.N != geometry.N) || (patterns.M != geometry.M) ) {
+        throw Exception( "Pattern database is built for another size of puzzle." );
+    }
+}
+
+
+
+
+void
+PatternHeuristic::reset( const uint8_t* tiles ) {
+
+    for (size_t i = 0; i < mGeometry.cells; ++i) {
+        mPosition[ tiles[ i ] ] = static_cast< int >( i );
+    }
+
+    mValue = 0;
+    for (size_t k = 0; k < mCost.size(); ++k) {
+        mCost[ k ] = cost( k );
+        mValue += mCost[ k ];
+    }
+}
+
+
+} // puzzlen
@@ -0,0 +1,204 @@
+#include "../include/stdafx.h"
+#include "../include/Hint.h"
+#include <cstring>
+#include <limits>
+
+
+namespace puzzlen {
+
+
+const char* const  Hint::SOURCE_NAME[] = {
+    "solved",
+    "plan",
+    "deviation",
+    "search",
+    "greedy"
+};
+
+
+
+
+Hint::Hint( const Solver& solver,  uint64_t limit ) :
+    mSolver( solver ),
+    mLimit( (limit == 0) ? HINT_NODES : limit ),
+    mBlank( 0 ),
+    mStep( 0 ),
+    mOptimal( false ),
+    mGreedyBack( -1 )
+{
+}
+
+
+
+
+Hint::~Hint() {
+}
+
+
+
+
+void
+Hint::solve( const PuzzleN::field_t& field ) {
+
+    adopt( field,  mSolver.solve( field ).moves,  true );
+}
+
+
+
+
+Hint::hint_t
+Hint::next( const PuzzleN::field_t& field ) {
+
+    const size_t cells = mSolver.geometry().cells;
+    if (field.size() != cells) {
+        throw Exception( "Size of field does not match the puzzle." );
+    }
+
+    if ( !mCursor.empty() ) {
+        // # Спросили снова, не сходив.
+        if (field == mCursor) {
+            return follow( PLAN, 0 );
+        }
+
+        // # Сходили по подсказке.
+        if (mStep < mPlan.size()) {
+            const int d = static_cast< int >(
+                std::strchr( PuzzleN::DIRECTION_NAME, mPlan[ mStep ] ) - PuzzleN::DIRECTION_NAME
+            );
+            shift( d );
+            if (field == mCursor) {
+                ++mStep;
+                return follow( PLAN, 0 );
+            }
+            shift( d ^ 1 );
+        }
+
+        // # Сходили иначе: путь с возвратом хода - D + 1, ищем D - 1.
+        for (int d = 0; d < 4; ++d) {
+            if ( !shift( d ) ) {
+                continue;
+            }
+            const bool deviated = (field == mCursor);
+            shift( d ^ 1 );
+            if ( !deviated ) {
+                continue;
+            }
+
+            const std::string  back =
+                PuzzleN::DIRECTION_NAME[ d ^ 1 ] + mPlan.substr( mStep );
+            const int remaining = static_cast< int >( mPlan.size() - mStep );
+            Solver::result_t  r = {};
+            if ( (remaining > 0) && mSolver.solve( field, remaining - 1, mLimit, r ) ) {
+                adopt( field, r.moves, true );
+            } else {
+                adopt( field, back, (r.nodes <= mLimit) );
+            }
+            return follow( DEVIATION, r.nodes );
+        }
+    }
+
+    Solver::result_t  r;
+    if ( mSolver.solve( field, std::numeric_limits< int >::max(), mLimit, r ) ) {
+        adopt( field, r.moves, true );
+        return follow( SEARCH, r.nodes );
+    }
+
+    // # Узлов не хватило: ход к соседу с наименьшей оценкой. Если игрок
+    //   пошёл по прошлой такой подсказке, её не отменяем - иначе две
+    //   подсказки могут сменять друг друга без конца.
+    mCursor.clear();
+    mPlan.clear();
+    mStep = 0;
+    const int back = (field == mGreedy) ? mGreedyBack : -1;
+    const Geometry& g = mSolver.geometry();
+    const int blank = static_cast< int >(
+        std::find( field.cbegin(), field.cend(), PuzzleN::EMPTY_ELEMENT ) - field.cbegin()
+    );
+    mGreedy = field;
+    hint_t  h = { -1, 0, false, GREEDY, r.nodes };
+    int best = std::numeric_limits< int >::max();
+    for (int d = 0; d < 4; ++d) {
+        const int from = g.source( blank, d );
+        if ( (from < 0) || (d == back) ) {
+            continue;
+        }
+        std::swap( mGreedy[ from ], mGreedy[ blank ] );
+        const int e = mSolver.estimate( mGreedy );
+        std::swap( mGreedy[ from ], mGreedy[ blank ] );
+        if (e < best) {
+            best = e;
+            h.direction = d;
+            h.remaining = static_cast< size_t >( e ) + 1;
+        }
+    }
+    std::swap( mGreedy[ g.source( blank, h.direction ) ], mGreedy[ blank ] );
+    mGreedyBack = h.direction ^ 1;
+
+    return h;
+}
+
+
+
+
+void
+Hint::reset() {
+
+    mCursor.clear();
+    mPlan.clear();
+    mStep = 0;
+    mOptimal = false;
+    mGreedy.clear();
+}
+
+
+
+
+void
+Hint::adopt( const PuzzleN::field_t& field,  const std::string& moves,  bool optimal ) {
+
+    mCursor = field;
+    mBlank = static_cast< int >(
+        std::find( field.cbegin(), field.cend(), PuzzleN::EMPTY_ELEMENT ) - field.cbegin()
+    );
+    mPlan = moves;
+    mStep = 0;
+    mOptimal = optimal;
+}
+
+
+
+
+Hint::hint_t
+Hint::follow( source_t source,  uint64_t nodes ) const {
+
+    hint_t  h = { -1, 0, true, SOLVED, nodes };
+    if (mStep == mPlan.size()) {
+        return h;
+    }
+    h.direction = static_cast< int >(
+        std::strchr( PuzzleN::DIRECTION_NAME, mPlan[ mStep ] ) - PuzzleN::DIRECTION_NAME
+    );
+    h.remaining = mPlan.size() - mStep;
+    h.optimal = mOptimal;
+    h.source = source;
+
+    return h;
+}
+
+
+
+
+bool
+Hint::shift( int d ) {
+
+    const int from = mSolver.geometry().source( mBlank, d );
+    if (from < 0) {
+        return false;
+    }
+    std::swap( mCursor[ from ], mCursor[ mBlank ] );
+    mBlank = from;
+    return true;
+}
+
+
+} // puzzlen
@@ -0,0 +1,46 @@
+#include "../include/stdafx.h"
+#include "../include/History.h"
+
+
+namespace puzzlen {
+
+
+const size_t  History::MOVES_PER_WORD;
+
+
+
+
+History::History() :
+    mSize( 0 ),
+    mPosition( 0 )
+{
+}
+
+
+
+
+History::~History() {
+}
+
+
+
+
+void
+History::clear() {
+
+    mWords.clear();
+    mSize = 0;
+    mPosition = 0;
+}
+
+
+
+
+void
+History::reserve( size_t moves ) {
+
+    mWords.reserve( (moves + MOVES_PER_WORD - 1) / MOVES_PER_WORD );
+}
+
+
+} // puzzlen
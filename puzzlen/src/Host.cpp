@@ -0,0 +1,408 @@
+#include "../include/stdafx.h"
+#include "../include/Host.h"
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+
+namespace puzzlen {
+
+
+const char* const  Host::COMMAND_NAME[] = {
+    "open",
+    "move",
+    "field",
+    "close",
+    "stats"
+};
+
+
+const size_t  Host::MAX_LINE;
+
+
+
+
+namespace {
+
+
+// Как часто run() проверяет stop(), мс.
+static const int POLL_INTERVAL = 100;
+
+
+
+
+// @return Адрес UNIX-сокета 'path'.
+// @throw Exception Если путь не помещается в адрес.
+sockaddr_un
+address( const std::string& path ) {
+
+    sockaddr_un  a;
+    std::memset( &a, 0, sizeof( a ) );
+    a.sun_family = AF_UNIX;
+    if ( path.empty() || (path.size() >= sizeof( a.sun_path )) ) {
+        throw Exception( "Path of socket " + path + " is empty or too long." );
+    }
+    std::memcpy( a.sun_path, path.c_str(), path.size() );
+    return a;
+}
+
+
+
+
+// Читает из 'fd' строку (без перевода строки) через 'buffer'.
+// @return false, если соединение закрыто или строка длиннее Host::MAX_LINE.
+bool
+readLine( int fd,  std::string& buffer,  std::string& line ) {
+
+    for ( ; ; ) {
+        const size_t end = buffer.find( '\n' );
+        if (end != std::string::npos) {
+            const size_t length = ((end > 0) && (buffer[ end - 1 ] == '\r')) ? end - 1 : end;
+            line.assign( buffer, 0, length );
+            buffer.erase( 0, end + 1 );
+            return true;
+        }
+        if (buffer.size() > Host::MAX_LINE) {
+            return false;
+        }
+
+        char chunk[ 4096 ];
+        const ssize_t r = ::recv( fd, chunk, sizeof( chunk ), 0 );
+        if (r > 0) {
+            buffer.append( chunk, static_cast< size_t >( r ) );
+        } else if ( (r == 0) || (errno != EINTR) ) {
+            return false;
+        }
+    }
+}
+
+
+
+
+// Пишет в 'fd' всю строку 'data'.
+// @return false, если соединение закрыто.
+bool
+writeAll( int fd,  const std::string& data ) {
+
+    size_t sent = 0;
+    while (sent < data.size()) {
+        // # MSG_NOSIGNAL: закрытое клиентом соединение - ошибка, а не SIGPIPE.
+        const ssize_t r = ::send( fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL );
+        if (r > 0) {
+            sent += static_cast< size_t >( r );
+        } else if ( (r == 0) || (errno != EINTR) ) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+
+
+// @return Номер партии из 'in'.
+// @throw Exception Если номера нет.
+Sessions::id_t
+readId( std::istream& in ) {
+
+    Sessions::id_t  id;
+    in >> id;
+    if ( in.fail() ) {
+        throw Exception( "Session number is not recognized." );
+    }
+    return id;
+}
+
+
+} // namespace
+
+
+
+
+Host::Host( Sessions& sessions,  const std::string& socket ) :
+    mSessions( sessions ),
+    mSocket( socket ),
+    mListen( -1 ),
+    mStop( false )
+{
+    for (size_t c = 0; c < COMMAND_COUNT; ++c) {
+        mLatency[ c ].reset();
+    }
+
+    const sockaddr_un  a = address( socket );
+    mListen = ::socket( AF_UNIX, SOCK_STREAM, 0 );
+    if (mListen < 0) {
+        throw Exception( "Socket can not be created." );
+    }
+    ::unlink( socket.c_str() );
+    if ( (::bind( mListen, reinterpret_cast< const sockaddr* >( &a ), sizeof( a ) ) != 0)
+      || (::listen( mListen, SOMAXCONN ) != 0)
+    ) {
+        ::close( mListen );
+        throw Exception( "Socket " + socket + " can not be opened." );
+    }
+}
+
+
+
+
+Host::~Host() {
+
+    ::close( mListen );
+    ::unlink( mSocket.c_str() );
+}
+
+
+
+
+void
+Host::run() {
+
+    while ( !mStop.load() ) {
+        reap();
+        pollfd  p = { mListen, POLLIN, 0 };
+        if (::poll( &p, 1, POLL_INTERVAL ) <= 0) {
+            continue;
+        }
+        const int fd = ::accept( mListen, nullptr, nullptr );
+        if (fd < 0) {
+            continue;
+        }
+        std::lock_guard< std::mutex >  lock( mMutex );
+        mClients.push_back( fd );
+        mThreads.emplace_back( &Host::serve, this, fd );
+    }
+
+    // # Соединение закрывает сам поток: здесь только будим его recv().
+    {
+        std::lock_guard< std::mutex >  lock( mMutex );
+        for (const int fd : mClients) {
+            ::shutdown( fd, SHUT_RDWR );
+        }
+    }
+    for (auto& thread : mThreads) {
+        thread.join();
+    }
+    mThreads.clear();
+    mFinished.clear();
+    mStop.store( false );
+}
+
+
+
+
+void
+Host::serve( int fd ) {
+
+    std::string  buffer;
+    std::string  line;
+    while ( readLine( fd, buffer, line ) ) {
+        if ( !writeAll( fd, execute( line ) + "\n" ) ) {
+            break;
+        }
+    }
+
+    std::lock_guard< std::mutex >  lock( mMutex );
+    mClients.erase( std::find( mClients.begin(), mClients.end(), fd ) );
+    ::close( fd );
+    mFinished.push_back( std::this_thread::get_id() );
+}
+
+
+
+
+void
+Host::reap() {
+
+    // # Ждём вне блокировки: поток мог ещё не выйти из serve().
+    std::vector< std::thread >  finished;
+    {
+        std::lock_guard< std::mutex >  lock( mMutex );
+        for (const auto id : mFinished) {
+            const auto itr = std::find_if( mThreads.begin(), mThreads.end(),
+                [ id ] ( const std::thread& t ) { return t.get_id() == id; }
+            );
+            finished.push_back( std::move( *itr ) );
+            mThreads.erase( itr );
+        }
+        mFinished.clear();
+    }
+    for (auto& thread : finished) {
+        thread.join();
+    }
+}
+
+
+
+
+std::string
+Host::execute( const std::string& line ) {
+
+    const auto begin = std::chrono::steady_clock::now();
+    std::istringstream  in( line );
+    std::string  word;
+    in >> word;
+
+    size_t command = COMMAND_COUNT;
+    for (size_t c = 0; c < COMMAND_COUNT; ++c) {
+        if (word == COMMAND_NAME[ c ]) {
+            command = c;
+            break;
+        }
+    }
+
+    std::string  out = "ok";
+    try {
+        switch ( command ) {
+            case OPEN: {
+                size_t n;
+                size_t m;
+                uint64_t seed;
+                in >> n >> m >> seed;
+                if ( in.fail() ) {
+                    throw Exception( "Command open needs width, height and seed." );
+                }
+                out += " " + std::to_string( mSessions.open( n, m, seed ) );
+                break;
+            }
+
+            case MOVE: {
+                const Sessions::id_t id = readId( in );
+                char d = 0;
+                in >> d;
+                const char* name = std::strchr( PuzzleN::DIRECTION_NAME, d );
+                if ( (d == 0) || !name ) {
+                    throw Exception( "Direction must be one of N, S, W, E." );
+                }
+                const auto direction = static_cast< PuzzleN::direction_t >(
+                    name - PuzzleN::DIRECTION_NAME
+                );
+                bool moved = false;
+                bool solved = false;
+                if ( !mSessions.with( id, [ & ] ( PuzzleN& puzzle ) {
+                    moved = puzzle.shift( direction );
+                    solved = puzzle.solved();
+                } ) ) {
+                    throw Exception( "Session is not open." );
+                }
+                out += moved ? " 1" : " 0";
+                out += solved ? " 1" : " 0";
+                break;
+            }
+
+            case FIELD: {
+                const Sessions::id_t id = readId( in );
+                if ( !mSessions.with( id, [ & ] ( PuzzleN& puzzle ) {
+                    for (const auto element : puzzle.field()) {
+                        out += " " + std::to_string( element );
+                    }
+                } ) ) {
+                    throw Exception( "Session is not open." );
+                }
+                break;
+            }
+
+            case CLOSE:
+                if ( !mSessions.close( readId( in ) ) ) {
+                    throw Exception( "Session is not open." );
+                }
+                break;
+
+            case STATS:
+                out += " " + std::to_string( mSessions.size() );
+                for (size_t c = 0; c < COMMAND_COUNT; ++c) {
+                    const auto s = mLatency[ c ].summary();
+                    out += std::string( " " ) + COMMAND_NAME[ c ] + " " +
+                        std::to_string( s.count ) + " " +
+                        std::to_string( s.p50 ) + " " +
+                        std::to_string( s.p99 );
+                }
+                break;
+
+            default:
+                return "error Unknown command " + word + ".";
+        }
+
+    } catch ( const Exception& ex ) {
+        out = std::string( "error " ) + ex.what();
+    }
+
+    mLatency[ command ].record( Latency::since( begin ) );
+    return out;
+}
+
+
+
+
+void
+Host::report( std::ostream& out ) const {
+
+    out <<
+        std::left << std::setw( 10 ) << "command" << std::right <<
+        std::setw( 12 ) << "count" <<
+        std::setw( 12 ) << "mean us" <<
+        std::setw( 12 ) << "p50 us" <<
+        std::setw( 12 ) << "p99 us" <<
+        std::setw( 12 ) << "max us" << "\n";
+    out << std::fixed << std::setprecision( 2 );
+    for (size_t c = 0; c < COMMAND_COUNT; ++c) {
+        const auto s = mLatency[ c ].summary();
+        if (s.count == 0) {
+            continue;
+        }
+        out <<
+            std::left << std::setw( 10 ) << COMMAND_NAME[ c ] << std::right <<
+            std::setw( 12 ) << s.count <<
+            std::setw( 12 ) << (s.total / 1e3 / s.count) <<
+            std::setw( 12 ) << (s.p50 / 1e3) <<
+            std::setw( 12 ) << (s.p99 / 1e3) <<
+            std::setw( 12 ) << (s.max / 1e3) << "\n";
+    }
+    out << std::defaultfloat;
+    out.flush();
+}
+
+
+
+
+HostClient::HostClient( const std::string& socket ) :
+    mFd( -1 )
+{
+    const sockaddr_un  a = address( socket );
+    mFd = ::socket( AF_UNIX, SOCK_STREAM, 0 );
+    if (mFd < 0) {
+        throw Exception( "Socket can not be created." );
+    }
+    if (::connect( mFd, reinterpret_cast< const sockaddr* >( &a ), sizeof( a ) ) != 0) {
+        ::close( mFd );
+        throw Exception( "Host is not listening on socket " + socket + "." );
+    }
+}
+
+
+
+
+HostClient::~HostClient() {
+
+    ::close( mFd );
+}
+
+
+
+
+std::string
+HostClient::request( const std::string& line ) {
+
+    std::string  response;
+    if ( !writeAll( mFd, line + "\n" ) || !readLine( mFd, mBuffer, response ) ) {
+        throw Exception( "Connection to host is closed." );
+    }
+    return response;
+}
+
+
+} // puzzlen
@@ -0,0 +1,12 @@
+#include "../include/stdafx.h"
+#include "../include/HugeBoard.h"
+
+
+namespace puzzlen {
+
+
+template class HugeBoard< uint16_t >;
+template class HugeBoard< uint32_t >;
+
+
+} // puzzlen
@@ -0,0 +1,123 @@
+#include "../include/stdafx.h"
+#include "../include/Instrument.h"
+#include <fstream>
+#include <iomanip>
+
+
+namespace puzzlen {
+
+
+const char* const  Instrument::PROBE_NAME[] = {
+    "frame",
+    "render",
+    "present",
+    "atlas",
+    "input",
+    "solve"
+};
+
+
+Latency  Instrument::mCounter[ PROBE_COUNT ];
+
+
+
+
+namespace {
+
+
+// Куда печатать итоги при выходе, см. reportAtExit().
+std::string  reportFile;
+
+
+void
+reportOnExit() {
+
+    if ( reportFile.empty() ) {
+        Instrument::report( std::cerr );
+        return;
+    }
+    std::ofstream  out( reportFile.c_str() );
+    Instrument::report( out );
+}
+
+
+} // namespace
+
+
+
+
+void
+Instrument::record( probe_t probe,  uint64_t ns ) {
+
+    mCounter[ probe ].record( ns );
+}
+
+
+
+
+Instrument::summary_t
+Instrument::summary( probe_t probe ) {
+
+    return mCounter[ probe ].summary();
+}
+
+
+
+
+void
+Instrument::report( std::ostream& out ) {
+
+    out <<
+        std::left << std::setw( 10 ) << "probe" << std::right <<
+        std::setw( 12 ) << "count" <<
+        std::setw( 12 ) << "total ms" <<
+        std::setw( 12 ) << "mean us" <<
+        std::setw( 12 ) << "p50 us" <<
+        std::setw( 12 ) << "p99 us" <<
+        std::setw( 12 ) << "max us" << "\n";
+    out << std::fixed << std::setprecision( 2 );
+    for (size_t p = 0; p < PROBE_COUNT; ++p) {
+        const summary_t s = summary( static_cast< probe_t >( p ) );
+        if (s.count == 0) {
+            continue;
+        }
+        out <<
+            std::left << std::setw( 10 ) << PROBE_NAME[ p ] << std::right <<
+            std::setw( 12 ) << s.count <<
+            std::setw( 12 ) << (s.total / 1e6) <<
+            std::setw( 12 ) << (s.total / 1e3 / s.count) <<
+            std::setw( 12 ) << (s.p50 / 1e3) <<
+            std::setw( 12 ) << (s.p99 / 1e3) <<
+            std::setw( 12 ) << (s.max / 1e3) << "\n";
+    }
+    out << std::defaultfloat;
+    out.flush();
+}
+
+
+
+
+void
+Instrument::reportAtExit( const std::string& file ) {
+
+    static bool registered = false;
+    reportFile = file;
+    if ( !registered ) {
+        registered = true;
+        std::atexit( reportOnExit );
+    }
+}
+
+
+
+
+void
+Instrument::reset() {
+
+    for (size_t p = 0; p < PROBE_COUNT; ++p) {
+        mCounter[ p ].reset();
+    }
+}
+
+
+} // puzzlen
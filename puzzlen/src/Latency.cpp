@@ -0,0 +1,107 @@
+#include "../include/stdafx.h"
+#include "../include/Latency.h"
+
+
+namespace puzzlen {
+
+
+const size_t  Latency::BUCKETS;
+
+
+
+
+namespace {
+
+
+// @return Корзина гистограммы для задержки 'ns'.
+inline size_t
+bucketOf( uint64_t ns ) {
+
+    size_t b = 0;
+    while ( (ns > 1) && (b + 1 < Latency::BUCKETS) ) {
+        ns >>= 1;
+        ++b;
+    }
+    return b;
+}
+
+
+
+
+// @return Задержка, не больше которой доля 'q' замеров, нс.
+uint64_t
+percentile( const uint64_t* bucket,  uint64_t count,  double q ) {
+
+    const uint64_t rank = std::max(
+        static_cast< uint64_t >( std::ceil( q * count ) ),  uint64_t( 1 )
+    );
+    // # Внутри корзины считаем замеры распределёнными равномерно.
+    uint64_t seen = 0;
+    for (size_t b = 0; b < Latency::BUCKETS; ++b) {
+        if (seen + bucket[ b ] >= rank) {
+            const uint64_t low = (b == 0) ? 0 : (uint64_t( 1 ) << b);
+            const uint64_t high = uint64_t( 1 ) << (b + 1);
+            return low + (high - low) * (rank - seen) / bucket[ b ];
+        }
+        seen += bucket[ b ];
+    }
+    return uint64_t( 1 ) << Latency::BUCKETS;
+}
+
+
+} // namespace
+
+
+
+
+void
+Latency::record( uint64_t ns ) {
+
+    mTotal.fetch_add( ns, std::memory_order_relaxed );
+    mBucket[ bucketOf( ns ) ].fetch_add( 1, std::memory_order_relaxed );
+
+    uint64_t max = mMax.load( std::memory_order_relaxed );
+    while ( (ns > max) &&
+        !mMax.compare_exchange_weak( max, ns, std::memory_order_relaxed )
+    ) {}
+}
+
+
+
+
+Latency::summary_t
+Latency::summary() const {
+
+    uint64_t bucket[ BUCKETS ];
+    uint64_t count = 0;
+    for (size_t b = 0; b < BUCKETS; ++b) {
+        bucket[ b ] = mBucket[ b ].load( std::memory_order_relaxed );
+        count += bucket[ b ];
+    }
+
+    summary_t  s;
+    s.count = count;
+    s.total = mTotal.load( std::memory_order_relaxed );
+    s.max   = mMax.load( std::memory_order_relaxed );
+    // # Верхняя граница корзины может быть больше наибольшего замера.
+    s.p50 = (count > 0) ? std::min( percentile( bucket, count, 0.50 ), s.max ) : 0;
+    s.p99 = (count > 0) ? std::min( percentile( bucket, count, 0.99 ), s.max ) : 0;
+
+    return s;
+}
+
+
+
+
+void
+Latency::reset() {
+
+    mTotal.store( 0, std::memory_order_relaxed );
+    mMax.store( 0, std::memory_order_relaxed );
+    for (size_t b = 0; b < BUCKETS; ++b) {
+        mBucket[ b ].store( 0, std::memory_order_relaxed );
+    }
+}
+
+
+} // puzzlen
@@ -0,0 +1,102 @@
+#include "../include/stdafx.h"
+#include "../include/MappedFile.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+namespace puzzlen {
+
+
+#ifdef _WIN32
+
+MappedFile::MappedFile( const std::string& file ) :
+    mData( nullptr ),
+    mSize( 0 ),
+    mFile( INVALID_HANDLE_VALUE ),
+    mMapping( nullptr )
+{
+    mFile = CreateFileA(
+        file.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr
+    );
+    if (mFile == INVALID_HANDLE_VALUE) {
+        throw Exception( "File " + file + " is not found." );
+    }
+
+    LARGE_INTEGER  size;
+    if ( !GetFileSizeEx( mFile, &size ) || (size.QuadPart == 0) ) {
+        CloseHandle( mFile );
+        throw Exception( "File " + file + " is empty." );
+    }
+    mSize = static_cast< size_t >( size.QuadPart );
+
+    mMapping = CreateFileMappingA( mFile, nullptr, PAGE_READONLY, 0, 0, nullptr );
+    const void* view = mMapping ?
+        MapViewOfFile( mMapping, FILE_MAP_READ, 0, 0, 0 ) : nullptr;
+    if ( !view ) {
+        if ( mMapping ) {
+            CloseHandle( mMapping );
+        }
+        CloseHandle( mFile );
+        throw Exception( "File " + file + " can not be mapped." );
+    }
+    mData = static_cast< const uint8_t* >( view );
+}
+
+
+
+
+MappedFile::~MappedFile() {
+    UnmapViewOfFile( mData );
+    CloseHandle( mMapping );
+    CloseHandle( mFile );
+}
+
+
+#else
+
+
+MappedFile::MappedFile( const std::string& file ) :
+    mData( nullptr ),
+    mSize( 0 ),
+    mFile( -1 )
+{
+    mFile = open( file.c_str(), O_RDONLY );
+    if (mFile < 0) {
+        throw Exception( "File " + file + " is not found." );
+    }
+
+    struct stat  st;
+    if ((fstat( mFile, &st ) != 0) || (st.st_size == 0)) {
+        close( mFile );
+        throw Exception( "File " + file + " is empty." );
+    }
+    mSize = static_cast< size_t >( st.st_size );
+
+    void* view = mmap( nullptr, mSize, PROT_READ, MAP_SHARED, mFile, 0 );
+    if (view == MAP_FAILED) {
+        close( mFile );
+        throw Exception( "File " + file + " can not be mapped." );
+    }
+    // # Доступ к таблицам случайный: упреждающее чтение только мешает.
+    madvise( view, mSize, MADV_RANDOM );
+    mData = static_cast< const uint8_t* >( view );
+}
+
+
+
+
+MappedFile::~MappedFile() {
+    munmap( const_cast< uint8_t* >( mData ), mSize );
+    close( mFile );
+}
+
+#endif
+
+
+} // puzzlen
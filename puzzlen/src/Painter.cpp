@@ -0,0 +1,161 @@
+#include "../include/stdafx.h"
+#include "../include/Painter.h"
+#include "../include/Instrument.h"
+
+
+namespace puzzlen {
+
+
+Painter::Painter( const PuzzleN& puzzle ) :
+    mPuzzle( puzzle ),
+    mRenderer( puzzle, prepareAtlas() )
+{
+}
+
+
+
+
+Painter::~Painter() {
+}
+
+
+
+
+void
+Painter::draw( HDC hdc,  const RECT& /* rc */ ) {
+
+    // # Задний буфер - размером с окно - живёт между кадрами: перерисовываем
+    //   в нём только изменившиеся области. Новый буфер (окно сменило
+    //   размер) рисуем целиком.
+    RECT  client;
+    GetClientRect( WindowFromDC( hdc ), &client );
+    const size_t width  = static_cast< size_t >( std::max( client.right - client.left,  1L ) );
+    const size_t height = static_cast< size_t >( std::max( client.bottom - client.top,  1L ) );
+    bool stale = false;
+    Framebuffer& back = mPool.acquire( width, height, stale );
+    if ( stale ) {
+        mRenderer.drawAll( back );
+    } else {
+        mRenderer.draw( back, mPuzzle.damage() );
+    }
+
+    // # 0xAARRGGBB в памяти - B, G, R, A: это и есть 32-битный DIB.
+    //   Отрицательная высота - строки сверху вниз, как в Framebuffer.
+    BITMAPINFO  info = {};
+    info.bmiHeader.biSize = sizeof( BITMAPINFOHEADER );
+    info.bmiHeader.biWidth = static_cast< LONG >( width );
+    info.bmiHeader.biHeight = -static_cast< LONG >( height );
+    info.bmiHeader.biPlanes = 1;
+    info.bmiHeader.biBitCount = 32;
+    info.bmiHeader.biCompression = BI_RGB;
+
+    // # Буфер копируем целиком: GDI обрежет его по запрошенной области
+    //   (BeginPaint() уже выставил её отсечением).
+    PUZZLEN_PROBE( PRESENT )
+    SetDIBitsToDevice(
+        hdc,
+        0, 0, static_cast< DWORD >( width ), static_cast< DWORD >( height ),
+        0, 0, 0, static_cast< UINT >( height ),
+        back.row( 0 ), &info, DIB_RGB_COLORS
+    );
+}
+
+
+
+
+Framebuffer
+Painter::prepareAtlas() const {
+
+    using namespace Gdiplus;
+
+    PUZZLEN_PROBE( ATLAS )
+
+    const int cellSize = static_cast< int >( mPuzzle.cellSize );
+    Bitmap  atlas(
+        cellSize * static_cast< int >( mPuzzle.N ),
+        cellSize * static_cast< int >( mPuzzle.M ),
+        PixelFormat32bppARGB
+    );
+
+    Graphics  g( &atlas );
+    g.Clear( Color( Renderer::BACKGROUND ) );
+#if 0
+    g.SetCompositingMode( CompositingModeSourceOver );
+    g.SetCompositingQuality( CompositingQualityHighSpeed );
+    g.SetPixelOffsetMode( PixelOffsetModeHighSpeed );
+    g.SetSmoothingMode( SmoothingModeHighSpeed );
+    g.SetInterpolationMode( InterpolationModeHighQuality );
+#else
+    // быстрее
+    g.SetCompositingMode( CompositingModeSourceOver );
+    g.SetCompositingQuality( CompositingQualityHighSpeed );
+    g.SetPixelOffsetMode( PixelOffsetModeHalf );
+    g.SetSmoothingMode( SmoothingModeHighSpeed );
+    g.SetInterpolationMode( InterpolationModeNearestNeighbor );
+#endif
+    g.SetTextRenderingHint( TextRenderingHintAntiAliasGridFit );
+    g.SetPageUnit( UnitPixel );
+
+    // фоновое изображение загружаем один раз на все элементы
+    const std::wstring file = PATH_MEDIA + L"/cell.png";
+    Image  image( file.c_str() );
+    //ASSERT( (bg.GetType() != ImageTypeUnknown)
+    //    && "Image for cell not found." );
+
+    const Color  a( 0xA9, 0, 0 );
+    const SolidBrush brush( a );
+
+    StringFormat  format;
+    format.SetAlignment( StringAlignmentCenter );
+    format.SetLineAlignment( StringAlignmentCenter );
+    const Font  font( L"Arial", 14, FontStyleBold );
+
+    const PuzzleN::element_t count = mPuzzle.N * mPuzzle.M;
+    for (PuzzleN::element_t element = 1; element < count; ++element) {
+        const Rect  cell = atlasCell( element );
+        const RectF  bounds(
+            float( cell.X ),  float( cell.Y ),
+            float( cell.Width ),  float( cell.Height )
+        );
+
+        // растягиваем фон на всю ячейку
+        g.DrawImage( &image, bounds );
+
+        std::wostringstream  ss;
+        ss << element;
+        g.DrawString( ss.str().c_str(), -1, &font, bounds, &format, &brush );
+    }
+    g.Flush( FlushIntentionSync );
+
+    // переносим пиксели в программный атлас
+    Framebuffer  result( atlas.GetWidth(), atlas.GetHeight() );
+    const Rect  all( 0, 0, atlas.GetWidth(), atlas.GetHeight() );
+    BitmapData  data;
+    atlas.LockBits( &all, ImageLockModeRead, PixelFormat32bppARGB, &data );
+    for (int y = 0; y < all.Height; ++y) {
+        const Framebuffer::pixel_t* from = reinterpret_cast< const Framebuffer::pixel_t* >(
+            static_cast< const uint8_t* >( data.Scan0 ) + y * data.Stride
+        );
+        std::copy( from,  from + all.Width,  result.row( y ) );
+    }
+    atlas.UnlockBits( &data );
+
+    return result;
+}
+
+
+
+
+Gdiplus::Rect
+Painter::atlasCell( const PuzzleN::element_t& element ) const {
+
+    DASSERT( element != PuzzleN::EMPTY_ELEMENT );
+
+    const int cellSize = static_cast< int >( mPuzzle.cellSize );
+    const PuzzleN::logicCoord_t lc = mPuzzle.ci( static_cast< int >( element ) - 1 );
+
+    return Gdiplus::Rect( lc.x * cellSize,  lc.y * cellSize,  cellSize,  cellSize );
+}
+
+
+} // puzzlen
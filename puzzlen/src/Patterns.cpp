@@ -0,0 +1,349 @@
+#include "../include/stdafx.h"
+#include "../include/Patterns.h"
+#include "../include/Geometry.h"
+#include "../include/Ranking.h"
+#include <cstring>
+#include <fstream>
+
+
+namespace puzzlen {
+
+
+const uint32_t  Patterns::FORMAT_VERSION;
+const size_t    Patterns::TABLE_ALIGNMENT;
+const size_t    Patterns::MAX_PATTERN;
+
+
+namespace {
+
+
+static const char MAGIC[ 8 ] = { 'P', 'Z', 'L', 'N', 'P', 'D', 'B', '\0' };
+
+static const uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+static const uint8_t UNKNOWN_COST = 0xFF;
+
+
+// @return 'size', выровненный вверх до 'alignment'.
+inline uint64_t align( uint64_t size, uint64_t alignment ) {
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+
+// @return Заголовок отображённого файла баз.
+// @throw Exception Если файл не похож на базы шаблонов.
+const Patterns::header_t& header( const MappedFile& file ) {
+
+    if (file.size() < sizeof( Patterns::header_t )) {
+        throw Exception( "Pattern database is truncated." );
+    }
+    const auto& h = *reinterpret_cast< const Patterns::header_t* >( file.data() );
+    if (std::memcmp( h.magic, MAGIC, sizeof( MAGIC ) ) != 0) {
+        throw Exception( "File is not a pattern database." );
+    }
+    if (h.byteOrder != BYTE_ORDER_MARK) {
+        throw Exception( "Pattern database has foreign byte order." );
+    }
+    if (h.version != Patterns::FORMAT_VERSION) {
+        throw Exception( "Pattern database has unsupported version." );
+    }
+    if (h.fileSize != file.size()) {
+        throw Exception( "Pattern database is truncated." );
+    }
+
+    return h;
+}
+
+
+} // namespace
+
+
+
+
+Patterns::Patterns( size_t n, size_t m, const partition_t& partition ) :
+    N( n ), M( m ),
+    mPartition( partition )
+{
+    const size_t cells = N * M;
+    if (cells > Geometry::MAX_CELLS) {
+        throw Exception( "Puzzle is too large for pattern databases." );
+    }
+    for (auto itr = mPartition.cbegin(); itr != mPartition.cend(); ++itr) {
+        if ( itr->empty() || (itr->size() > MAX_PATTERN) ) {
+            throw Exception( "Pattern must have from 1 to 16 elements." );
+        }
+        // # Номера состояний поиска должны укладываться в 32 бита.
+        if (Ranking::arrangements( itr->size(), cells ) * cells > 0xFFFFFFFFULL) {
+            throw Exception( "Pattern is too large for the database." );
+        }
+    }
+    index();
+
+    mBuilt.resize( mPartition.size() );
+    for (size_t k = 0; k < mPartition.size(); ++k) {
+        build( k, mBuilt[ k ] );
+        mTables.push_back( mBuilt[ k ].data() );
+    }
+}
+
+
+
+
+Patterns::Patterns( const std::string& file ) :
+    Patterns( std::unique_ptr< MappedFile >( new MappedFile( file ) ) )
+{
+}
+
+
+
+
+Patterns::Patterns( std::unique_ptr< MappedFile > f ) :
+    N( header( *f ).n ), M( header( *f ).m )
+{
+    const auto& h = header( *f );
+    const size_t cells = N * M;
+    if ( (N < 2) || (M < 2) || (cells > Geometry::MAX_CELLS) ) {
+        throw Exception( "Pattern database has wrong size of puzzle." );
+    }
+    const size_t described =
+        sizeof( header_t ) + h.patterns * sizeof( patternHeader_t );
+    if ( (h.patterns == 0) || (described > f->size()) ) {
+        throw Exception( "Pattern database is truncated." );
+    }
+
+    const auto* ph = reinterpret_cast< const patternHeader_t* >(
+        f->data() + sizeof( header_t )
+    );
+    for (size_t k = 0; k < h.patterns; ++k) {
+        const auto& p = ph[ k ];
+        if ( (p.count == 0) || (p.count > MAX_PATTERN)
+          || (p.entries != Ranking::arrangements( p.count, cells ))
+          || (p.offset + p.entries > f->size()) )
+        {
+            throw Exception( "Pattern database is corrupted." );
+        }
+        mPartition.push_back( pattern_t( p.elements, p.elements + p.count ) );
+        mTables.push_back( f->data() + p.offset );
+    }
+    index();
+
+    mFile = std::move( f );
+}
+
+
+
+
+Patterns::~Patterns() {
+}
+
+
+
+
+void
+Patterns::save( const std::string& file ) const {
+
+    const size_t cells = N * M;
+
+    header_t  h;
+    std::memset( &h, 0, sizeof( h ) );
+    std::memcpy( h.magic, MAGIC, sizeof( MAGIC ) );
+    h.byteOrder = BYTE_ORDER_MARK;
+    h.version   = FORMAT_VERSION;
+    h.n = static_cast< uint32_t >( N );
+    h.m = static_cast< uint32_t >( M );
+    h.patterns = static_cast< uint32_t >( mPartition.size() );
+
+    std::vector< patternHeader_t >  ph( mPartition.size() );
+    uint64_t offset = align(
+        sizeof( header_t ) + ph.size() * sizeof( patternHeader_t ),  TABLE_ALIGNMENT
+    );
+    for (size_t k = 0; k < mPartition.size(); ++k) {
+        auto& p = ph[ k ];
+        std::memset( &p, 0, sizeof( p ) );
+        p.count   = static_cast< uint32_t >( mPartition[ k ].size() );
+        p.offset  = offset;
+        p.entries = Ranking::arrangements( p.count, cells );
+        for (size_t j = 0; j < p.count; ++j) {
+            p.elements[ j ] = static_cast< uint8_t >( mPartition[ k ][ j ] );
+        }
+        offset = align( offset + p.entries, TABLE_ALIGNMENT );
+    }
+    h.fileSize = ph.back().offset + ph.back().entries;
+
+    std::ofstream  fs( file.c_str(), std::ios::binary | std::ios::trunc );
+    if ( !fs.is_open() ) {
+        throw Exception( "File " + file + " can not be created." );
+    }
+    fs.write( reinterpret_cast< const char* >( &h ), sizeof( h ) );
+    fs.write(
+        reinterpret_cast< const char* >( ph.data() ),
+        ph.size() * sizeof( patternHeader_t )
+    );
+    for (size_t k = 0; k < mPartition.size(); ++k) {
+        const uint64_t gap = ph[ k ].offset - static_cast< uint64_t >( fs.tellp() );
+        const std::vector< char >  zero( static_cast< size_t >( gap ), 0 );
+        fs.write( zero.data(), zero.size() );
+        fs.write(
+            reinterpret_cast< const char* >( mTables[ k ] ),
+            static_cast< std::streamsize >( ph[ k ].entries )
+        );
+    }
+    if ( !fs.good() ) {
+        throw Exception( "File " + file + " can not be written." );
+    }
+}
+
+
+
+
+Patterns::partition_t
+Patterns::defaultPartition( size_t n, size_t m ) {
+
+    // # Классическое разбиение 6-6-3 для 4 x 4.
+    if ( (n == 4) && (m == 4) ) {
+        static const PuzzleN::element_t A[] = { 1, 5, 6, 9, 10, 13 };
+        static const PuzzleN::element_t B[] = { 7, 8, 11, 12, 14, 15 };
+        static const PuzzleN::element_t C[] = { 2, 3, 4 };
+        partition_t  partition;
+        partition.push_back( pattern_t( A, A + 6 ) );
+        partition.push_back( pattern_t( B, B + 6 ) );
+        partition.push_back( pattern_t( C, C + 3 ) );
+        return partition;
+    }
+
+    return rowPartition( n, m, 5 );
+}
+
+
+
+
+Patterns::partition_t
+Patterns::rowPartition( size_t n, size_t m, size_t size ) {
+
+    DASSERT( size > 0 );
+    partition_t  partition;
+    for (size_t e = 1; e < n * m; ++e) {
+        if ( partition.empty() || (partition.back().size() >= size) ) {
+            partition.push_back( pattern_t() );
+        }
+        partition.back().push_back( e );
+    }
+    return partition;
+}
+
+
+
+
+void
+Patterns::build( size_t k, std::vector< uint8_t >& table ) const {
+
+    const Geometry  geometry( N, M );
+    const size_t cells = geometry.cells;
+    const pattern_t& pattern = mPartition[ k ];
+    const size_t count = pattern.size();
+    const uint64_t entries = Ranking::arrangements( count, cells );
+
+    // стоимость по состоянию: ранг * cells + пустая ячейка
+    std::vector< uint8_t >  cost( static_cast< size_t >( entries * cells ), UNKNOWN_COST );
+    std::vector< uint32_t >  level;
+    std::vector< uint32_t >  next;
+
+    int positions[ MAX_PATTERN ];
+    for (size_t j = 0; j < count; ++j) {
+        positions[ j ] = geometry.goal( static_cast< int >( pattern[ j ] ) );
+    }
+    const uint32_t start = static_cast< uint32_t >(
+        Ranking::rank( positions, count, cells ) * cells
+      + geometry.goal( PuzzleN::EMPTY_ELEMENT )
+    );
+    cost[ start ] = 0;
+    level.push_back( start );
+
+    for (uint8_t c = 0; !level.empty(); ++c) {
+        if (c == UNKNOWN_COST - 1) {
+            throw Exception( "Pattern costs do not fit the database." );
+        }
+        // # Очередь уровня растёт по ходу: бесплатные ходы остаются в нём.
+        for (size_t q = 0; q < level.size(); ++q) {
+            const uint32_t state = level[ q ];
+            if (cost[ state ] != c) {
+                // уже нашли дешевле
+                continue;
+            }
+            const uint64_t r = state / cells;
+            const int blank = static_cast< int >( state % cells );
+            Ranking::unrank( r, positions, count, cells );
+
+            for (int d = 0; d < 4; ++d) {
+                const int from = geometry.source( blank, d );
+                if (from < 0) {
+                    continue;
+                }
+                size_t j = 0;
+                while ( (j < count) && (positions[ j ] != from) ) {
+                    ++j;
+                }
+
+                if (j == count) {
+                    // сдвигаем чужой элемент - бесплатно
+                    const uint32_t s = static_cast< uint32_t >( r * cells + from );
+                    if (cost[ s ] > c) {
+                        cost[ s ] = c;
+                        level.push_back( s );
+                    }
+                    continue;
+                }
+
+                positions[ j ] = blank;
+                const uint32_t s = static_cast< uint32_t >(
+                    Ranking::rank( positions, count, cells ) * cells + from
+                );
+                positions[ j ] = from;
+                if (cost[ s ] > c + 1) {
+                    cost[ s ] = static_cast< uint8_t >( c + 1 );
+                    next.push_back( s );
+                }
+            }
+        }
+
+        level.swap( next );
+        next.clear();
+    }
+
+    // # Для оценки положение пустой ячейки не известно: берём лучшее.
+    table.assign( static_cast< size_t >( entries ), UNKNOWN_COST );
+    for (uint64_t r = 0; r < entries; ++r) {
+        const uint8_t* row = cost.data() + r * cells;
+        table[ static_cast< size_t >( r ) ] = *std::min_element( row, row + cells );
+    }
+}
+
+
+
+
+void
+Patterns::index() {
+
+    const size_t cells = N * M;
+    mPatternOf.assign( cells, mPartition.size() );
+    for (size_t k = 0; k < mPartition.size(); ++k) {
+        const auto& pattern = mPartition[ k ];
+        for (auto itr = pattern.cbegin(); itr != pattern.cend(); ++itr) {
+            const PuzzleN::element_t e = *itr;
+            if ( (e == PuzzleN::EMPTY_ELEMENT) || (e >= cells)
+              || (mPatternOf[ e ] != mPartition.size()) )
+            {
+                throw Exception( "Patterns must cover each element of puzzle once." );
+            }
+            mPatternOf[ e ] = k;
+        }
+    }
+    for (size_t e = 1; e < cells; ++e) {
+        if (mPatternOf[ e ] == mPartition.size()) {
+            throw Exception( "Patterns must cover each element of puzzle once." );
+        }
+    }
+}
+
+
+} // puzzlen
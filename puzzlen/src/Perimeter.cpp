@@ -0,0 +1,165 @@
+#include "../include/stdafx.h"
+#include "../include/Perimeter.h"
+
+
+namespace puzzlen {
+
+
+const size_t   Perimeter::MAX_WORDS;
+const size_t   Perimeter::LOAD_FACTOR;
+const size_t   Perimeter::MIN_CAPACITY;
+const uint8_t  Perimeter::EMPTY;
+
+
+
+
+Perimeter::Perimeter( const Geometry& geometry,  size_t budget ) :
+    budget( budget ),
+    mPacking( geometry.N, geometry.M ),
+    mDepth( 0 ),
+    mSize( 0 ),
+    mMask( 0 )
+{
+    if (mPacking.words > MAX_WORDS) {
+        throw Exception( "Puzzle is too large for the perimeter." );
+    }
+
+    const size_t words = mPacking.words;
+    const size_t cells = geometry.cells;
+
+    // собранное поле
+    std::vector< uint8_t >  tiles( cells );
+    for (size_t i = 0; i + 1 < cells; ++i) {
+        tiles[ i ] = static_cast< uint8_t >( i + 1 );
+    }
+    tiles[ cells - 1 ] = static_cast< uint8_t >( PuzzleN::EMPTY_ELEMENT );
+
+    grow( MIN_CAPACITY );
+    std::vector< uint64_t >  layer( words );
+    mPacking.pack( tiles.data(), layer.data() );
+    const size_t goal = find( layer.data() );
+    std::copy( layer.cbegin(), layer.cend(), mKey.begin() + goal * words );
+    mDistance[ goal ] = 0;
+    mSize = 1;
+
+    std::vector< uint64_t >  next;
+    uint64_t  child[ MAX_WORDS ];
+    // # Глубина ограничена байтом расстояния.
+    while (mDepth + 1 < EMPTY) {
+        // # Из расстановки не больше 3 новых: четвёртый ход - назад, к
+        //   предыдущему слою. Проверяем бюджет по худшему случаю до
+        //   начала слоя: слой не приходится откатывать.
+        const size_t states = layer.size() / words;
+        const size_t most = mSize + states * 3;
+        size_t capacity = mDistance.size();
+        while (capacity < most * LOAD_FACTOR) {
+            capacity *= 2;
+        }
+        const size_t peak =
+            tableBytes( capacity ) +
+            ((capacity != mDistance.size()) ? tableBytes( mDistance.size() ) : 0) +
+            (states + states * 3) * words * sizeof( uint64_t );
+        if (peak > budget) {
+            break;
+        }
+        if (capacity != mDistance.size()) {
+            grow( capacity );
+        }
+
+        next.clear();
+        next.reserve( states * 3 * words );
+        const uint8_t distance = static_cast< uint8_t >( mDepth + 1 );
+        for (size_t k = 0; k < states; ++k) {
+            mPacking.unpack( layer.data() + k * words,  tiles.data() );
+            const int blank = static_cast< int >(
+                std::find( tiles.cbegin(), tiles.cend(), PuzzleN::EMPTY_ELEMENT ) - tiles.cbegin()
+            );
+            for (int d = 0; d < 4; ++d) {
+                const int from = geometry.source( blank, d );
+                if (from < 0) {
+                    continue;
+                }
+                std::swap( tiles[ from ],  tiles[ blank ] );
+                mPacking.pack( tiles.data(), child );
+                std::swap( tiles[ from ],  tiles[ blank ] );
+                const size_t slot = find( child );
+                if (mDistance[ slot ] != EMPTY) {
+                    continue;
+                }
+                std::copy( child,  child + words,  mKey.begin() + slot * words );
+                mDistance[ slot ] = distance;
+                ++mSize;
+                next.insert( next.end(),  child,  child + words );
+            }
+        }
+        if ( next.empty() ) {
+            // # Периметр накрыл все решаемые расстановки.
+            break;
+        }
+        ++mDepth;
+        layer.swap( next );
+    }
+}
+
+
+
+
+Perimeter::~Perimeter() {
+}
+
+
+
+
+int
+Perimeter::distance( const uint8_t* tiles ) const {
+
+    uint64_t  word[ MAX_WORDS ];
+    mPacking.pack( tiles, word );
+    const uint8_t d = mDistance[ find( word ) ];
+
+    return (d == EMPTY) ? -1 : static_cast< int >( d );
+}
+
+
+
+
+size_t
+Perimeter::find( const uint64_t* word ) const {
+
+    const size_t words = mPacking.words;
+    for (size_t slot = Packing::hash( word, words ) & mMask; ; slot = (slot + 1) & mMask) {
+        if ( (mDistance[ slot ] == EMPTY) ||
+             std::equal( word,  word + words,  mKey.cbegin() + slot * words )
+        ) {
+            return slot;
+        }
+    }
+}
+
+
+
+
+void
+Perimeter::grow( size_t capacity ) {
+
+    DASSERT( (capacity & (capacity - 1)) == 0 );
+
+    const size_t words = mPacking.words;
+    std::vector< uint64_t >  key( capacity * words );
+    std::vector< uint8_t >  distance( capacity, EMPTY );
+    key.swap( mKey );
+    distance.swap( mDistance );
+    mMask = capacity - 1;
+    for (size_t slot = 0; slot < distance.size(); ++slot) {
+        if (distance[ slot ] == EMPTY) {
+            continue;
+        }
+        const uint64_t* word = key.data() + slot * words;
+        const size_t to = find( word );
+        std::copy( word,  word + words,  mKey.begin() + to * words );
+        mDistance[ to ] = distance[ slot ];
+    }
+}
+
+
+} // puzzlen
@@ -1,22 +1,34 @@
 #include "../include/stdafx.h"
 #include "../include/PuzzleN.h"
 #include <assert.h>
+#include <random>
 
 
 namespace puzzlen {
 
 
+const PuzzleN::element_t  PuzzleN::EMPTY_ELEMENT;
+
+const char  PuzzleN::DIRECTION_NAME[] = "NSWE";
+
+
+
+
 PuzzleN::PuzzleN( size_t n, size_t m, size_t cellSize ) :
     N( n ), M( m ),
     cellSize( cellSize ),
-    mPressMouseButton( false ),
-    glueDistance( cellSize * GLUE_PERCENT / 100 )
+    glueDistance( cellSize * GLUE_PERCENT / 100 ),
+    mDamageAll( false ),
+    mPressMouseButton( false )
 {
     ASSERT( ((n > 1) && (m > 1))
         && "Width and height of puzzle must have value above 1." );
     ASSERT( ( (cellSize >= 10) && (cellSize <= 100) )
         && "Size of cell must have value between [10; 100]." );
 
+    // # Больше областей, чем ячеек, не бывает: кадры без выделения памяти.
+    mDamage.reserve( n * m );
+
     createField();
 
     resetMove();
@@ -34,13 +46,14 @@ PuzzleN::~PuzzleN() {
 void
 PuzzleN::createField() {
 
+    mField.clear();
     mField.reserve( N * M );
     for (int y = 0; y < static_cast< int >( M ); ++y) {
         for (int x = 0; x < static_cast< int >( N ); ++x) {
 
-            // #     
+            // # Последняя ячейка должна остаться пустой
             const int i = ic( x, y );
-            if (i == (M * N - 1)) {
+            if (i == static_cast< int >( M * N - 1 )) {
                 mField.push_back( EMPTY_ELEMENT );
                 break;
             }
@@ -50,136 +63,164 @@ PuzzleN::createField() {
 
         } // for (size_t x = 0; ...
     } // for (size_t y = 0; ...
+
+    indexPositions();
+    mHistory.clear();
+    damageAll();
 }
 
 
 
 
 void
-PuzzleN::shuffle() {
-    std::srand( static_cast< unsigned int >( time( nullptr ) ) );
-    std::random_shuffle( mField.begin(), mField.end() );
+PuzzleN::field( const field_t& field ) {
+
+    if (field.size() != N * M) {
+        throw Exception( "Size of field does not match the puzzle." );
+    }
+    std::vector< bool >  seen( field.size(), false );
+    for (auto itr = field.cbegin(); itr != field.cend(); ++itr) {
+        if ((*itr >= field.size()) || seen[ *itr ]) {
+            throw Exception( "Field must be a permutation of the puzzle elements." );
+        }
+        seen[ *itr ] = true;
+    }
+
+    mField = field;
+    indexPositions();
     resetMove();
+    mHistory.clear();
+    damageAll();
 }
 
 
 
 
-void
-PuzzleN::draw( HDC hdc,  const RECT& rc ) {
-
-    using namespace Gdiplus;
+bool
+PuzzleN::solved() const {
 
-    auto p = picture( rc );
-    Graphics  g( hdc, false );
-    const Rect  dest( 0, 0, p->GetWidth(), p->GetHeight() );
-    g.DrawImage( p.get(), dest, 0, 0, p->GetWidth(), p->GetHeight(), UnitPixel );
+    const size_t last = mField.size() - 1;
+    if (mField[ last ] != EMPTY_ELEMENT) {
+        return false;
+    }
+    for (size_t i = 0; i < last; ++i) {
+        if (mField[ i ] != i + 1) {
+            return false;
+        }
+    }
+    return true;
 }
 
 
 
 
-std::unique_ptr< Gdiplus::Bitmap >
-PuzzleN::sprite( const element_t&  element ) {
-
-    using namespace Gdiplus;
-
-    DASSERT( element != EMPTY_ELEMENT );
-
-    std::unique_ptr< Bitmap >  s( new Bitmap(
-        cellSize, cellSize, PixelFormat32bppPARGB
-    ) );
-
-    Graphics  g( s.get() );
-    //g.Clear( 0xffffffff );
-#if 0
-    g.SetCompositingMode( CompositingModeSourceOver );
-    g.SetCompositingQuality( CompositingQualityHighSpeed );
-    g.SetPixelOffsetMode( PixelOffsetModeHighSpeed );
-    g.SetSmoothingMode( SmoothingModeHighSpeed );
-    g.SetInterpolationMode( InterpolationModeHighQuality );
-#else
-    // 
-    g.SetCompositingMode( CompositingModeSourceOver );
-    g.SetCompositingQuality( CompositingQualityHighSpeed );
-    g.SetPixelOffsetMode( PixelOffsetModeHalf );
-    g.SetSmoothingMode( SmoothingModeHighSpeed );
-    g.SetInterpolationMode( InterpolationModeNearestNeighbor );
-#endif
-    g.SetTextRenderingHint( TextRenderingHintAntiAliasGridFit );
-    g.SetPageUnit( UnitPixel );
-
-    const RectF
-        bounds( 0, 0, float( s->GetWidth() ), float( s->GetHeight() ) );
-
-    //   ,    
-    const std::wstring file = PATH_MEDIA + L"/cell.png";
-    Image  image( file.c_str() );
-    //ASSERT( (bg.GetType() != ImageTypeUnknown)
-    //    && "Image for cell not found." );
-    g.DrawImage( &image, bounds );
-
-#if 0
-    //  
-    const Color  a( rand() % 255,  rand() % 255,  rand() % 255 );
-    const Color  b( 255 - a.GetG(),  255 - a.GetB(),  255 - a.GetR() );
-    const LinearGradientBrush
-        brush( bounds, a, b, LinearGradientModeBackwardDiagonal );
-#else
-    const Color  a( 0xA9, 0, 0 );
-    const SolidBrush brush( a );
-#endif
-    
-    StringFormat  format;
-    format.SetAlignment( StringAlignmentCenter );
-    format.SetLineAlignment( StringAlignmentCenter );
-    const Font  font( L"Arial", 14, FontStyleBold );
+uint64_t
+PuzzleN::shuffle() {
+    std::random_device  rd;
+    const uint64_t seed = (static_cast< uint64_t >( rd() ) << 32) ^ rd();
+    shuffle( seed );
+    return seed;
+}
 
-    std::wostringstream  ss;
-    ss << element;
-    g.DrawString( ss.str().c_str(), -1, &font, bounds, &format, &brush );
 
-    return std::move( s );
+
+
+void
+PuzzleN::shuffle( uint64_t seed ) {
+    Random  random( seed );
+    mField.resize( N * M );
+    shuffleField( mField.data(), N, M, random );
+    indexPositions();
+    resetMove();
+    mHistory.clear();
+    damageAll();
 }
 
 
 
 
-std::unique_ptr< Gdiplus::Bitmap >
-PuzzleN::picture( const RECT& rc ) {
+void
+PuzzleN::shuffleBatch(
+    field_t& out,  size_t n,  size_t m,  uint64_t seed,  size_t count
+) {
+    const size_t cells = n * m;
+    out.resize( cells * count );
+    for (size_t k = 0; k < count; ++k) {
+        Random  random( seed, k );
+        shuffleField( out.data() + k * cells,  n,  m,  random );
+    }
+}
+
 
-    using namespace Gdiplus;
 
-    std::unique_ptr< Bitmap >  p( new Bitmap(
-        rc.right  - rc.left,
-        rc.bottom - rc.top,
-        PixelFormat32bppPARGB
-    ) );
-    Graphics  g( p.get() );
-    g.Clear( 0xffffffff );
 
-    for (auto itr = mField.cbegin(); itr != mField.cend(); ++itr) {
+bool
+PuzzleN::solvable( const field_t& field,  size_t n,  size_t m ) {
+
+    const size_t cells = n * m;
+    if (field.size() != cells) {
+        return false;
+    }
+
+    // куда элемент должен попасть в собранном поле
+    const auto goal = [ cells ]( element_t element ) -> size_t {
+        return (element == EMPTY_ELEMENT) ? (cells - 1) : (element - 1);
+    };
 
-        const element_t element = *itr;
+    std::vector< bool >  seen( cells, false );
+    size_t emptyI = cells;
+    for (size_t i = 0; i < cells; ++i) {
+        const element_t element = field[ i ];
+        if ((element >= cells) || seen[ element ]) {
+            // не перестановка
+            return false;
+        }
+        seen[ element ] = true;
         if (element == EMPTY_ELEMENT) {
+            emptyI = i;
+        }
+    }
+
+    // чётность перестановки: (количество ячеек - количество циклов)
+    std::fill( seen.begin(), seen.end(), false );
+    size_t cycles = 0;
+    for (size_t i = 0; i < cells; ++i) {
+        if ( seen[ i ] ) {
             continue;
         }
+        ++cycles;
+        for (size_t j = i; !seen[ j ]; j = goal( field[ j ] )) {
+            seen[ j ] = true;
+        }
+    }
+    const bool odd = ((cells - cycles) & 1) != 0;
+
+    const size_t ex = emptyI % n;
+    const size_t ey = emptyI / n;
+    const bool emptyOdd = (((n - 1 - ex) + (m - 1 - ey)) & 1) != 0;
+
+    return (odd == emptyOdd);
+}
 
-        const size_t i = std::distance( mField.cbegin(), itr );
-        const logicCoord_t lc = ci( i );
 
-        //      
-        const bool shifted = (i == mMove.i);
 
-        const auto s = sprite( element );
-        const int cx = lc.x * cellSize + (shifted ? mMove.shift.x : 0);
-        const int cy = lc.y * cellSize + (shifted ? mMove.shift.y : 0);
-        const Rect  dest( cx, cy, s->GetWidth(), s->GetHeight() );
-        g.DrawImage( s.get(), dest, 0, 0, s->GetWidth(), s->GetHeight(), UnitPixel );
 
-    } // for (auto itr = mField.cbegin(); ...
+PuzzleN::field_t
+PuzzleN::parseField( const std::string& s ) {
 
-    return std::move( p );
+    std::string  spaced = s;
+    std::replace( spaced.begin(), spaced.end(), ',', ' ' );
+    std::istringstream  ss( spaced );
+    field_t  field;
+    element_t  element;
+    while (ss >> element) {
+        field.push_back( element );
+    }
+    if ( !ss.eof() ) {
+        throw Exception( "Board is not recognized." );
+    }
+
+    return field;
 }
 
 
@@ -188,32 +229,33 @@ PuzzleN::picture( const RECT& rc ) {
 void
 PuzzleN::firstClick( int x, int y ) {
 
-    //  ,   
-    const logicCoord_t lc = { x / cellSize,  y / cellSize };
+    // определим элемент, который собираются тянуть
+    const int cs = static_cast< int >( cellSize );
+    const logicCoord_t lc = { x / cs,  y / cs };
     const int i = ic( lc );
     DASSERT( (i >= 0) || (i < static_cast< int >( mField.size() )) );
 
-    //     ?
+    // все элементы на фиксированных позициях?
     const auto ei = emptyElement();
     if ( !allFixed() ) {
-        //     ?   ?
+        // не зафиксирован именно этот элемент? пытаются двинуть пустой?
         if ( (i != whoUnfixed()) && (i != ei) ) {
             return;
         }
     }
 
-    //   ?
+    // элемент может перемещаться?
     if ( !hasPermitShift( i ) ) {
         return;
     }
     
-    // ,   ** 
+    // запомним, какой элемент *начинает* перемещение
     if ( (mMove.i == -1) || (i == whoUnfixed()) || (i == ei) ) {
-        //     
+        // сохраним старое смещение для элемента
         mMove.firstClick.x = x - mMove.shift.x;
         mMove.firstClick.y = y - mMove.shift.y;
         if (i == ei) {
-            //      
+            // захват был со стороны пустого элемента
             const logicCoord_t elc = ci( mMove.i );
             const logicCoord_t delta = { lc.x - elc.x,  lc.y - elc.y };
             mMove.emptyClickShift.x = delta.x * cellSize;
@@ -235,21 +277,22 @@ void
 PuzzleN::move( int x, int y ) {
 
     if (mMove.i == -1) {
-        //     
+        // элемент для перемещения не выбран
         return;
     }
 
     if (mMove.firstClick.x == -1) {
-        //      
+        // щелчок был не на этом элементе
         return;
     }
 
     if ( !mPressMouseButton ) {
-        //    
+        // клавиша мыши не опущена
         return;
     }
 
     const auto ps = permitShift( mMove.i );
+    const visualCoord_t  was = mMove.shift;
     const int  sx = x - mMove.firstClick.x + mMove.emptyClickShift.x;
     const int  sy = y - mMove.firstClick.y + mMove.emptyClickShift.y;
     mMove.shift.x = ((ps.west  && (sx < 0)) || (ps.east  && (sx > 0))) ? sx : 0;
@@ -260,6 +303,10 @@ PuzzleN::move( int x, int y ) {
     if (std::abs( mMove.shift.y ) > static_cast< int >( cellSize )) {
         mMove.shift.y = cellSize * ((mMove.shift.y < 0) ? -1 : 1);
     }
+
+    if ( (mMove.shift.x != was.x) || (mMove.shift.y != was.y) ) {
+        damageMove();
+    }
 }
 
 
@@ -269,12 +316,12 @@ void
 PuzzleN::stickMove() {
 
     if (mMove.i == -1) {
-        //     
+        // элемент для перемещения не выбран
         return;
     }
 
-    //   
-    //  "" ( )
+    // зафиксируем перемещение элемента
+    // реализуем "прилипание" (для удобства)
     const size_t dx = std::abs( mMove.shift.x );
     const size_t dy = std::abs( mMove.shift.y );
     const auto ps = permitShift( mMove.i );
@@ -287,19 +334,28 @@ PuzzleN::stickMove() {
         glueY = (dy <= glueDistance) || ((cellSize - dy) <= glueDistance);
     }
 
-    // #      .
+    // # Элемент умеет оставаться в промежуточной позиции.
     if ( !glueX && !glueY ) {
         return;
     }
 
-    // #        .
+    damageMove();
+
+    // # Элемент может поменяться местами только с пустым элементом.
     const bool change =
         (glueX && ((cellSize - dx) <= glueDistance))
      || (glueY && ((cellSize - dy) <= glueDistance));
     if ( change ) {
-        //   
-        const int emptyI = emptyElement();
-        std::swap( mField.at( mMove.i ),  mField.at( emptyI ) );
+        // обменяем с пустым, запомним ход
+        const int ei = emptyElement();
+        const logicCoord_t lc  = ci( mMove.i );
+        const logicCoord_t elc = ci( ei );
+        const direction_t direction =
+            (elc.y < lc.y) ? NORTH :
+            (elc.y > lc.y) ? SOUTH :
+            (elc.x < lc.x) ? WEST : EAST;
+        swapElement( mMove.i,  ei );
+        mHistory.push( direction );
     }
 
     mMove.i = -1;
@@ -309,6 +365,157 @@ PuzzleN::stickMove() {
 
 
 
+bool
+PuzzleN::shift( direction_t direction ) {
+
+    if ( !shiftElement( direction ) ) {
+        return false;
+    }
+    mHistory.push( direction );
+
+    return true;
+}
+
+
+
+
+bool
+PuzzleN::undo() {
+
+    if ( !mHistory.canUndo() ) {
+        return false;
+    }
+    // # Обратный ход всегда возможен: элемент стоит там, куда его сдвинули.
+    shiftElement( opposite( static_cast< direction_t >( mHistory.undo() ) ) );
+
+    return true;
+}
+
+
+
+
+bool
+PuzzleN::redo() {
+
+    if ( !mHistory.canRedo() ) {
+        return false;
+    }
+    shiftElement( static_cast< direction_t >( mHistory.redo() ) );
+
+    return true;
+}
+
+
+
+
+size_t
+PuzzleN::seek( size_t position ) {
+
+    size_t count = 0;
+    while ( (mHistory.position() > position) && undo() ) {
+        ++count;
+    }
+    while ( (mHistory.position() < position) && redo() ) {
+        ++count;
+    }
+
+    return count;
+}
+
+
+
+
+bool
+PuzzleN::shiftElement( direction_t direction ) {
+
+    static const int DX[] = { 0,  0,  -1,  1 };
+    static const int DY[] = { -1, 1,   0,  0 };
+
+    // элемент стоит с противоположной от направления стороны пустой ячейки
+    const int ei = emptyElement();
+    const logicCoord_t elc = ci( ei );
+    const logicCoord_t lc = { elc.x - DX[ direction ],  elc.y - DY[ direction ] };
+    if ( !inside( lc ) ) {
+        return false;
+    }
+
+    // # Недотянутый мышью элемент возвращается на место.
+    damageMove();
+    damageCell( ic( lc ) );
+    damageCell( ei );
+    swapElement( ic( lc ),  ei );
+    resetMove();
+
+    return true;
+}
+
+
+
+
+void
+PuzzleN::indexPositions() {
+
+    mPosition.resize( mField.size() );
+    for (size_t i = 0; i < mField.size(); ++i) {
+        mPosition[ mField[ i ] ] = i;
+    }
+}
+
+
+
+
+void
+PuzzleN::damageCell( int i ) {
+
+    if ( mDamageAll ) {
+        return;
+    }
+    const visualRect_t  r = {
+        ci( i ).x * static_cast< int >( cellSize ),
+        ci( i ).y * static_cast< int >( cellSize ),
+        (ci( i ).x + 1) * static_cast< int >( cellSize ),
+        (ci( i ).y + 1) * static_cast< int >( cellSize )
+    };
+    for (auto itr = mDamage.cbegin(); itr != mDamage.cend(); ++itr) {
+        if ( (itr->left == r.left) && (itr->top == r.top) ) {
+            return;
+        }
+    }
+    mDamage.push_back( r );
+}
+
+
+
+
+void
+PuzzleN::damageMove() {
+
+    if (mMove.i == -1) {
+        return;
+    }
+    damageCell( mMove.i );
+    damageCell( emptyElement() );
+}
+
+
+
+
+void
+PuzzleN::damageAll() {
+
+    const visualRect_t  r = {
+        0,  0,
+        static_cast< int >( N * cellSize ),
+        static_cast< int >( M * cellSize )
+    };
+    mDamage.clear();
+    mDamage.push_back( r );
+    mDamageAll = true;
+}
+
+
+
+
 void
 PuzzleN::resetMove() {
     static const move_t EMPTY_MOVE = {
@@ -356,7 +563,7 @@ PuzzleN::permitShift( int i ) const {
         !neighbourNorth( lc ),  !neighbourSouth( lc ),
         !neighbourWest( lc ),   !neighbourEast( lc )
     };
-    // #        .
+    // # Элемент может смещаться только по вертикали или горизонтали.
     ASSERT( ( !(ps.north || ps.south || ps.west || ps.east)
             || ( (ps.north || ps.south) && !(ps.west || ps.east))
             || (!(ps.north || ps.south) &&  (ps.west || ps.east))
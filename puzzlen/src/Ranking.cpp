@@ -0,0 +1,92 @@
+#include "../include/stdafx.h"
+#include "../include/Ranking.h"
+
+
+namespace puzzlen {
+
+
+const size_t  Ranking::WORDS;
+const size_t  Ranking::MAX_FIELD;
+
+
+uint8_t  Ranking::BYTE_BITS[ 256 ];
+uint8_t  Ranking::BYTE_SELECT[ 256 * 8 ];
+
+const bool  Ranking::mFilled = Ranking::fill();
+
+
+
+
+uint64_t
+Ranking::rank( const PuzzleN::field_t& field ) {
+
+    const size_t cells = field.size();
+    if (cells == 0) {
+        throw Exception( "Empty puzzle has no permutation rank." );
+    }
+    if (cells > MAX_FIELD) {
+        throw Exception( "Puzzle is too large to rank its permutations." );
+    }
+
+    int positions[ MAX_FIELD ];
+    std::fill( positions, positions + cells, -1 );
+    for (size_t i = 0; i < cells; ++i) {
+        const size_t e = field[ i ];
+        if ( (e >= cells) || (positions[ e ] >= 0) ) {
+            throw Exception( "Elements of puzzle are not a permutation." );
+        }
+        positions[ e ] = static_cast< int >( i );
+    }
+    // # Место последнего элемента - оставшаяся ячейка: цифра всегда 0.
+    return rank( positions, cells - 1, cells );
+}
+
+
+
+
+void
+Ranking::unrank( uint64_t rank,  PuzzleN::field_t& field ) {
+
+    const size_t cells = field.size();
+    if (cells > MAX_FIELD) {
+        throw Exception( "Puzzle is too large to rank its permutations." );
+    }
+    // # 20! < 2^64: произведение не переполняется.
+    uint64_t permutations = 1;
+    for (size_t k = 2; k <= cells; ++k) {
+        permutations *= k;
+    }
+    if (rank >= permutations) {
+        throw Exception( "Rank is out of the permutations of puzzle." );
+    }
+
+    int positions[ MAX_FIELD ];
+    unrank( rank, positions, cells, cells );
+    for (size_t e = 0; e < cells; ++e) {
+        field[ positions[ e ] ] = static_cast< PuzzleN::element_t >( e );
+    }
+}
+
+
+
+
+
+
+bool
+Ranking::fill() {
+
+    for (size_t b = 0; b < 256; ++b) {
+        size_t k = 0;
+        for (size_t i = 0; i < 8; ++i) {
+            if ((b >> i) & 1) {
+                BYTE_SELECT[ b * 8 + k ] = static_cast< uint8_t >( i );
+                ++k;
+            }
+        }
+        BYTE_BITS[ b ] = static_cast< uint8_t >( k );
+    }
+    return true;
+}
+
+
+} // puzzlen
@@ -0,0 +1,197 @@
+#include "../include/stdafx.h"
+#include "../include/Recorder.h"
+#include <fstream>
+
+
+namespace puzzlen {
+
+
+const char     Recorder::MAGIC[ 4 ] = { 'P', 'Z', 'N', 'R' };
+const uint8_t  Recorder::FORMAT_VERSION;
+
+
+
+
+Recorder::Recorder( const PuzzleN& puzzle ) :
+    mPuzzle( puzzle ),
+    mEvents( 0 ),
+    mFinished( false ),
+    mLast( 0 ),
+    mStarted( false ),
+    mX( 0 ),
+    mY( 0 )
+{
+    for (size_t k = 0; k < sizeof( MAGIC ); ++k) {
+        mData.push_back( static_cast< uint8_t >( MAGIC[ k ] ) );
+    }
+    mData.push_back( FORMAT_VERSION );
+    put( puzzle.N );
+    put( puzzle.M );
+    put( puzzle.cellSize );
+    const auto& field = puzzle.field();
+    for (auto itr = field.cbegin(); itr != field.cend(); ++itr) {
+        put( *itr );
+    }
+}
+
+
+
+
+Recorder::~Recorder() {
+}
+
+
+
+
+void
+Recorder::press( int x, int y, time_t now ) {
+
+    event( PRESS, now );
+    putSigned( x );
+    putSigned( y );
+    mX = x;
+    mY = y;
+}
+
+
+
+
+void
+Recorder::move( int x, int y, time_t now ) {
+
+    event( MOVE, now );
+    putSigned( x - mX );
+    putSigned( y - mY );
+    mX = x;
+    mY = y;
+}
+
+
+
+
+void
+Recorder::release( time_t now ) {
+
+    event( RELEASE, now );
+}
+
+
+
+
+void
+Recorder::shuffle( uint64_t seed, time_t now ) {
+
+    event( SHUFFLE, now );
+    put( seed );
+}
+
+
+
+
+void
+Recorder::undo( time_t now ) {
+
+    event( UNDO, now );
+}
+
+
+
+
+void
+Recorder::redo( time_t now ) {
+
+    event( REDO, now );
+}
+
+
+
+
+void
+Recorder::finish() {
+
+    if ( mFinished ) {
+        return;
+    }
+    mData.push_back( END );
+    put( 0 );
+    putState();
+    mFinished = true;
+}
+
+
+
+
+void
+Recorder::save( const std::string& file ) const {
+
+    std::ofstream  fs( file.c_str(), std::ios::binary | std::ios::trunc );
+    if ( !fs.is_open() ) {
+        throw Exception( "File " + file + " can not be created." );
+    }
+    fs.write( reinterpret_cast< const char* >( mData.data() ), mData.size() );
+    if ( !fs ) {
+        throw Exception( "File " + file + " is not written." );
+    }
+}
+
+
+
+
+void
+Recorder::event( event_t type, time_t now ) {
+
+    DASSERT( !mFinished && "Recording is finished." );
+
+    // # Первое событие - от начала записи.
+    const time_t dt = (mStarted && (now > mLast)) ? (now - mLast) : 0;
+    mLast = now;
+    mStarted = true;
+    mData.push_back( static_cast< uint8_t >( type ) );
+    put( dt );
+    ++mEvents;
+}
+
+
+
+
+void
+Recorder::put( uint64_t v ) {
+
+    while (v >= 0x80) {
+        mData.push_back( static_cast< uint8_t >( v | 0x80 ) );
+        v >>= 7;
+    }
+    mData.push_back( static_cast< uint8_t >( v ) );
+}
+
+
+
+
+void
+Recorder::putSigned( int64_t v ) {
+
+    put( (static_cast< uint64_t >( v ) << 1) ^ static_cast< uint64_t >( v >> 63 ) );
+}
+
+
+
+
+void
+Recorder::putState() {
+
+    const auto& field = mPuzzle.field();
+    for (auto itr = field.cbegin(); itr != field.cend(); ++itr) {
+        put( *itr );
+    }
+    const PuzzleN::move_t& m = mPuzzle.aboutMove();
+    putSigned( m.i );
+    putSigned( m.firstClick.x );
+    putSigned( m.firstClick.y );
+    putSigned( m.shift.x );
+    putSigned( m.shift.y );
+    putSigned( m.emptyClickShift.x );
+    putSigned( m.emptyClickShift.y );
+}
+
+
+} // puzzlen
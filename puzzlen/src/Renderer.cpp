@@ -0,0 +1,189 @@
+#include "../include/stdafx.h"
+#include "../include/Renderer.h"
+#include "../include/Instrument.h"
+
+
+namespace puzzlen {
+
+
+namespace {
+
+
+// Цифры 3 x 5: строка глифа - 3 младших бита, старший слева.
+static const uint8_t DIGIT[ 10 ][ 5 ] = {
+    { 7, 5, 5, 5, 7 },
+    { 2, 6, 2, 2, 7 },
+    { 7, 1, 7, 4, 7 },
+    { 7, 1, 7, 1, 7 },
+    { 5, 5, 7, 1, 1 },
+    { 7, 4, 7, 1, 7 },
+    { 7, 4, 7, 5, 7 },
+    { 7, 1, 1, 1, 1 },
+    { 7, 5, 7, 5, 7 },
+    { 7, 5, 7, 1, 7 }
+};
+
+
+} // namespace
+
+
+
+
+const Framebuffer::pixel_t  Renderer::BACKGROUND;
+const Framebuffer::pixel_t  Renderer::TILE;
+const Framebuffer::pixel_t  Renderer::BORDER;
+const Framebuffer::pixel_t  Renderer::TEXT;
+
+
+
+
+Renderer::Renderer( const PuzzleN& puzzle ) :
+    mPuzzle( puzzle ),
+    mAtlas( puzzle.N * puzzle.cellSize,  puzzle.M * puzzle.cellSize,  BACKGROUND )
+{
+    prepareAtlas();
+}
+
+
+
+
+Renderer::Renderer( const PuzzleN& puzzle,  const Framebuffer& atlas ) :
+    mPuzzle( puzzle ),
+    mAtlas( atlas )
+{
+    if ( (mAtlas.width() != puzzle.N * puzzle.cellSize)
+      || (mAtlas.height() != puzzle.M * puzzle.cellSize)
+    ) {
+        throw Exception( "Size of atlas must be equal to size of field." );
+    }
+}
+
+
+
+
+Renderer::~Renderer() {
+}
+
+
+
+
+size_t
+Renderer::draw( Framebuffer& frame,  const PuzzleN::damage_t& damage ) const {
+
+    PUZZLEN_PROBE( RENDER )
+
+    size_t touched = 0;
+    for (auto itr = damage.cbegin(); itr != damage.cend(); ++itr) {
+        touched += drawRegion( frame, *itr );
+    }
+
+    return touched;
+}
+
+
+
+
+size_t
+Renderer::drawAll( Framebuffer& frame ) const {
+
+    PUZZLEN_PROBE( RENDER )
+
+    return drawRegion( frame, frame.bounds() );
+}
+
+
+
+
+size_t
+Renderer::drawRegion( Framebuffer& frame,  const Framebuffer::rect_t& region ) const {
+
+    const Framebuffer::rect_t  clip = Framebuffer::intersect( region, frame.bounds() );
+    if ( Framebuffer::empty( clip ) ) {
+        return 0;
+    }
+    size_t touched = frame.fill( clip, BACKGROUND );
+
+    // # Смещённый элемент заходит в соседнюю ячейку: смотрим на ячейку
+    //   дальше области с каждой стороны.
+    const int cs = static_cast< int >( mPuzzle.cellSize );
+    const int x0 = std::max( clip.left / cs - 1,  0 );
+    const int y0 = std::max( clip.top / cs - 1,  0 );
+    const int x1 = std::min( (clip.right - 1) / cs + 1,  static_cast< int >( mPuzzle.N ) - 1 );
+    const int y1 = std::min( (clip.bottom - 1) / cs + 1,  static_cast< int >( mPuzzle.M ) - 1 );
+    const auto& field = mPuzzle.field();
+    for (int y = y0; y <= y1; ++y) {
+        for (int x = x0; x <= x1; ++x) {
+            const int i = mPuzzle.ic( x, y );
+            const PuzzleN::element_t element = field[ i ];
+            if (element == PuzzleN::EMPTY_ELEMENT) {
+                continue;
+            }
+            const PuzzleN::logicCoord_t  source =
+                mPuzzle.ci( static_cast< int >( element ) - 1 );
+            touched += frame.copy(
+                mAtlas,  source.x * cs,  source.y * cs,
+                mPuzzle.visualRect( i ),  clip
+            );
+        }
+    }
+
+    return touched;
+}
+
+
+
+
+void
+Renderer::prepareAtlas() {
+
+    const int cs = static_cast< int >( mPuzzle.cellSize );
+    const PuzzleN::element_t count = mPuzzle.N * mPuzzle.M;
+    for (PuzzleN::element_t element = 1; element < count; ++element) {
+        const PuzzleN::logicCoord_t  lc = mPuzzle.ci( static_cast< int >( element ) - 1 );
+        const int x = lc.x * cs;
+        const int y = lc.y * cs;
+        const Framebuffer::rect_t  outer = { x,  y,  x + cs,  y + cs };
+        const Framebuffer::rect_t  inner = { x + 1,  y + 1,  x + cs - 1,  y + cs - 1 };
+        mAtlas.fill( outer, BORDER );
+        mAtlas.fill( inner, TILE );
+        drawNumber( element, x, y );
+    }
+}
+
+
+
+
+void
+Renderer::drawNumber( PuzzleN::element_t element,  int x,  int y ) {
+
+    const int cs = static_cast< int >( mPuzzle.cellSize );
+    const int scale = std::max( cs / 12,  1 );
+
+    std::ostringstream  ss;
+    ss << element;
+    const std::string  digits = ss.str();
+
+    // глиф 3 x 5 и промежуток в 1 точку
+    const int width  = static_cast< int >( digits.size() ) * 4 * scale - scale;
+    const int height = 5 * scale;
+    int gx = x + (cs - width) / 2;
+    const int gy = y + (cs - height) / 2;
+    for (auto itr = digits.cbegin(); itr != digits.cend(); ++itr) {
+        const uint8_t* glyph = DIGIT[ *itr - '0' ];
+        for (int row = 0; row < 5; ++row) {
+            for (int column = 0; column < 3; ++column) {
+                if ( (glyph[ row ] >> (2 - column)) & 1 ) {
+                    const Framebuffer::rect_t  dot = {
+                        gx + column * scale,  gy + row * scale,
+                        gx + (column + 1) * scale,  gy + (row + 1) * scale
+                    };
+                    mAtlas.fill( dot, TEXT );
+                }
+            }
+        }
+        gx += 4 * scale;
+    }
+}
+
+
+} // puzzlen
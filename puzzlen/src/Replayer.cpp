@@ -0,0 +1,273 @@
+#include "../include/stdafx.h"
+#include "../include/Replayer.h"
+#include <cstring>
+#include <fstream>
+
+
+namespace puzzlen {
+
+
+namespace {
+
+
+// Чтение чисел записи.
+// # Выход за конец данных - исключение: запись могла оборваться.
+class Cursor {
+public:
+    Cursor( const uint8_t* data, size_t size, size_t at ) :
+        mData( data ), mSize( size ), mAt( at )
+    {
+    }
+
+
+    inline bool end() const { return mAt >= mSize; }
+
+    inline size_t at() const { return mAt; }
+
+
+    inline uint8_t byte() {
+        if (mAt >= mSize) {
+            throw Exception( "Recording is truncated." );
+        }
+        return mData[ mAt++ ];
+    }
+
+
+    inline uint64_t get() {
+        uint64_t v = 0;
+        for (int s = 0; ; s += 7) {
+            const uint8_t b = byte();
+            if (s > 63) {
+                throw Exception( "Recording is damaged." );
+            }
+            v |= static_cast< uint64_t >( b & 0x7F ) << s;
+            if ((b & 0x80) == 0) {
+                return v;
+            }
+        }
+    }
+
+
+    inline int64_t getSigned() {
+        const uint64_t v = get();
+        return static_cast< int64_t >( v >> 1 ) ^ -static_cast< int64_t >( v & 1 );
+    }
+
+
+    inline int getInt() { return static_cast< int >( getSigned() ); }
+
+
+    // # Поле - перестановка элементов 0 .. cells - 1, иначе запись
+    //   повреждена: PuzzleN::field() не должен её проверять.
+    void getField( PuzzleN::field_t& field, size_t cells ) {
+        field.resize( cells );
+        std::vector< bool >  seen( cells, false );
+        for (size_t i = 0; i < cells; ++i) {
+            const uint64_t e = get();
+            if ( (e >= cells) || seen[ e ] ) {
+                throw Exception( "Recording is damaged." );
+            }
+            seen[ e ] = true;
+            field[ i ] = static_cast< PuzzleN::element_t >( e );
+        }
+    }
+
+
+private:
+    const uint8_t*  mData;
+    size_t  mSize;
+    size_t  mAt;
+};
+
+
+} // namespace
+
+
+
+
+Replayer::Replayer( const std::vector< uint8_t >& data ) :
+    N( 0 ), M( 0 ), cellSize( 0 ),
+    mData( data ),
+    mBegin( 0 ),
+    mEnd( 0 ),
+    mFinished( false ),
+    mFinalMove(),
+    mEvents( 0 ),
+    mDuration( 0 )
+{
+    const size_t head = sizeof( Recorder::MAGIC ) + 1;
+    if ( (mData.size() < head)
+      || (std::memcmp( mData.data(), Recorder::MAGIC, sizeof( Recorder::MAGIC ) ) != 0)
+    ) {
+        throw Exception( "File is not a recording." );
+    }
+    const uint8_t version = mData[ head - 1 ];
+    if ( (version < 1) || (version > Recorder::FORMAT_VERSION) ) {
+        throw Exception( "Recording has unsupported version." );
+    }
+
+    Cursor  c( mData.data(), mData.size(), head );
+    N = static_cast< size_t >( c.get() );
+    M = static_cast< size_t >( c.get() );
+    cellSize = static_cast< size_t >( c.get() );
+    // # Размер ячейки - тот, что принимает PuzzleN.
+    if ( (N < 2) || (M < 2) || (N * M > 0xFFFF) || (cellSize < 10) || (cellSize > 100) ) {
+        throw Exception( "Recording is damaged." );
+    }
+    c.getField( mInitial, N * M );
+    mBegin = c.at();
+
+    // # Проверяем события сразу: replay() их уже не проверяет.
+    while ( !c.end() ) {
+        const size_t at = c.at();
+        const uint8_t type = c.byte();
+        mDuration += c.get();
+        switch ( type ) {
+            case Recorder::PRESS:
+            case Recorder::MOVE:
+                c.get();
+                c.get();
+                break;
+
+            case Recorder::RELEASE:
+                break;
+
+            // # В версии 1 отмены ходов не было.
+            case Recorder::UNDO:
+            case Recorder::REDO:
+                if (version < 2) {
+                    throw Exception( "Recording is damaged." );
+                }
+                break;
+
+            case Recorder::SHUFFLE:
+                c.get();
+                break;
+
+            case Recorder::END:
+                mEnd = at;
+                c.getField( mFinalField, N * M );
+                mFinalMove.i = c.getInt();
+                mFinalMove.firstClick.x = c.getInt();
+                mFinalMove.firstClick.y = c.getInt();
+                mFinalMove.shift.x = c.getInt();
+                mFinalMove.shift.y = c.getInt();
+                mFinalMove.emptyClickShift.x = c.getInt();
+                mFinalMove.emptyClickShift.y = c.getInt();
+                mFinished = true;
+                if ( !c.end() ) {
+                    throw Exception( "Recording has data after its end." );
+                }
+                return;
+
+            default:
+                throw Exception( "Recording is damaged." );
+        }
+        ++mEvents;
+    }
+    mEnd = c.at();
+}
+
+
+
+
+Replayer::~Replayer() {
+}
+
+
+
+
+std::vector< uint8_t >
+Replayer::load( const std::string& file ) {
+
+    std::ifstream  fs( file.c_str(), std::ios::binary );
+    if ( !fs.is_open() ) {
+        throw Exception( "File " + file + " is not found." );
+    }
+
+    return std::vector< uint8_t >(
+        (std::istreambuf_iterator< char >( fs )),
+        std::istreambuf_iterator< char >()
+    );
+}
+
+
+
+
+size_t
+Replayer::replay( PuzzleN& puzzle ) const {
+
+    if ( (puzzle.N != N) || (puzzle.M != M) || (puzzle.cellSize != cellSize) ) {
+        throw Exception( "Recording is made for another size of puzzle." );
+    }
+    puzzle.field( mInitial );
+    puzzle.pressMouseButton( false );
+
+    // # Так же, как wndProc().
+    Cursor  c( mData.data(), mEnd, mBegin );
+    int x = 0;
+    int y = 0;
+    size_t count = 0;
+    while ( !c.end() ) {
+        const uint8_t type = c.byte();
+        c.get();
+        switch ( type ) {
+            case Recorder::PRESS:
+                x = c.getInt();
+                y = c.getInt();
+                puzzle.pressMouseButton( true );
+                puzzle.firstClick( x, y );
+                break;
+
+            case Recorder::MOVE:
+                x += c.getInt();
+                y += c.getInt();
+                puzzle.move( x, y );
+                break;
+
+            case Recorder::RELEASE:
+                puzzle.pressMouseButton( false );
+                puzzle.stickMove();
+                puzzle.resetFirstClick();
+                break;
+
+            case Recorder::SHUFFLE:
+                puzzle.shuffle( c.get() );
+                break;
+
+            case Recorder::UNDO:
+                puzzle.undo();
+                break;
+
+            case Recorder::REDO:
+                puzzle.redo();
+                break;
+        }
+        ++count;
+    }
+
+    return count;
+}
+
+
+
+
+bool
+Replayer::verify( const PuzzleN& puzzle ) const {
+
+    if ( !mFinished ) {
+        return false;
+    }
+    const PuzzleN::move_t& m = puzzle.aboutMove();
+    return (puzzle.field() == mFinalField)
+        && (m.i == mFinalMove.i)
+        && (m.firstClick.x == mFinalMove.firstClick.x)
+        && (m.firstClick.y == mFinalMove.firstClick.y)
+        && (m.shift.x == mFinalMove.shift.x)
+        && (m.shift.y == mFinalMove.shift.y)
+        && (m.emptyClickShift.x == mFinalMove.emptyClickShift.x)
+        && (m.emptyClickShift.y == mFinalMove.emptyClickShift.y);
+}
+
+
+} // puzzlen
@@ -0,0 +1,126 @@
+#include "../include/stdafx.h"
+#include "../include/Sessions.h"
+
+
+namespace puzzlen {
+
+
+Sessions::Sessions( size_t shards ) :
+    mNext( 0 ),
+    mSize( 0 )
+{
+    const size_t count = (shards == 0) ? SESSION_SHARDS : shards;
+    for (size_t s = 0; s < count; ++s) {
+        mShards.emplace_back( new shard_t() );
+    }
+}
+
+
+
+
+Sessions::~Sessions() {
+
+    for (auto itr = mShards.begin(); itr != mShards.end(); ++itr) {
+        for (auto& slab : (*itr)->slabs) {
+            for (size_t i = 0; i < SESSION_SLAB; ++i) {
+                if ( slab[ i ].built ) {
+                    puzzle( slab[ i ] ).~PuzzleN();
+                }
+            }
+        }
+    }
+}
+
+
+
+
+Sessions::id_t
+Sessions::open( size_t n,  size_t m,  uint64_t seed ) {
+
+    if ( (n < 2) || (m < 2) || (n > SESSION_MAX_SIDE) || (m > SESSION_MAX_SIDE) ) {
+        throw Exception(
+            "Width and height of session puzzle must have diapason [2; " +
+            std::to_string( SESSION_MAX_SIDE ) + "]."
+        );
+    }
+
+    const size_t s = mNext.fetch_add( 1, std::memory_order_relaxed ) % mShards.size();
+    shard_t& shard = *mShards[ s ];
+    std::lock_guard< std::mutex >  lock( shard.mutex );
+
+    if ( shard.free.empty() ) {
+        // # Номер ячейки среди всех шардов должен уместиться в 32 бита.
+        const size_t slots = (shard.slabs.size() + 1) * SESSION_SLAB;
+        if (slots > 0xFFFFFFFFULL / mShards.size()) {
+            throw Exception( "Too many sessions are open." );
+        }
+        shard.slabs.emplace_back( new slot_t[ SESSION_SLAB ]() );
+        shard.free.reserve( slots );
+        for (size_t i = slots; i > slots - SESSION_SLAB; --i) {
+            shard.free.push_back( static_cast< uint32_t >( i - 1 ) );
+        }
+    }
+
+    // # Ячейку забираем из свободных, только когда поле построено:
+    //   при нехватке памяти она остаётся свободной.
+    const uint32_t index = shard.free.back();
+    slot_t& slot = shard.slabs[ index / SESSION_SLAB ][ index % SESSION_SLAB ];
+    if ( slot.built && ((puzzle( slot ).N != n) || (puzzle( slot ).M != m)) ) {
+        puzzle( slot ).~PuzzleN();
+        slot.built = false;
+    }
+    if ( !slot.built ) {
+        new ( &slot.storage ) PuzzleN( n, m, CELL_SIZE );
+        slot.built = true;
+    }
+    puzzle( slot ).shuffle( seed );
+    shard.free.pop_back();
+
+    ++slot.generation;
+    slot.open = true;
+    mSize.fetch_add( 1, std::memory_order_relaxed );
+
+    const uint64_t global = static_cast< uint64_t >( index ) * mShards.size() + s;
+    return (static_cast< uint64_t >( slot.generation ) << 32) | global;
+}
+
+
+
+
+bool
+Sessions::close( id_t id ) {
+
+    shard_t& shard = shardOf( id );
+    std::lock_guard< std::mutex >  lock( shard.mutex );
+    slot_t* slot = find( shard, id );
+    if ( !slot ) {
+        return false;
+    }
+    slot->open = false;
+    shard.free.push_back(
+        static_cast< uint32_t >( static_cast< uint32_t >( id ) / mShards.size() )
+    );
+    mSize.fetch_sub( 1, std::memory_order_relaxed );
+
+    return true;
+}
+
+
+
+
+Sessions::slot_t*
+Sessions::find( shard_t& shard,  id_t id ) {
+
+    const size_t index = static_cast< uint32_t >( id ) / mShards.size();
+    if (index >= shard.slabs.size() * SESSION_SLAB) {
+        return nullptr;
+    }
+    slot_t& slot = shard.slabs[ index / SESSION_SLAB ][ index % SESSION_SLAB ];
+    if ( !slot.open || (slot.generation != static_cast< uint32_t >( id >> 32 )) ) {
+        return nullptr;
+    }
+    return &slot;
+}
+
+
+} // puzzlen
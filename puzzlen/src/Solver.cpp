@@ -0,0 +1,349 @@
+#include "../include/stdafx.h"
+#include "../include/Solver.h"
+#include "../include/Heuristic.h"
+#include "../include/Instrument.h"
+#include "../include/Search.h"
+
+
+namespace puzzlen {
+
+
+const char* const  Solver::HEURISTIC_NAME[] = {
+    "conflict",
+    "walking"
+};
+
+
+const size_t Solver::TASKS_PER_THREAD;
+const size_t Solver::MAX_SPLIT_DEPTH;
+
+
+
+
+Solver::Solver( size_t n, size_t m ) :
+    N( n ), M( m ),
+    mGeometry( n, m )
+{
+}
+
+
+
+
+Solver::~Solver() {
+}
+
+
+
+
+void
+Solver::patterns( const std::shared_ptr< const Patterns >& patterns ) {
+
+    if ( patterns && ((patterns->N != N) || (patterns->M != M)) ) {
+        throw Exception( "Pattern database is built for another size of puzzle." );
+    }
+    mPatterns = patterns;
+}
+
+
+
+
+Solver::heuristic_t
+Solver::heuristicByName( const std::string& name ) {
+
+    for (size_t k = 0; k <= WALKING; ++k) {
+        if (name == HEURISTIC_NAME[ k ]) {
+            return static_cast< heuristic_t >( k );
+        }
+    }
+    throw Exception( "Unknown heuristic " + name + "." );
+}
+
+
+
+
+void
+Solver::heuristic( heuristic_t h ) {
+
+    mWalking = (h == WALKING) ?
+        std::make_shared< const Walking >( mGeometry ) :
+        std::shared_ptr< const Walking >();
+}
+
+
+
+
+void
+Solver::bidirectional( size_t budget ) {
+
+    mPerimeter = (budget > 0) ?
+        std::make_shared< const Perimeter >( mGeometry, budget ) :
+        std::shared_ptr< const Perimeter >();
+}
+
+
+
+
+Solver::result_t
+Solver::solve( const PuzzleN::field_t& field ) const {
+
+    PUZZLEN_PROBE( SOLVE )
+
+    if ( !PuzzleN::solvable( field, N, M ) ) {
+        throw Exception( "Puzzle is not solvable." );
+    }
+
+    if ( mPatterns ) {
+        return solve( PatternHeuristic( mGeometry, *mPatterns ), field );
+    }
+    if ( mWalking ) {
+        return solve( WalkingHeuristic( *mWalking ), field );
+    }
+    return solve( ConflictHeuristic( mGeometry ), field );
+}
+
+
+
+
+template< class H >
+Solver::result_t
+Solver::solve( const H& heuristic, const PuzzleN::field_t& field ) const {
+
+    if ( mPool ) {
+        return solveParallel( heuristic, field );
+    }
+
+    Search< H >  search( mGeometry, heuristic );
+    search.perimeter( mPerimeter.get() );
+    search.reset( field );
+
+    const auto start = std::chrono::steady_clock::now();
+    for (int bound = search.estimate(); ; ) {
+        const int t = search.iterate( bound );
+        if (t == Search< H >::FOUND) {
+            break;
+        }
+        bound = t;
+    }
+    const auto finish = std::chrono::steady_clock::now();
+
+    result_t  result;
+    result.moves   = search.moves();
+    result.nodes   = search.nodes();
+    result.seconds = std::chrono::duration< double >( finish - start ).count();
+
+    return result;
+}
+
+
+
+
+template< class H >
+Solver::result_t
+Solver::solveParallel( const H& heuristic, const PuzzleN::field_t& field ) const {
+
+    ThreadPool& pool = *mPool;
+    const auto start = std::chrono::steady_clock::now();
+
+    int blank = 0;
+    for (size_t i = 0; i < field.size(); ++i) {
+        if (field[ i ] == PuzzleN::EMPTY_ELEMENT) {
+            blank = static_cast< int >( i );
+        }
+    }
+    const auto prefixes = split( blank, pool.size() * TASKS_PER_THREAD );
+    const int depth = static_cast< int >( prefixes.front().size() );
+
+    result_t  result;
+
+    // # Решения короче 'depth' в поддеревья не попадут. Порог IDA* не
+    //   перескакивает длину решения, поэтому такие решения найдутся на
+    //   порогах меньше 'depth': их проходим в вызывающем потоке.
+    Search< H >  search( mGeometry, heuristic );
+    search.perimeter( mPerimeter.get() );
+    search.reset( field );
+    int bound = search.estimate();
+    while (bound < depth) {
+        const int t = search.iterate( bound );
+        if (t == Search< H >::FOUND) {
+            result.moves = search.moves();
+            break;
+        }
+        bound = t;
+    }
+    result.nodes = search.nodes();
+
+    std::vector< std::unique_ptr< Search< H > > >  searches;
+    std::atomic< bool >  found( !result.moves.empty() || (bound == 0) );
+    for (size_t k = 0; k < pool.size(); ++k) {
+        searches.push_back( std::unique_ptr< Search< H > >(
+            new Search< H >( mGeometry, heuristic )
+        ) );
+        searches.back()->stop( &found );
+        searches.back()->perimeter( mPerimeter.get() );
+    }
+
+    std::mutex  mutex;
+    while ( !found ) {
+        // # Порог общий для всех поддеревьев. Следующий - наименьшая из
+        //   оценок, вышедших за него во всех поддеревьях.
+        std::atomic< int >  next( Search< H >::INFINITE_COST );
+        std::atomic< uint64_t >  nodes( 0 );
+        for (auto itr = prefixes.cbegin(); itr != prefixes.cend(); ++itr) {
+            const std::string& prefix = *itr;
+            pool.submit( [ &, bound ] ( size_t worker ) {
+                if ( found.load( std::memory_order_relaxed ) ) {
+                    return;
+                }
+                Search< H >&  s = *searches[ worker ];
+                s.reset( field );
+                for (auto c = prefix.cbegin(); c != prefix.cend(); ++c) {
+                    s.push( *c );
+                }
+                const int t = s.iterate( bound );
+                nodes += s.nodes();
+                if (t == Search< H >::FOUND) {
+                    // # Все решения короче порога исключены прошлыми
+                    //   проходами: любое найденное оптимально.
+                    std::lock_guard< std::mutex >  lock( mutex );
+                    if ( !found ) {
+                        result.moves = s.moves();
+                        found = true;
+                    }
+                    return;
+                }
+                for (int v = next.load(); (t < v) && !next.compare_exchange_weak( v, t ); ) {
+                }
+            } );
+        }
+        pool.wait();
+
+        result.nodes += nodes;
+        bound = next;
+    }
+
+    const auto finish = std::chrono::steady_clock::now();
+    result.seconds = std::chrono::duration< double >( finish - start ).count();
+
+    return result;
+}
+
+
+
+
+bool
+Solver::solve(
+    const PuzzleN::field_t& field,  int bound,  uint64_t limit,  result_t& result
+) const {
+    PUZZLEN_PROBE( SOLVE )
+
+    if ( !PuzzleN::solvable( field, N, M ) ) {
+        throw Exception( "Puzzle is not solvable." );
+    }
+
+    if ( mPatterns ) {
+        return solve( PatternHeuristic( mGeometry, *mPatterns ), field, bound, limit, result );
+    }
+    if ( mWalking ) {
+        return solve( WalkingHeuristic( *mWalking ), field, bound, limit, result );
+    }
+    return solve( ConflictHeuristic( mGeometry ), field, bound, limit, result );
+}
+
+
+
+
+template< class H >
+bool
+Solver::solve(
+    const H& heuristic,  const PuzzleN::field_t& field,  int bound,  uint64_t limit,
+    result_t& result
+) const {
+    Search< H >  search( mGeometry, heuristic );
+    search.perimeter( mPerimeter.get() );
+    search.limit( limit );
+    search.reset( field );
+
+    const auto start = std::chrono::steady_clock::now();
+    bool found = false;
+    for (int b = search.estimate(); (b <= bound) && (search.nodes() <= limit); ) {
+        const int t = search.iterate( b );
+        if (t == Search< H >::FOUND) {
+            found = true;
+            break;
+        }
+        b = t;
+    }
+    const auto finish = std::chrono::steady_clock::now();
+
+    result.moves   = found ? search.moves() : std::string();
+    result.nodes   = search.nodes();
+    result.seconds = std::chrono::duration< double >( finish - start ).count();
+
+    return found;
+}
+
+
+
+
+std::vector< std::string >
+Solver::split( int blank, size_t count ) const {
+
+    typedef struct {
+        std::string  path;
+        int  blank;
+    } node_t;
+
+    std::vector< node_t >  layer( 1 );
+    layer.front().blank = blank;
+    while ( (layer.size() < count) && (layer.front().path.size() < MAX_SPLIT_DEPTH) ) {
+        std::vector< node_t >  deeper;
+        deeper.reserve( layer.size() * 3 );
+        for (auto itr = layer.cbegin(); itr != layer.cend(); ++itr) {
+            const int prev = itr->path.empty() ? -1 : itr->path.back();
+            for (int d = 0; d < 4; ++d) {
+                const int from = mGeometry.source( itr->blank, d );
+                if ( (from < 0) || (d == (prev ^ 1)) ) {
+                    continue;
+                }
+                node_t  node;
+                node.path  = itr->path + static_cast< char >( d );
+                node.blank = from;
+                deeper.push_back( node );
+            }
+        }
+        layer.swap( deeper );
+    }
+
+    std::vector< std::string >  prefixes;
+    prefixes.reserve( layer.size() );
+    for (auto itr = layer.cbegin(); itr != layer.cend(); ++itr) {
+        prefixes.push_back( itr->path );
+    }
+
+    return prefixes;
+}
+
+
+
+
+int
+Solver::estimate( const PuzzleN::field_t& field ) const {
+
+    if ( mPatterns ) {
+        Search< PatternHeuristic >
+            search( mGeometry, PatternHeuristic( mGeometry, *mPatterns ) );
+        search.reset( field );
+        return search.estimate();
+    }
+    if ( mWalking ) {
+        Search< WalkingHeuristic >  search( mGeometry, WalkingHeuristic( *mWalking ) );
+        search.reset( field );
+        return search.estimate();
+    }
+    Search< ConflictHeuristic >  search( mGeometry, ConflictHeuristic( mGeometry ) );
+    search.reset( field );
+    return search.estimate();
+}
+
+
+} // puzzlen
@@ -0,0 +1,165 @@
+#include "../include/stdafx.h"
+#include "../include/ThreadPool.h"
+
+
+namespace puzzlen {
+
+
+namespace {
+
+
+// пул и номер потока, в котором выполняется вызов
+thread_local const ThreadPool*  currentPool = nullptr;
+thread_local size_t  currentWorker = 0;
+
+
+} // namespace
+
+
+
+
+ThreadPool::ThreadPool( size_t threads ) :
+    mQueued( 0 ),
+    mPending( 0 ),
+    mStop( false ),
+    mNext( 0 ),
+    mSteals( 0 )
+{
+    if (threads == 0) {
+        threads = std::max( std::thread::hardware_concurrency(), 1u );
+    }
+
+    for (size_t k = 0; k < threads; ++k) {
+        mQueues.push_back( std::unique_ptr< queue_t >( new queue_t() ) );
+    }
+    mThreads.reserve( threads );
+    for (size_t k = 0; k < threads; ++k) {
+        mThreads.push_back( std::thread( &ThreadPool::run, this, k ) );
+    }
+}
+
+
+
+
+ThreadPool::~ThreadPool() {
+
+    {
+        std::lock_guard< std::mutex >  lock( mMutex );
+        mStop = true;
+    }
+    mWake.notify_all();
+    for (auto itr = mThreads.begin(); itr != mThreads.end(); ++itr) {
+        itr->join();
+    }
+}
+
+
+
+
+void
+ThreadPool::submit( const task_t& task ) {
+
+    size_t worker = current();
+    if (worker == size()) {
+        worker = mNext++ % size();
+    }
+    // # Счётчики - до очереди: иначе задачу могут взять и выполнить
+    //   раньше, чем её учли, и mQueued / mPending уйдут ниже нуля.
+    {
+        std::lock_guard< std::mutex >  lock( mMutex );
+        ++mQueued;
+        ++mPending;
+    }
+    {
+        std::lock_guard< std::mutex >  lock( mQueues[ worker ]->mutex );
+        mQueues[ worker ]->tasks.push_back( task );
+    }
+    mWake.notify_one();
+}
+
+
+
+
+void
+ThreadPool::wait() {
+
+    std::unique_lock< std::mutex >  lock( mMutex );
+    mDone.wait( lock, [ this ] () { return mPending == 0; } );
+}
+
+
+
+
+void
+ThreadPool::run( size_t worker ) {
+
+    currentPool = this;
+    currentWorker = worker;
+
+    for ( ; ; ) {
+        task_t  task;
+        if ( !take( worker, task ) ) {
+            std::unique_lock< std::mutex >  lock( mMutex );
+            mWake.wait( lock, [ this ] () { return mStop || (mQueued > 0); } );
+            if ( mStop && (mQueued == 0) ) {
+                return;
+            }
+            continue;
+        }
+
+        task( worker );
+
+        std::lock_guard< std::mutex >  lock( mMutex );
+        if (--mPending == 0) {
+            mDone.notify_all();
+        }
+    }
+}
+
+
+
+
+bool
+ThreadPool::take( size_t worker, task_t& task ) {
+
+    bool taken = false;
+    {
+        queue_t& own = *mQueues[ worker ];
+        std::lock_guard< std::mutex >  lock( own.mutex );
+        if ( !own.tasks.empty() ) {
+            task = own.tasks.back();
+            own.tasks.pop_back();
+            taken = true;
+        }
+    }
+
+    for (size_t k = 1; !taken && (k < size()); ++k) {
+        queue_t& other = *mQueues[ (worker + k) % size() ];
+        std::lock_guard< std::mutex >  lock( other.mutex );
+        if ( !other.tasks.empty() ) {
+            task = other.tasks.front();
+            other.tasks.pop_front();
+            taken = true;
+            ++mSteals;
+        }
+    }
+
+    if ( taken ) {
+        std::lock_guard< std::mutex >  lock( mMutex );
+        --mQueued;
+    }
+
+    return taken;
+}
+
+
+
+
+size_t
+ThreadPool::current() const {
+
+    return (currentPool == this) ? currentWorker : size();
+}
+
+
+} // puzzlen
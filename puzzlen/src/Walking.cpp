@@ -0,0 +1,164 @@
+#include "../include/stdafx.h"
+#include "../include/Walking.h"
+
+
+namespace puzzlen {
+
+
+const Walking::id_t  Walking::NONE;
+const size_t  Walking::NARROW_STATES;
+
+
+
+
+Walking::Walking( const Geometry& geometry ) :
+    mGeometry( geometry )
+{
+    // # Строки: M линий по N ячеек, столбцы: N линий по M ячеек.
+    mRows = build( geometry.M, geometry.N );
+    mColumns = mRows;
+    if (geometry.N != geometry.M) {
+        mColumns = build( geometry.N, geometry.M );
+    }
+}
+
+
+
+
+Walking::~Walking() {
+}
+
+
+
+
+Walking::id_t
+Walking::rowId( const uint8_t* tiles ) const {
+
+    const auto& g = mGeometry;
+    return id( *mRows, tiles, [ &g ] ( int i ) { return g.row( i ); } );
+}
+
+
+
+
+Walking::id_t
+Walking::columnId( const uint8_t* tiles ) const {
+
+    const auto& g = mGeometry;
+    return id( *mColumns, tiles, [ &g ] ( int i ) { return g.column( i ); } );
+}
+
+
+
+
+size_t
+Walking::bytes() const {
+
+    const auto table = [] ( const table_t& t ) {
+        return t.distance.size() * sizeof( uint8_t ) +
+            t.next16.size() * sizeof( uint16_t ) + t.next32.size() * sizeof( id_t );
+    };
+    return table( *mRows ) + ((mColumns != mRows) ? table( *mColumns ) : 0);
+}
+
+
+
+
+std::unique_ptr< Walking::table_t >
+Walking::build( size_t lines,  size_t cells ) {
+
+    std::unique_ptr< table_t >  t( new table_t );
+    t->lines = lines;
+    t->cells = cells;
+
+    typedef std::vector< uint8_t >  matrix_t;
+
+    // собранное поле: все элементы на своих линиях
+    matrix_t  goal( lines * lines, 0 );
+    for (size_t l = 0; l < lines; ++l) {
+        goal[ l * lines + l ] = static_cast< uint8_t >( (l + 1 < lines) ? cells : (cells - 1) );
+    }
+
+    // # Поиск в ширину: матрицы нумеруются в порядке обхода.
+    std::vector< matrix_t >  matrices;
+    matrices.push_back( goal );
+    t->index[ goal ] = 0;
+    t->distance.push_back( 0 );
+    for (size_t k = 0; k < matrices.size(); ++k) {
+        // # Линия с пустой ячейкой - та, где элементов на один меньше.
+        size_t blank = 0;
+        for (size_t l = 0; l < lines; ++l) {
+            size_t sum = 0;
+            for (size_t g = 0; g < lines; ++g) {
+                sum += matrices[ k ][ l * lines + g ];
+            }
+            if (sum < cells) {
+                blank = l;
+            }
+        }
+
+        t->next32.resize( (k + 1) * 2 * lines, NONE );
+        for (size_t from = 0; from < 2; ++from) {
+            if ( ((from == 0) && (blank == 0)) || ((from == 1) && (blank + 1 == lines)) ) {
+                continue;
+            }
+            const size_t source = (from == 0) ? (blank - 1) : (blank + 1);
+            for (size_t g = 0; g < lines; ++g) {
+                if (matrices[ k ][ source * lines + g ] == 0) {
+                    continue;
+                }
+                matrix_t  m = matrices[ k ];
+                --m[ source * lines + g ];
+                ++m[ blank * lines + g ];
+                auto itr = t->index.find( m );
+                if (itr == t->index.end()) {
+                    if (matrices.size() >= WALKING_MAX_STATES) {
+                        throw Exception( "Walking distance tables are too large for this puzzle." );
+                    }
+                    const id_t id = static_cast< id_t >( matrices.size() );
+                    itr = t->index.insert( std::make_pair( m, id ) ).first;
+                    matrices.push_back( m );
+                    t->distance.push_back( static_cast< uint8_t >( t->distance[ k ] + 1 ) );
+                }
+                t->next32[ (k * 2 + from) * lines + g ] = itr->second;
+            }
+        }
+    }
+
+    // # NONE в 16 битах - 0xFFFF: такого индекса нет.
+    t->narrow = (matrices.size() < NARROW_STATES);
+    if ( t->narrow ) {
+        t->next16.reserve( t->next32.size() );
+        for (const id_t id : t->next32) {
+            t->next16.push_back( static_cast< uint16_t >( id ) );
+        }
+        std::vector< id_t >().swap( t->next32 );
+    }
+
+    return t;
+}
+
+
+
+
+template< class F >
+Walking::id_t
+Walking::id( const table_t& t,  const uint8_t* tiles,  F line ) const {
+
+    std::vector< uint8_t >  m( t.lines * t.lines, 0 );
+    for (size_t i = 0; i < mGeometry.cells; ++i) {
+        if (tiles[ i ] == PuzzleN::EMPTY_ELEMENT) {
+            continue;
+        }
+        const int l = line( static_cast< int >( i ) );
+        const int g = line( mGeometry.goal( tiles[ i ] ) );
+        ++m[ l * t.lines + g ];
+    }
+    const auto itr = t.index.find( m );
+    DASSERT( itr != t.index.cend() );
+
+    return itr->second;
+}
+
+
+} // puzzlen